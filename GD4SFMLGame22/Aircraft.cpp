@@ -4,9 +4,8 @@
 
 #include "DataTables.hpp"
 
-#include <SFML/Graphics/RenderTarget.hpp>
-
 #include "Projectile.hpp"
+#include "RenderQueue.hpp"
 #include "ResourceHolder.hpp"
 #include "Utility.hpp"
 #include "DataTables.hpp"
@@ -22,7 +21,7 @@ namespace
 }
 
 
-Aircraft::Aircraft(AircraftType type, const TextureHolder& textures, const FontHolder& fonts)
+Aircraft::Aircraft(AircraftType type, const TextureHolder& textures, const FontHolder& fonts, const ParticleRegistry& particles)
 : Entity(Table[static_cast<int>(type)].m_hitpoints)
 , m_type(type)
 , m_sprite(textures.Get(Table[static_cast<int>(type)].m_texture), Table[static_cast<int>(type)].m_texture_rect)
@@ -43,6 +42,7 @@ Aircraft::Aircraft(AircraftType type, const TextureHolder& textures, const FontH
 , m_travelled_distance(0.f)
 , m_directions_index(0)
 , m_identifier(0)
+, m_particles(particles)
 {
 	m_explosion.SetFrameSize(sf::Vector2i(256, 256));
 	m_explosion.SetNumFrames(16);
@@ -96,15 +96,25 @@ void Aircraft::SetMissileAmmo(int ammo)
 	m_missile_ammo = ammo;
 }
 
-void Aircraft::DrawCurrent(sf::RenderTarget& target, sf::RenderStates states) const
+sf::FloatRect Aircraft::GetDrawBounds() const
+{
+	//A wreck shows its explosion, which is bigger than the aircraft
+	if(IsDestroyed() && m_show_explosion)
+	{
+		return GetWorldTransform().transformRect(m_explosion.GetGlobalBounds());
+	}
+	return GetBoundingRect();
+}
+
+void Aircraft::DrawCurrent(RenderQueue& queue, sf::RenderStates states) const
 {
 	if(IsDestroyed() && m_show_explosion)
 	{
-		target.draw(m_explosion, states);
+		queue.AddDrawable(m_explosion, states);
 	}
 	else
 	{
-		target.draw(m_sprite, states);
+		queue.AddSprite(m_sprite, states);
 	}
 }
 
@@ -185,8 +195,7 @@ void Aircraft::UpdateCurrent(sf::Time dt, CommandQueue& commands)
 		// Play explosion sound only once
 		if (!m_explosion_began)
 		{
-			SoundEffect soundEffect = (Utility::RandomInt(2) == 0) ? SoundEffect::kExplosion1 : SoundEffect::kExplosion2;
-			PlayLocalSound(commands, soundEffect);
+			PlayExplosionSound(commands);
 
 			//Emit network game action for enemy explodes
 			if(!IsAllied())
@@ -337,7 +346,7 @@ void Aircraft::CreateBullets(SceneNode& node, const TextureHolder& textures) con
 void Aircraft::CreateProjectile(SceneNode& node, ProjectileType type, float x_offset, float y_offset,
 	const TextureHolder& textures) const
 {
-	std::unique_ptr<Projectile> projectile(new Projectile(type, textures));
+	std::unique_ptr<Projectile> projectile(new Projectile(type, textures, m_particles));
 	sf::Vector2f offset(x_offset * m_sprite.getGlobalBounds().width, y_offset * m_sprite.getGlobalBounds().height);
 	sf::Vector2f velocity(0, projectile->GetMaxSpeed());
 
@@ -400,6 +409,24 @@ void Aircraft::UpdateRollAnimation()
 	}
 }
 
+void Aircraft::PlayExplosionSound(CommandQueue& commands)
+{
+	sf::Vector2f world_position = GetWorldPosition();
+
+	//The sound is picked when the command runs. Aircraft can be updated on several threads, and the random
+	//numbers have to be drawn in the same order whichever thread gets there first
+	Command command;
+	command.category = Category::kSoundEffect;
+	command.action = DerivedAction<SoundNode>(
+		[world_position](SoundNode& node, sf::Time)
+	{
+		SoundEffect effect = (Utility::RandomInt(2) == 0) ? SoundEffect::kExplosion1 : SoundEffect::kExplosion2;
+		node.PlaySound(effect, world_position);
+	});
+
+	commands.Push(command);
+}
+
 void Aircraft::PlayLocalSound(CommandQueue& commands, SoundEffect effect)
 {
 	sf::Vector2f world_position = GetWorldPosition();
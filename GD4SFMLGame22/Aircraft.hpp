@@ -10,11 +10,14 @@
 #include "ProjectileType.hpp"
 #include "TextNode.hpp"
 
+class ParticleRegistry;
+
 
 class Aircraft : public Entity
 {
 public:
-	Aircraft(AircraftType type, const TextureHolder& textures, const FontHolder& fonts);
+	//The missiles it launches leave trails in the particle nodes registered in particles
+	Aircraft(AircraftType type, const TextureHolder& textures, const FontHolder& fonts, const ParticleRegistry& particles);
 	unsigned int GetCategory() const override;
 
 	void DisablePickups();
@@ -35,13 +38,14 @@ public:
 	void CreateProjectile(SceneNode& node, ProjectileType type, float x_offset, float y_offset, const TextureHolder& textures) const;
 
 	sf::FloatRect GetBoundingRect() const override;
+	sf::FloatRect GetDrawBounds() const override;
 	bool IsMarkedForRemoval() const override;
 	void Remove() override;
 	void PlayLocalSound(CommandQueue& commands, SoundEffect effect);
 
 
 private:
-	void DrawCurrent(sf::RenderTarget& target, sf::RenderStates states) const override;
+	void DrawCurrent(RenderQueue& queue, sf::RenderStates states) const override;
 	void UpdateCurrent(sf::Time dt, CommandQueue& commands) override;
 	
 	void CheckProjectileLaunch(sf::Time dt, CommandQueue& commands);
@@ -49,6 +53,7 @@ private:
 	void CreatePickup(SceneNode& node, const TextureHolder& textures) const;
 	void CheckPickupDrop(CommandQueue& commands);
 	void UpdateRollAnimation();
+	void PlayExplosionSound(CommandQueue& commands);
 
 
 private:
@@ -82,5 +87,6 @@ private:
 	int m_directions_index;
 
 	int m_identifier;
+	const ParticleRegistry& m_particles;
 };
 
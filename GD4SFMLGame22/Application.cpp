@@ -1,5 +1,8 @@
 #include "Application.hpp"
 
+#include <algorithm>
+#include <iostream>
+
 #include "GameOverState.hpp"
 #include "State.hpp"
 #include "StateID.hpp"
@@ -9,29 +12,60 @@
 #include "PauseState.hpp"
 #include "SettingsState.hpp"
 #include "MultiplayerGameState.hpp"
+#include "World.hpp"
 
+namespace
+{
+	//After a long frame only this many steps are caught up, the rest of the time is dropped. Otherwise a machine
+	//that cannot keep up spends ever longer catching up and falls further behind
+	const std::size_t MaxUpdatesPerFrame = 5;
+	//Time each frame may spend turning decoded assets into textures and sound buffers while loading
+	const sf::Time AssetUploadBudget = sf::milliseconds(4);
+}
 
-const sf::Time Application::kTimePerFrame = sf::seconds(1.f / 60.f);
-
-Application::Application()
+Application::Application(const DemoSettings& demo_settings, const DebugSettings& debug_settings, unsigned int simulation_rate, std::size_t worker_threads, unsigned int target_frame_rate, bool cpu_bloom)
 :m_window(sf::VideoMode(1024, 768), "Network", sf::Style::Close)
 , m_key_binding_1(1)
 , m_key_binding_2(2)
-, m_stack(State::Context(m_window, m_textures, m_fonts, m_music, m_sounds, m_key_binding_1, m_key_binding_2))
+, m_demo_settings(demo_settings)
+, m_debug_settings(debug_settings)
+, m_jobs(worker_threads)
+, m_quality(target_frame_rate > 0 ? sf::seconds(1.f / target_frame_rate) : sf::Time::Zero, cpu_bloom)
+, m_assets(worker_threads)
+, m_stack(State::Context(m_window, m_textures, m_fonts, m_music, m_sounds, m_key_binding_1, m_key_binding_2, m_demo_settings, m_debug_settings, m_timing, m_jobs, m_quality, m_assets))
 , m_statistics_numframes(0)
+, m_statistics_numupdates(0)
+, m_time_per_update(sf::seconds(1.f / std::max(1u, simulation_rate)))
 {
 	m_window.setKeyRepeatEnabled(false);
 
+	//The title screen needs these straight away, everything else is loaded while it is up
 	m_fonts.Load(Fonts::Main, "Media/Fonts/Sansation.ttf");
 	m_textures.Load(Textures::kTitleScreen, "Media/Textures/TitleScreen.png");
-	m_textures.Load(Textures::kButtons, "Media/Textures/Buttons.png");
+	m_assets.LoadTexture(m_textures, Textures::kButtons, "Media/Textures/Buttons.png");
+	World::LoadTextures(m_assets, m_textures);
+	m_sounds.LoadBuffers(m_assets);
+	m_assets.Start();
 
 	m_statistics_text.setFont(m_fonts.Get(Fonts::Main));
 	m_statistics_text.setPosition(5.f, 5.f);
 	m_statistics_text.setCharacterSize(10u);
 
 	RegisterStates();
-	m_stack.PushState(StateID::kTitle);
+	if(m_demo_settings.m_playback_path.empty())
+	{
+		m_stack.PushState(StateID::kTitle);
+	}
+	else
+	{
+		//A demo starts playing straight away, so there is no title screen to load behind
+		m_assets.Finish();
+		m_stack.PushState(StateID::kDemoPlayback);
+	}
+	if(m_debug_settings.m_report_statistics)
+	{
+		std::cout << "Started in " << m_startup_clock.getElapsedTime().asMilliseconds() << "ms" << std::endl;
+	}
 }
 
 void Application::Run()
@@ -42,18 +76,31 @@ void Application::Run()
 	{
 		sf::Time elapsedTime = clock.restart();
 		time_since_last_update += elapsedTime;
+		UpdateLoading();
 
-		while (time_since_last_update > kTimePerFrame)
+		std::size_t updates = 0;
+		while (time_since_last_update >= m_time_per_update && updates < MaxUpdatesPerFrame)
 		{
-			time_since_last_update -= kTimePerFrame;
+			time_since_last_update -= m_time_per_update;
 			ProcessInput();
-			Update(kTimePerFrame);
+			m_timing.m_step++;
+			Update(m_time_per_update);
+			updates++;
 
 			if(m_stack.IsEmpty())
 			{
 				m_window.close();
 			}
 		}
+
+		if (time_since_last_update >= m_time_per_update)
+		{
+			time_since_last_update %= m_time_per_update;
+		}
+
+		//Draw the world part of the way towards the next step instead of where the last one left it
+		m_timing.m_interpolation = time_since_last_update / m_time_per_update;
+		m_statistics_numupdates += updates;
 		UpdateStatistics(elapsedTime);
 		Render();
 	}
@@ -91,15 +138,32 @@ void Application::UpdateStatistics(sf::Time elapsed_time)
 {
 	m_statistics_updatetime += elapsed_time;
 	m_statistics_numframes += 1;
+	m_quality.AddFrameTime(elapsed_time);
 
 	if (m_statistics_updatetime >= sf::seconds(1.0f))
 	{
 		m_statistics_text.setString(
 			"Frames / Second = " + std::to_string(m_statistics_numframes) + "\n" +
+			"Updates / Second = " + std::to_string(m_statistics_numupdates) + "\n" +
 			"Time / Update = " + std::to_string(m_statistics_updatetime.asMicroseconds() / m_statistics_numframes) + "us");
 
 		m_statistics_updatetime -= sf::seconds(1.0f);
 		m_statistics_numframes = 0;
+		m_statistics_numupdates = 0;
+	}
+}
+
+void Application::UpdateLoading()
+{
+	if(m_assets.IsDone())
+	{
+		return;
+	}
+
+	m_assets.Update(AssetUploadBudget);
+	if(m_assets.IsDone() && m_debug_settings.m_report_statistics)
+	{
+		std::cout << "Assets loaded " << m_startup_clock.getElapsedTime().asMilliseconds() << "ms after start" << std::endl;
 	}
 }
 
@@ -110,6 +174,7 @@ void Application::RegisterStates()
 	m_stack.RegisterState<GameState>(StateID::kGame);
 	m_stack.RegisterState<MultiplayerGameState>(StateID::kHostGame, true);
 	m_stack.RegisterState<MultiplayerGameState>(StateID::kJoinGame, false);
+	m_stack.RegisterState<MultiplayerGameState>(StateID::kDemoPlayback, m_demo_settings.m_playback_path);
 	m_stack.RegisterState<PauseState>(StateID::kPause);
 	m_stack.RegisterState<PauseState>(StateID::kNetworkPause, true);
 	m_stack.RegisterState<SettingsState>(StateID::kSettings);
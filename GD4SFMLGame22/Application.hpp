@@ -1,11 +1,18 @@
 #pragma once
 #include <SFML/Graphics/RenderWindow.hpp>
 #include <SFML/Graphics/Text.hpp>
+#include <SFML/System/Clock.hpp>
 #include <SFML/System/Time.hpp>
 
+#include "AssetLoader.hpp"
+#include "DebugSettings.hpp"
+#include "DemoRecorder.hpp"
+#include "FrameTiming.hpp"
+#include "JobSystem.hpp"
 #include "KeyBinding.hpp"
 #include "MusicPlayer.hpp"
 #include "Player.hpp"
+#include "QualityGovernor.hpp"
 #include "ResourceHolder.hpp"
 #include "ResourceIdentifiers.hpp"
 #include "StateStack.hpp"
@@ -13,7 +20,11 @@
 class Application
 {
 public:
-	Application();
+	//The simulation steps simulation_rate times a second whatever the display rate is. worker_threads are
+	//started next to the main thread to share out parts of each step. The drawing quality is lowered when
+	//frames take longer than 1 / target_frame_rate seconds, 0 never lowers it. cpu_bloom does the bloom on the
+	//CPU where there are no shaders, see QualityGovernor
+	Application(const DemoSettings& demo_settings, const DebugSettings& debug_settings, unsigned int simulation_rate, std::size_t worker_threads, unsigned int target_frame_rate, bool cpu_bloom);
 	void Run();
 
 private:
@@ -21,9 +32,11 @@ private:
 	void Update(sf::Time delta_time);
 	void Render();
 	void UpdateStatistics(sf::Time elapsed_time);
+	void UpdateLoading();
 	void RegisterStates();
 
 private:
+	sf::Clock m_startup_clock;
 	sf::RenderWindow m_window;
 
 	TextureHolder m_textures;
@@ -34,6 +47,12 @@ private:
 
 	KeyBinding m_key_binding_1;
 	KeyBinding m_key_binding_2;
+	DemoSettings m_demo_settings;
+	DebugSettings m_debug_settings;
+	FrameTiming m_timing;
+	JobSystem m_jobs;
+	QualityGovernor m_quality;
+	AssetLoader m_assets;
 
 	StateStack m_stack;
 
@@ -41,6 +60,7 @@ private:
 	sf::Time m_statistics_updatetime;
 
 	std::size_t m_statistics_numframes;
-	static const sf::Time kTimePerFrame;
+	std::size_t m_statistics_numupdates;
+	sf::Time m_time_per_update;
 };
 
@@ -0,0 +1,171 @@
+#include "AssetLoader.hpp"
+#include "ResourceHolder.hpp"
+
+#include <SFML/Audio/InputSoundFile.hpp>
+#include <SFML/Audio/SoundBuffer.hpp>
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/System/Clock.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <stdexcept>
+
+AssetLoader::AssetLoader(std::size_t thread_count)
+	: m_thread_count(std::max<std::size_t>(thread_count, 1))
+	, m_next_asset(0)
+	, m_finished(0)
+{
+}
+
+AssetLoader::~AssetLoader()
+{
+	//Nothing new is handed out once the loader goes, the threads only finish the files they are on
+	m_next_asset = m_assets.size();
+	for(std::thread& thread : m_threads)
+	{
+		thread.join();
+	}
+}
+
+void AssetLoader::LoadTexture(TextureHolder& holder, Textures id, const std::string& filename)
+{
+	AddAsset(filename, false, [&holder, id](Asset& asset)
+	{
+		std::unique_ptr<sf::Texture> texture(new sf::Texture());
+		if(!texture->loadFromImage(asset.m_image))
+		{
+			throw std::runtime_error("AssetLoader - Failed to load " + asset.m_filename);
+		}
+		holder.InsertResource(id, std::move(texture));
+		asset.m_image = sf::Image();
+	});
+}
+
+void AssetLoader::LoadSoundBuffer(SoundBufferHolder& holder, SoundEffect id, const std::string& filename)
+{
+	AddAsset(filename, true, [&holder, id](Asset& asset)
+	{
+		std::unique_ptr<sf::SoundBuffer> buffer(new sf::SoundBuffer());
+		if(!buffer->loadFromSamples(asset.m_samples.data(), asset.m_samples.size(), asset.m_channel_count, asset.m_sample_rate))
+		{
+			throw std::runtime_error("AssetLoader - Failed to load " + asset.m_filename);
+		}
+		holder.InsertResource(id, std::move(buffer));
+		std::vector<sf::Int16>().swap(asset.m_samples);
+	});
+}
+
+void AssetLoader::Start()
+{
+	std::size_t thread_count = std::min(m_thread_count, m_assets.size());
+	for(std::size_t i = 0; i < thread_count; ++i)
+	{
+		m_threads.emplace_back(&AssetLoader::WorkerThread, this);
+	}
+}
+
+void AssetLoader::Update(sf::Time budget)
+{
+	sf::Clock clock;
+	std::size_t index;
+	while(PopDecoded(false, index))
+	{
+		FinishAsset(index);
+		if(clock.getElapsedTime() >= budget)
+		{
+			break;
+		}
+	}
+}
+
+void AssetLoader::Finish()
+{
+	std::size_t index;
+	while(!IsDone() && PopDecoded(true, index))
+	{
+		FinishAsset(index);
+	}
+}
+
+bool AssetLoader::IsDone() const
+{
+	return m_finished == m_assets.size();
+}
+
+float AssetLoader::GetProgress() const
+{
+	return m_assets.empty() ? 1.f : static_cast<float>(m_finished) / m_assets.size();
+}
+
+void AssetLoader::AddAsset(const std::string& filename, bool is_sound, std::function<void(Asset&)> finish)
+{
+	assert(m_threads.empty());
+	m_assets.emplace_back();
+	Asset& asset = m_assets.back();
+	asset.m_filename = filename;
+	asset.m_is_sound = is_sound;
+	asset.m_decoded = false;
+	asset.m_channel_count = 0;
+	asset.m_sample_rate = 0;
+	asset.m_finish = std::move(finish);
+}
+
+void AssetLoader::WorkerThread()
+{
+	//Each thread takes the next file nobody has taken yet until there are none left
+	for(std::size_t index = m_next_asset++; index < m_assets.size(); index = m_next_asset++)
+	{
+		Decode(m_assets[index]);
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_decoded.emplace_back(index);
+		m_asset_decoded.notify_one();
+	}
+}
+
+bool AssetLoader::PopDecoded(bool wait, std::size_t& index)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if(wait)
+	{
+		m_asset_decoded.wait(lock, [this] { return !m_decoded.empty(); });
+	}
+	if(m_decoded.empty())
+	{
+		return false;
+	}
+	index = m_decoded.back();
+	m_decoded.pop_back();
+	return true;
+}
+
+void AssetLoader::FinishAsset(std::size_t index)
+{
+	Asset& asset = m_assets[index];
+	m_finished++;
+	if(!asset.m_decoded)
+	{
+		throw std::runtime_error("AssetLoader - Failed to load " + asset.m_filename);
+	}
+	asset.m_finish(asset);
+}
+
+void AssetLoader::Decode(Asset& asset)
+{
+	if(!asset.m_is_sound)
+	{
+		asset.m_decoded = asset.m_image.loadFromFile(asset.m_filename);
+		return;
+	}
+
+	sf::InputSoundFile file;
+	if(!file.openFromFile(asset.m_filename))
+	{
+		return;
+	}
+	asset.m_samples.resize(static_cast<std::size_t>(file.getSampleCount()));
+	asset.m_channel_count = file.getChannelCount();
+	asset.m_sample_rate = file.getSampleRate();
+	asset.m_decoded = file.read(asset.m_samples.data(), asset.m_samples.size()) == asset.m_samples.size();
+}
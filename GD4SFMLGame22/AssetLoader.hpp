@@ -0,0 +1,74 @@
+#pragma once
+#include <SFML/Graphics/Image.hpp>
+#include <SFML/System/NonCopyable.hpp>
+#include <SFML/System/Time.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ResourceIdentifiers.hpp"
+
+//Loads textures and sound buffers into resource holders without holding up the main thread. The
+//files are read and decoded on threads of its own. The decoded pixels and samples are only turned into
+//textures and sound buffers by Update on the main thread, as many as fit in the time it is given, because
+//that is where SFML's OpenGL and OpenAL resources are made
+class AssetLoader : private sf::NonCopyable
+{
+public:
+	//thread_count decoding threads, at least one
+	explicit AssetLoader(std::size_t thread_count);
+	~AssetLoader();
+
+	//Everything is queued before Start. The holders must outlive the loading
+	void LoadTexture(TextureHolder& holder, Textures id, const std::string& filename);
+	void LoadSoundBuffer(SoundBufferHolder& holder, SoundEffect id, const std::string& filename);
+	void Start();
+
+	//Finishes decoded assets until budget is used up, at least one per call if any is ready. Throws like
+	//ResourceHolder::Load when a file could not be loaded
+	void Update(sf::Time budget);
+	//Waits for everything that is left and finishes it
+	void Finish();
+	bool IsDone() const;
+	//Share of the assets finished, 0 to 1
+	float GetProgress() const;
+
+private:
+	struct Asset
+	{
+		std::string m_filename;
+		bool m_is_sound;
+		bool m_decoded;
+		sf::Image m_image;
+		std::vector<sf::Int16> m_samples;
+		unsigned int m_channel_count;
+		unsigned int m_sample_rate;
+		std::function<void(Asset&)> m_finish;
+	};
+
+private:
+	void AddAsset(const std::string& filename, bool is_sound, std::function<void(Asset&)> finish);
+	void WorkerThread();
+	bool PopDecoded(bool wait, std::size_t& index);
+	void FinishAsset(std::size_t index);
+	static void Decode(Asset& asset);
+
+private:
+	std::size_t m_thread_count;
+	std::vector<std::thread> m_threads;
+	//A deque so assets never move while the threads decode them
+	std::deque<Asset> m_assets;
+	std::atomic<std::size_t> m_next_asset;
+	std::size_t m_finished;
+
+	std::mutex m_mutex;
+	std::condition_variable m_asset_decoded;
+	std::vector<std::size_t> m_decoded;
+};
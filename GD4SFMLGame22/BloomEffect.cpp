@@ -2,6 +2,9 @@
 #include "Shaders.hpp"
 
 BloomEffect::BloomEffect()
+	: m_downsamples(1)
+	, m_blur_iterations(2)
+	, m_prepared_downsamples(0)
 {
 	m_shaders.Load(ShaderTypes::kBrightnessPass, "Media/Shaders/Fullpass.vert", "Media/Shaders/Brightness.frag");
 	m_shaders.Load(ShaderTypes::kDownSamplePass, "Media/Shaders/Fullpass.vert", "Media/Shaders/DownSample.frag");
@@ -26,21 +29,31 @@ void BloomEffect::Apply(const sf::RenderTexture& input, sf::RenderTarget& output
 	Add(input, m_firstpass_textures[1], output);
 }
 
+void BloomEffect::SetQuality(std::size_t downsamples, std::size_t blur_iterations)
+{
+	m_downsamples = downsamples;
+	m_blur_iterations = blur_iterations;
+}
+
 void BloomEffect::PrepareTextures(sf::Vector2u size)
 {
-	if (m_brightness_texture.getSize() != size)
+	if (m_prepared_size != size || m_prepared_downsamples != m_downsamples)
 	{
+		m_prepared_size = size;
+		m_prepared_downsamples = m_downsamples;
+
 		m_brightness_texture.create(size.x, size.y);
 		m_brightness_texture.setSmooth(true);
 
-		m_firstpass_textures[0].create(size.x / 2, size.y / 2);
+		sf::Vector2u firstpass_size(size.x >> m_downsamples, size.y >> m_downsamples);
+		m_firstpass_textures[0].create(firstpass_size.x, firstpass_size.y);
 		m_firstpass_textures[0].setSmooth(true);
-		m_firstpass_textures[1].create(size.x / 2, size.y / 2);
+		m_firstpass_textures[1].create(firstpass_size.x, firstpass_size.y);
 		m_firstpass_textures[1].setSmooth(true);
 
-		m_secondpass_textures[0].create(size.x / 4, size.y / 4);
+		m_secondpass_textures[0].create(firstpass_size.x / 2, firstpass_size.y / 2);
 		m_secondpass_textures[0].setSmooth(true);
-		m_secondpass_textures[1].create(size.x / 4, size.y / 4);
+		m_secondpass_textures[1].create(firstpass_size.x / 2, firstpass_size.y / 2);
 		m_secondpass_textures[1].setSmooth(true);
 	}
 }
@@ -58,7 +71,7 @@ void BloomEffect::BlurMultipass(RenderTextureArray& renderTextures)
 {
 	sf::Vector2u textureSize = renderTextures[0].getSize();
 
-	for (std::size_t count = 0; count < 2; ++count)
+	for (std::size_t count = 0; count < m_blur_iterations; ++count)
 	{
 		Blur(renderTextures[0], renderTextures[1], sf::Vector2f(0.f, 1.f / textureSize.y));
 		Blur(renderTextures[1], renderTextures[0], sf::Vector2f(1.f / textureSize.x, 0.f));
@@ -15,6 +15,8 @@ public:
 	BloomEffect();
 
 	virtual void Apply(const sf::RenderTexture& input, sf::RenderTarget& output);
+	//The first blur octave is the input halved downsamples times, each octave is blurred blur_iterations times
+	void SetQuality(std::size_t downsamples, std::size_t blur_iterations);
 
 
 private:
@@ -37,6 +39,11 @@ private:
 	sf::RenderTexture	m_brightness_texture;
 	RenderTextureArray	m_firstpass_textures;
 	RenderTextureArray	m_secondpass_textures;
+
+	std::size_t			m_downsamples;
+	std::size_t			m_blur_iterations;
+	sf::Vector2u		m_prepared_size;
+	std::size_t			m_prepared_downsamples;
 };
 
 
@@ -0,0 +1,335 @@
+#include "BloomKernels.hpp"
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BLOOM_KERNELS_SSE
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	//Brightness.frag
+	const float Threshold = 0.7f;
+	const float Factor = 4.f;
+	const float RedLuminance = 0.2126f;
+	const float GreenLuminance = 0.7152f;
+	const float BlueLuminance = 0.0722f;
+
+	//GuassianBlur.frag, from the centre outwards
+	const int BlurRadius = 4;
+	const float BlurWeights[BlurRadius + 1] = { 0.2270270270f, 0.1945945946f, 0.1216216216f, 0.0540540541f, 0.0162162162f };
+
+	//Scaling up 2x, every pixel lies a quarter of a source pixel away from the nearest source pixel centre
+	const float NearWeight = 0.75f;
+	const float FarWeight = 0.25f;
+
+	const std::size_t Channels = 4;
+
+#ifdef BLOOM_KERNELS_SSE
+	typedef __m128 Pixel;
+
+	inline Pixel Load(const float* pixel)
+	{
+		return _mm_loadu_ps(pixel);
+	}
+
+	inline void Store(float* pixel, Pixel value)
+	{
+		_mm_storeu_ps(pixel, value);
+	}
+
+	inline Pixel Zero()
+	{
+		return _mm_setzero_ps();
+	}
+
+	inline Pixel Plus(Pixel lhs, Pixel rhs)
+	{
+		return _mm_add_ps(lhs, rhs);
+	}
+
+	inline Pixel Scale(Pixel pixel, float factor)
+	{
+		return _mm_mul_ps(pixel, _mm_set1_ps(factor));
+	}
+
+	inline Pixel LoadBytes(const sf::Uint8* pixel)
+	{
+		int packed;
+		std::copy(pixel, pixel + Channels, reinterpret_cast<sf::Uint8*>(&packed));
+		__m128i zero = _mm_setzero_si128();
+		__m128i words = _mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero);
+		__m128i integers = _mm_unpacklo_epi16(words, zero);
+		return _mm_mul_ps(_mm_cvtepi32_ps(integers), _mm_set1_ps(1.f / 255.f));
+	}
+
+	inline void StoreBytes(sf::Uint8* pixel, Pixel value)
+	{
+		//Rounded to the nearest and saturated to 0-255 by the packs
+		__m128i integers = _mm_cvtps_epi32(_mm_mul_ps(value, _mm_set1_ps(255.f)));
+		__m128i words = _mm_packs_epi32(integers, integers);
+		int packed = _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+		const sf::Uint8* bytes = reinterpret_cast<const sf::Uint8*>(&packed);
+		std::copy(bytes, bytes + Channels, pixel);
+	}
+#else
+	struct Pixel
+	{
+		float m_channels[Channels];
+	};
+
+	inline Pixel Load(const float* pixel)
+	{
+		Pixel result;
+		std::copy(pixel, pixel + Channels, result.m_channels);
+		return result;
+	}
+
+	inline void Store(float* pixel, const Pixel& value)
+	{
+		std::copy(value.m_channels, value.m_channels + Channels, pixel);
+	}
+
+	inline Pixel Zero()
+	{
+		Pixel result = { { 0.f, 0.f, 0.f, 0.f } };
+		return result;
+	}
+
+	inline Pixel Plus(Pixel lhs, const Pixel& rhs)
+	{
+		for(std::size_t channel = 0; channel < Channels; ++channel)
+		{
+			lhs.m_channels[channel] += rhs.m_channels[channel];
+		}
+		return lhs;
+	}
+
+	inline Pixel Scale(Pixel pixel, float factor)
+	{
+		for(std::size_t channel = 0; channel < Channels; ++channel)
+		{
+			pixel.m_channels[channel] *= factor;
+		}
+		return pixel;
+	}
+
+	inline Pixel LoadBytes(const sf::Uint8* pixel)
+	{
+		Pixel result;
+		for(std::size_t channel = 0; channel < Channels; ++channel)
+		{
+			result.m_channels[channel] = pixel[channel] / 255.f;
+		}
+		return result;
+	}
+
+	inline void StoreBytes(sf::Uint8* pixel, const Pixel& value)
+	{
+		for(std::size_t channel = 0; channel < Channels; ++channel)
+		{
+			float scaled = std::min(std::max(value.m_channels[channel] * 255.f + 0.5f, 0.f), 255.f);
+			pixel[channel] = static_cast<sf::Uint8>(scaled);
+		}
+	}
+#endif
+
+	std::size_t Clamp(std::ptrdiff_t index, std::size_t size)
+	{
+		return static_cast<std::size_t>(std::min(std::max(index, std::ptrdiff_t(0)), static_cast<std::ptrdiff_t>(size) - 1));
+	}
+
+	//The two source pixels nearest to a pixel of an image twice the size, the nearer one first
+	void GetUpsampleSources(std::size_t index, std::size_t source_size, std::size_t& near_index, std::size_t& far_index)
+	{
+		std::ptrdiff_t half = static_cast<std::ptrdiff_t>(index / 2);
+		near_index = Clamp(half, source_size);
+		far_index = Clamp(index % 2 == 0 ? half - 1 : half + 1, source_size);
+	}
+
+	Pixel SampleUpsampled(const float* near_row, const float* far_row, std::size_t x, std::size_t bloom_width)
+	{
+		std::size_t near_x;
+		std::size_t far_x;
+		GetUpsampleSources(x, bloom_width, near_x, far_x);
+
+		Pixel near_pixels = Plus(Scale(Load(near_row + near_x * Channels), NearWeight), Scale(Load(near_row + far_x * Channels), FarWeight));
+		Pixel far_pixels = Plus(Scale(Load(far_row + near_x * Channels), NearWeight), Scale(Load(far_row + far_x * Channels), FarWeight));
+		return Plus(Scale(near_pixels, NearWeight), Scale(far_pixels, FarWeight));
+	}
+}
+
+namespace BloomKernels
+{
+	Image::Image() : m_width(0), m_height(0)
+	{
+	}
+
+	void Image::Resize(std::size_t width, std::size_t height)
+	{
+		m_width = width;
+		m_height = height;
+		m_pixels.resize(width * height * Channels);
+	}
+
+	float* Image::GetRow(std::size_t y)
+	{
+		return &m_pixels[y * m_width * Channels];
+	}
+
+	const float* Image::GetRow(std::size_t y) const
+	{
+		return &m_pixels[y * m_width * Channels];
+	}
+
+	bool UsesSimd()
+	{
+#ifdef BLOOM_KERNELS_SSE
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	void BrightPass(const sf::Uint8* source, Image& destination, std::size_t first_row, std::size_t end_row)
+	{
+		for(std::size_t y = first_row; y < end_row; ++y)
+		{
+			const sf::Uint8* source_pixel = source + y * destination.m_width * Channels;
+			float* destination_pixel = destination.GetRow(y);
+			for(std::size_t x = 0; x < destination.m_width; ++x)
+			{
+				float luminance = (source_pixel[0] * RedLuminance + source_pixel[1] * GreenLuminance + source_pixel[2] * BlueLuminance) / 255.f;
+				float factor = std::min(std::max(luminance - Threshold, 0.f), 1.f) * Factor;
+				Store(destination_pixel, Scale(LoadBytes(source_pixel), factor));
+
+				source_pixel += Channels;
+				destination_pixel += Channels;
+			}
+		}
+	}
+
+	void Downsample(const Image& source, Image& destination, std::size_t first_row, std::size_t end_row)
+	{
+		for(std::size_t y = first_row; y < end_row; ++y)
+		{
+			const float* top = source.GetRow(Clamp(2 * y, source.m_height));
+			const float* bottom = source.GetRow(Clamp(2 * y + 1, source.m_height));
+			float* destination_pixel = destination.GetRow(y);
+			for(std::size_t x = 0; x < destination.m_width; ++x)
+			{
+				std::size_t left = Clamp(2 * x, source.m_width) * Channels;
+				std::size_t right = Clamp(2 * x + 1, source.m_width) * Channels;
+				Pixel sum = Plus(Plus(Load(top + left), Load(top + right)), Plus(Load(bottom + left), Load(bottom + right)));
+				Store(destination_pixel, Scale(sum, 0.25f));
+				destination_pixel += Channels;
+			}
+		}
+	}
+
+	void BlurVertical(const Image& source, Image& destination, std::size_t first_row, std::size_t end_row)
+	{
+		for(std::size_t y = first_row; y < end_row; ++y)
+		{
+			const float* rows[2 * BlurRadius + 1];
+			for(int offset = -BlurRadius; offset <= BlurRadius; ++offset)
+			{
+				rows[offset + BlurRadius] = source.GetRow(Clamp(static_cast<std::ptrdiff_t>(y) + offset, source.m_height));
+			}
+
+			float* destination_pixel = destination.GetRow(y);
+			for(std::size_t x = 0; x < destination.m_width; ++x)
+			{
+				std::size_t column = x * Channels;
+				Pixel sum = Scale(Load(rows[BlurRadius] + column), BlurWeights[0]);
+				for(int offset = 1; offset <= BlurRadius; ++offset)
+				{
+					Pixel pair = Plus(Load(rows[BlurRadius - offset] + column), Load(rows[BlurRadius + offset] + column));
+					sum = Plus(sum, Scale(pair, BlurWeights[offset]));
+				}
+				Store(destination_pixel, sum);
+				destination_pixel += Channels;
+			}
+		}
+	}
+
+	void BlurHorizontal(const Image& source, Image& destination, std::size_t first_row, std::size_t end_row)
+	{
+		for(std::size_t y = first_row; y < end_row; ++y)
+		{
+			const float* row = source.GetRow(y);
+			float* destination_pixel = destination.GetRow(y);
+			for(std::size_t x = 0; x < destination.m_width; ++x)
+			{
+				std::ptrdiff_t centre = static_cast<std::ptrdiff_t>(x);
+				Pixel sum = Scale(Load(row + x * Channels), BlurWeights[0]);
+				for(int offset = 1; offset <= BlurRadius; ++offset)
+				{
+					const float* left = row + Clamp(centre - offset, source.m_width) * Channels;
+					const float* right = row + Clamp(centre + offset, source.m_width) * Channels;
+					sum = Plus(sum, Scale(Plus(Load(left), Load(right)), BlurWeights[offset]));
+				}
+				Store(destination_pixel, sum);
+				destination_pixel += Channels;
+			}
+		}
+	}
+
+	void Upsample(const Image& source, Image& destination, std::size_t first_row, std::size_t end_row)
+	{
+		for(std::size_t y = first_row; y < end_row; ++y)
+		{
+			std::size_t near_y;
+			std::size_t far_y;
+			GetUpsampleSources(y, source.m_height, near_y, far_y);
+
+			float* destination_pixel = destination.GetRow(y);
+			for(std::size_t x = 0; x < destination.m_width; ++x)
+			{
+				Store(destination_pixel, SampleUpsampled(source.GetRow(near_y), source.GetRow(far_y), x, source.m_width));
+				destination_pixel += Channels;
+			}
+		}
+	}
+
+	void Add(const Image& source, const Image& bloom, Image& destination, std::size_t first_row, std::size_t end_row)
+	{
+		for(std::size_t y = first_row; y < end_row; ++y)
+		{
+			std::size_t near_y;
+			std::size_t far_y;
+			GetUpsampleSources(y, bloom.m_height, near_y, far_y);
+
+			const float* source_pixel = source.GetRow(y);
+			float* destination_pixel = destination.GetRow(y);
+			for(std::size_t x = 0; x < destination.m_width; ++x)
+			{
+				Pixel bloom_pixel = SampleUpsampled(bloom.GetRow(near_y), bloom.GetRow(far_y), x, bloom.m_width);
+				Store(destination_pixel, Plus(Load(source_pixel), bloom_pixel));
+				source_pixel += Channels;
+				destination_pixel += Channels;
+			}
+		}
+	}
+
+	void Add(const sf::Uint8* source, const Image& bloom, sf::Uint8* destination, std::size_t width, std::size_t first_row, std::size_t end_row)
+	{
+		for(std::size_t y = first_row; y < end_row; ++y)
+		{
+			std::size_t near_y;
+			std::size_t far_y;
+			GetUpsampleSources(y, bloom.m_height, near_y, far_y);
+
+			const sf::Uint8* source_pixel = source + y * width * Channels;
+			sf::Uint8* destination_pixel = destination + y * width * Channels;
+			for(std::size_t x = 0; x < width; ++x)
+			{
+				Pixel bloom_pixel = SampleUpsampled(bloom.GetRow(near_y), bloom.GetRow(far_y), x, bloom.m_width);
+				StoreBytes(destination_pixel, Plus(LoadBytes(source_pixel), bloom_pixel));
+				source_pixel += Channels;
+				destination_pixel += Channels;
+			}
+		}
+	}
+}
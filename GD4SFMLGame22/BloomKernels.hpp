@@ -0,0 +1,41 @@
+#pragma once
+#include <SFML/Config.hpp>
+
+#include <cstddef>
+#include <vector>
+
+//The passes of the bloom shaders done on the CPU. Each kernel writes the rows [first_row, end_row) of its
+//destination and only reads its sources, so different row ranges can run on different threads at once.
+//A pixel is four floats, RGBA from 0 to 1, which is one SSE register where SSE is available
+namespace BloomKernels
+{
+	struct Image
+	{
+		Image();
+		void Resize(std::size_t width, std::size_t height);
+		float* GetRow(std::size_t y);
+		const float* GetRow(std::size_t y) const;
+
+		std::size_t m_width;
+		std::size_t m_height;
+		std::vector<float> m_pixels;
+	};
+
+	//Whether the kernels were built with SSE, otherwise they are plain C++
+	bool UsesSimd();
+
+	//Brightness.frag: source is 8 bit RGBA the size of destination
+	void BrightPass(const sf::Uint8* source, Image& destination, std::size_t first_row, std::size_t end_row);
+	//The average of every 2x2 block of source, destination is half its size
+	void Downsample(const Image& source, Image& destination, std::size_t first_row, std::size_t end_row);
+	//The 9 taps of GuassianBlur.frag along a column or a row, clamped at the edges
+	void BlurVertical(const Image& source, Image& destination, std::size_t first_row, std::size_t end_row);
+	void BlurHorizontal(const Image& source, Image& destination, std::size_t first_row, std::size_t end_row);
+	//Scales source up to twice its size, bilinearly as a smooth texture would be
+	void Upsample(const Image& source, Image& destination, std::size_t first_row, std::size_t end_row);
+	//Add.frag: source plus bloom, which is half the size and scaled up bilinearly as a smooth texture would be
+	void Add(const Image& source, const Image& bloom, Image& destination, std::size_t first_row, std::size_t end_row);
+	//The same for the final image, source and destination are 8 bit RGBA and the result is clamped
+	void Add(const sf::Uint8* source, const Image& bloom, sf::Uint8* destination, std::size_t width, std::size_t first_row, std::size_t end_row);
+}
+
@@ -0,0 +1,331 @@
+#ifdef PERFORMANCE_CHECKS
+
+#include <SFML/Network/Packet.hpp>
+#include <SFML/System/Clock.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "NetworkProtocol.hpp"
+#include "PerformanceChecks.hpp"
+#include "WireFormat.hpp"
+
+namespace
+{
+	//The same crowd as a busy game: 16 aircraft near the bottom of the world
+	const std::size_t AircraftCount = 16;
+	const float WorldHeight = 5000.f;
+	const float BattlefieldBottom = 4988.f;
+	const std::size_t CodecIterations = 100000;
+
+	struct AircraftState
+	{
+		sf::Int32 m_identifier;
+		sf::Vector2f m_position;
+		sf::Int32 m_hitpoints;
+		sf::Int32 m_missile_ammo;
+	};
+
+	std::vector<AircraftState> MakeAircraft(std::size_t count)
+	{
+		std::vector<AircraftState> aircraft;
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			aircraft.push_back({ static_cast<sf::Int32>(i + 1), sf::Vector2f(64.f * i, 4700.f - 8.f * i), 100, 2 });
+		}
+		return aircraft;
+	}
+
+	//Before the compact wire format every field went into an sf::Packet as a full Int32, float or bool, and the
+	//type as an Int32. Both are sent behind the same 4 byte size, which is left out here
+
+	void WriteOldAircraft(sf::Packet& packet, const std::vector<AircraftState>& aircraft)
+	{
+		packet << static_cast<sf::Int32>(aircraft.size());
+		for (const AircraftState& state : aircraft)
+		{
+			packet << state.m_identifier << state.m_position.x << state.m_position.y << state.m_hitpoints << state.m_missile_ammo;
+		}
+	}
+
+	template <typename Stream>
+	void WriteAircraft(Stream& stream, const std::vector<AircraftState>& aircraft)
+	{
+		stream << Wire::VarInt(aircraft.size());
+		for (const AircraftState& state : aircraft)
+		{
+			stream << Wire::VarInt(state.m_identifier) << Wire::Position(state.m_position) << Wire::VarInt(state.m_hitpoints) << Wire::VarInt(state.m_missile_ammo);
+		}
+	}
+
+	template <typename Stream>
+	void WriteUpdateClientState(Stream& stream, const std::vector<AircraftState>& aircraft)
+	{
+		stream << Wire::Tag(Server::PacketType::UpdateClientState) << Wire::CoordinateY(BattlefieldBottom);
+		WriteAircraft(stream, aircraft);
+	}
+
+	template <typename Stream>
+	bool ReadUpdateClientState(Stream& stream)
+	{
+		sf::Int32 type;
+		float bottom;
+		sf::Int32 count;
+		stream >> Wire::Tag(type) >> Wire::CoordinateY(bottom) >> Wire::VarInt(count);
+		for (sf::Int32 i = 0; i < count; ++i)
+		{
+			sf::Int32 identifier;
+			sf::Vector2f position;
+			sf::Int32 hitpoints;
+			sf::Int32 missile_ammo;
+			stream >> Wire::VarInt(identifier) >> Wire::Position(position) >> Wire::VarInt(hitpoints) >> Wire::VarInt(missile_ammo);
+		}
+		return static_cast<bool>(stream);
+	}
+
+	void WriteOldUpdateClientState(sf::Packet& packet, const std::vector<AircraftState>& aircraft)
+	{
+		packet << static_cast<sf::Int32>(Server::PacketType::UpdateClientState) << BattlefieldBottom;
+		WriteOldAircraft(packet, aircraft);
+	}
+
+	bool ReadOldUpdateClientState(sf::Packet& packet)
+	{
+		sf::Int32 type;
+		float bottom;
+		sf::Int32 count;
+		packet >> type >> bottom >> count;
+		for (sf::Int32 i = 0; i < count; ++i)
+		{
+			sf::Int32 identifier;
+			sf::Vector2f position;
+			sf::Int32 hitpoints;
+			sf::Int32 missile_ammo;
+			packet >> identifier >> position.x >> position.y >> hitpoints >> missile_ammo;
+		}
+		return static_cast<bool>(packet);
+	}
+
+	//Each message is written both ways, then Print shows the two sizes. Messages that did not exist before are
+	//only written new, messages that are gone only old
+	class SizeTable
+	{
+	public:
+		SizeTable() : m_has_old(false), m_has_new(false), m_writer(m_buffer)
+		{
+		}
+
+		sf::Packet& Old()
+		{
+			m_old.clear();
+			m_has_old = true;
+			return m_old;
+		}
+
+		Wire::Writer& New()
+		{
+			m_buffer.clear();
+			m_writer = Wire::Writer(m_buffer);
+			m_has_new = true;
+			return m_writer;
+		}
+
+		void Print(const char* name, const char* note = "")
+		{
+			std::cout << "  " << name << ": ";
+			if (m_has_old && m_has_new)
+			{
+				std::cout << m_old.getDataSize() << " -> " << m_writer.GetSize() << " bytes";
+			}
+			else if (m_has_new)
+			{
+				std::cout << "new, " << m_writer.GetSize() << " bytes";
+			}
+			else
+			{
+				std::cout << m_old.getDataSize() << " bytes, gone";
+			}
+			std::cout << note << std::endl;
+			m_has_old = false;
+			m_has_new = false;
+		}
+
+	private:
+		sf::Packet m_old;
+		bool m_has_old;
+		bool m_has_new;
+		std::vector<char> m_buffer;
+		Wire::Writer m_writer;
+	};
+
+	void PrintMessageSizes()
+	{
+		std::vector<AircraftState> crowd = MakeAircraft(AircraftCount);
+		std::vector<AircraftState> own = MakeAircraft(1);
+		const AircraftState& aircraft = own.front();
+		const std::string message = "New player";
+		const sf::Int32 action = 2;
+		bool enabled = true;
+		const sf::Int32 enemy_type = 2;
+		const float enemy_height = 1268.f;
+		const float enemy_offset = -150.f;
+		const sf::Int32 pickup_type = 1;
+		const sf::Uint32 newest_tick = 1200;
+		const sf::Uint8 input = 5;
+		const sf::Uint32 migration_port = SERVER_PORT + 1;
+		const sf::Uint32 migration_token = 7;
+
+		//The old client numbered its messages from PlayerEvent and PlayerRealtimeChange, which have since gone
+		enum OldClientPacketType
+		{
+			kOldPlayerEvent,
+			kOldPlayerRealtimeChange,
+			kOldRequestCoopPartner,
+			kOldPositionUpdate,
+			kOldGameEvent,
+			kOldQuit
+		};
+
+		SizeTable table;
+		std::cout << "Message sizes, old sf::Packet -> wire format, " << AircraftCount << " aircraft in the state messages" << std::endl;
+		std::cout << " Server" << std::endl;
+
+		table.New() << Wire::Tag(Server::PacketType::ProtocolMismatch) << Wire::VarInt(PROTOCOL_VERSION);
+		table.Print("ProtocolMismatch");
+
+		table.Old() << static_cast<sf::Int32>(Server::PacketType::BroadcastMessage) << message;
+		table.New() << Wire::Tag(Server::PacketType::BroadcastMessage) << Wire::Text(message);
+		table.Print("BroadcastMessage");
+
+		sf::Packet& old_initial_state = table.Old();
+		old_initial_state << static_cast<sf::Int32>(Server::PacketType::InitialState) << WorldHeight << BattlefieldBottom;
+		WriteOldAircraft(old_initial_state, crowd);
+		Wire::Writer& initial_state = table.New();
+		initial_state << Wire::Tag(Server::PacketType::InitialState) << Wire::CoordinateY(WorldHeight) << Wire::CoordinateY(BattlefieldBottom);
+		WriteAircraft(initial_state, crowd);
+		table.Print("InitialState");
+
+		table.Old() << static_cast<sf::Int32>(Server::PacketType::PlayerEvent) << aircraft.m_identifier << action;
+		table.New() << Wire::Tag(Server::PacketType::PlayerEvent) << Wire::VarInt(aircraft.m_identifier) << Wire::VarInt(action);
+		table.Print("PlayerEvent");
+
+		table.Old() << static_cast<sf::Int32>(Server::PacketType::PlayerRealtimeChange) << aircraft.m_identifier << action << enabled;
+		table.New() << Wire::Tag(Server::PacketType::PlayerRealtimeChange) << Wire::VarInt(aircraft.m_identifier) << Wire::VarInt(action) << Wire::Flags(enabled);
+		table.Print("PlayerRealtimeChange");
+
+		table.Old() << static_cast<sf::Int32>(Server::PacketType::PlayerConnect) << aircraft.m_identifier << aircraft.m_position.x << aircraft.m_position.y;
+		table.New() << Wire::Tag(Server::PacketType::PlayerConnect) << Wire::VarInt(aircraft.m_identifier) << Wire::Position(aircraft.m_position);
+		table.Print("PlayerConnect");
+
+		table.Old() << static_cast<sf::Int32>(Server::PacketType::PlayerDisconnect) << aircraft.m_identifier;
+		table.New() << Wire::Tag(Server::PacketType::PlayerDisconnect) << Wire::VarInt(aircraft.m_identifier);
+		table.Print("PlayerDisconnect");
+
+		table.Old() << static_cast<sf::Int32>(Server::PacketType::AcceptCoopPartner) << aircraft.m_identifier << aircraft.m_position.x << aircraft.m_position.y;
+		table.New() << Wire::Tag(Server::PacketType::AcceptCoopPartner) << Wire::VarInt(aircraft.m_identifier) << Wire::Position(aircraft.m_position);
+		table.Print("AcceptCoopPartner");
+
+		table.Old() << static_cast<sf::Int32>(Server::PacketType::SpawnEnemy) << enemy_type << enemy_height << enemy_offset;
+		table.New() << Wire::Tag(Server::PacketType::SpawnEnemy) << Wire::VarInt(enemy_type) << Wire::CoordinateY(enemy_height) << Wire::CoordinateX(enemy_offset);
+		table.Print("SpawnEnemy");
+
+		table.Old() << static_cast<sf::Int32>(Server::PacketType::SpawnPickup) << pickup_type << aircraft.m_position.x << aircraft.m_position.y;
+		table.New() << Wire::Tag(Server::PacketType::SpawnPickup) << Wire::VarInt(pickup_type) << Wire::Position(aircraft.m_position);
+		table.Print("SpawnPickup");
+
+		table.Old() << static_cast<sf::Int32>(Server::PacketType::SpawnSelf) << aircraft.m_identifier << aircraft.m_position.x << aircraft.m_position.y;
+		table.New() << Wire::Tag(Server::PacketType::SpawnSelf) << Wire::VarInt(aircraft.m_identifier) << Wire::Position(aircraft.m_position);
+		table.Print("SpawnSelf");
+
+		WriteOldUpdateClientState(table.Old(), crowd);
+		WriteUpdateClientState(table.New(), crowd);
+		table.Print("UpdateClientState");
+
+		table.Old() << static_cast<sf::Int32>(Server::PacketType::MissionSuccess);
+		table.New() << Wire::Tag(Server::PacketType::MissionSuccess);
+		table.Print("MissionSuccess");
+
+		table.New() << Wire::Tag(Server::PacketType::AircraftEnter) << Wire::VarInt(aircraft.m_identifier) << Wire::Position(aircraft.m_position)
+			<< Wire::VarInt(aircraft.m_hitpoints) << Wire::VarInt(aircraft.m_missile_ammo);
+		table.Print("AircraftEnter");
+
+		table.New() << Wire::Tag(Server::PacketType::AircraftLeave) << Wire::VarInt(aircraft.m_identifier);
+		table.Print("AircraftLeave");
+
+		table.New() << Wire::Tag(Server::PacketType::Migrate) << Wire::VarInt(migration_port) << Wire::VarInt(migration_token);
+		table.Print("Migrate");
+
+		std::cout << " Client" << std::endl;
+
+		table.New() << Wire::Tag(Client::PacketType::Hello) << Wire::VarInt(PROTOCOL_VERSION) << Wire::VarInt(0);
+		table.Print("Hello");
+
+		table.Old() << static_cast<sf::Int32>(kOldRequestCoopPartner);
+		table.New() << Wire::Tag(Client::PacketType::RequestCoopPartner);
+		table.Print("RequestCoopPartner");
+
+		sf::Packet& old_position_update = table.Old();
+		old_position_update << static_cast<sf::Int32>(kOldPositionUpdate);
+		WriteOldAircraft(old_position_update, own);
+		Wire::Writer& position_update = table.New();
+		position_update << Wire::Tag(Client::PacketType::PositionUpdate) << Wire::VarInt(own.size()) << Wire::VarInt(aircraft.m_identifier) << Wire::Position(aircraft.m_position)
+			<< Wire::VarInt(aircraft.m_hitpoints) << Wire::VarInt(aircraft.m_missile_ammo) << Wire::VarInt(newest_tick) << Wire::VarInt(INPUT_HISTORY_SIZE);
+		for (std::size_t i = 0; i < INPUT_HISTORY_SIZE; ++i)
+		{
+			position_update << input;
+		}
+		table.Print("PositionUpdate", ", one aircraft, the new one also repeats the last few ticks of input");
+
+		table.Old() << static_cast<sf::Int32>(kOldGameEvent) << action << aircraft.m_position.x << aircraft.m_position.y;
+		table.New() << Wire::Tag(Client::PacketType::GameEvent) << Wire::VarInt(action) << Wire::Position(aircraft.m_position);
+		table.Print("GameEvent");
+
+		table.Old() << static_cast<sf::Int32>(kOldQuit);
+		table.New() << Wire::Tag(Client::PacketType::Quit);
+		table.Print("Quit");
+
+		//Sent on every key press and release, the input in PositionUpdate replaced them
+		table.Old() << static_cast<sf::Int32>(kOldPlayerEvent) << aircraft.m_identifier << action;
+		table.Print("PlayerEvent", ", replaced by the input in PositionUpdate");
+
+		table.Old() << static_cast<sf::Int32>(kOldPlayerRealtimeChange) << aircraft.m_identifier << action << enabled;
+		table.Print("PlayerRealtimeChange", ", replaced by the input in PositionUpdate");
+	}
+}
+
+//Prints the size of every message in both formats, then times writing and reading the biggest one that is
+//sent every tick
+
+void CompareCodecs()
+{
+	PrintMessageSizes();
+
+	std::vector<AircraftState> aircraft = MakeAircraft(AircraftCount);
+	sf::Packet old_packet;
+	std::vector<char> buffer;
+	sf::Clock clock;
+	bool valid = true;
+	for (std::size_t i = 0; i < CodecIterations; ++i)
+	{
+		old_packet.clear();
+		WriteOldUpdateClientState(old_packet, aircraft);
+		valid = ReadOldUpdateClientState(old_packet) && valid;
+	}
+	sf::Time old_time = clock.restart();
+
+	for (std::size_t i = 0; i < CodecIterations; ++i)
+	{
+		buffer.clear();
+		Wire::Writer writer(buffer);
+		WriteUpdateClientState(writer, aircraft);
+		Wire::Reader reader(writer.GetData(), writer.GetSize());
+		valid = ReadUpdateClientState(reader) && valid;
+	}
+	sf::Time new_time = clock.getElapsedTime();
+
+	std::cout << "UpdateClientState with " << AircraftCount << " aircraft: " << old_time.asSeconds() * 1000000.f / CodecIterations << "us -> "
+		<< new_time.asSeconds() * 1000000.f / CodecIterations << "us to write and read" << (valid ? "" : ", READ FAILED") << std::endl;
+}
+
+#endif
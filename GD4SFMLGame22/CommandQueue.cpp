@@ -16,3 +16,12 @@ bool CommandQueue::IsEmpty() const
 {
 	return m_queue.empty();
 }
+
+void CommandQueue::Append(CommandQueue& other)
+{
+	while(!other.m_queue.empty())
+	{
+		m_queue.push(std::move(other.m_queue.front()));
+		other.m_queue.pop();
+	}
+}
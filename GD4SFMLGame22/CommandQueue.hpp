@@ -8,6 +8,8 @@ public:
 	void Push(const Command& command);
 	Command Pop();
 	bool IsEmpty() const;
+	//Moves every command of other to the back of this queue, in order
+	void Append(CommandQueue& other);
 
 private:
 	std::queue<Command> m_queue;
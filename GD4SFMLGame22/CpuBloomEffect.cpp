@@ -0,0 +1,152 @@
+#include "CpuBloomEffect.hpp"
+
+#include <algorithm>
+#include <SFML/Graphics/Image.hpp>
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/RenderTexture.hpp>
+#include <SFML/Graphics/Sprite.hpp>
+
+#include "JobSystem.hpp"
+
+namespace
+{
+	//Enough rows that handing them to another thread is worth it
+	const std::size_t RowsPerJob = 16;
+	//The second octave is a quarter of the size at least, smaller frames are not worth blooming
+	const unsigned int MinimumSize = 16;
+}
+
+CpuBloomEffect::CpuBloomEffect(JobSystem& jobs)
+	: m_jobs(jobs)
+	, m_downsamples(1)
+	, m_blur_iterations(2)
+	, m_prepared_downsamples(0)
+{
+}
+
+void CpuBloomEffect::Apply(const sf::RenderTexture& input, sf::RenderTarget& output)
+{
+	sf::Vector2u size = input.getSize();
+	if(size.x < MinimumSize || size.y < MinimumSize)
+	{
+		DrawOutput(input.getTexture(), output);
+		return;
+	}
+
+	PrepareImages(size);
+	sf::Image frame = input.getTexture().copyToImage();
+	const sf::Uint8* frame_pixels = frame.getPixelsPtr();
+
+	RunRows(m_brightness_image.m_height, [&](std::size_t first, std::size_t end)
+	{
+		BloomKernels::BrightPass(frame_pixels, m_brightness_image, first, end);
+	});
+
+	const BloomKernels::Image* source = &m_brightness_image;
+	for(BloomKernels::Image& image : m_scale_images)
+	{
+		RunRows(image.m_height, [&](std::size_t first, std::size_t end)
+		{
+			BloomKernels::Downsample(*source, image, first, end);
+		});
+		source = &image;
+	}
+
+	RunRows(m_firstpass_images[0].m_height, [&](std::size_t first, std::size_t end)
+	{
+		BloomKernels::Downsample(*source, m_firstpass_images[0], first, end);
+	});
+	BlurMultipass(m_firstpass_images);
+
+	RunRows(m_secondpass_images[0].m_height, [&](std::size_t first, std::size_t end)
+	{
+		BloomKernels::Downsample(m_firstpass_images[0], m_secondpass_images[0], first, end);
+	});
+	BlurMultipass(m_secondpass_images);
+
+	RunRows(m_firstpass_images[1].m_height, [&](std::size_t first, std::size_t end)
+	{
+		BloomKernels::Add(m_firstpass_images[0], m_secondpass_images[0], m_firstpass_images[1], first, end);
+	});
+
+	const BloomKernels::Image* bloom = &m_firstpass_images[1];
+	for(auto image = m_scale_images.rbegin(); image != m_scale_images.rend(); ++image)
+	{
+		RunRows(image->m_height, [&](std::size_t first, std::size_t end)
+		{
+			BloomKernels::Upsample(*bloom, *image, first, end);
+		});
+		bloom = &*image;
+	}
+
+	RunRows(size.y, [&](std::size_t first, std::size_t end)
+	{
+		BloomKernels::Add(frame_pixels, *bloom, m_output_pixels.data(), size.x, first, end);
+	});
+
+	m_output_texture.update(m_output_pixels.data());
+	DrawOutput(m_output_texture, output);
+}
+
+void CpuBloomEffect::SetQuality(std::size_t downsamples, std::size_t blur_iterations)
+{
+	m_downsamples = std::max<std::size_t>(1, downsamples);
+	m_blur_iterations = blur_iterations;
+}
+
+void CpuBloomEffect::PrepareImages(sf::Vector2u size)
+{
+	if(m_output_texture.getSize() != size || m_prepared_downsamples != m_downsamples)
+	{
+		m_prepared_downsamples = m_downsamples;
+		m_output_texture.create(size.x, size.y);
+		m_output_texture.setSmooth(true);
+		m_output_pixels.resize(size.x * size.y * 4);
+
+		m_brightness_image.Resize(size.x, size.y);
+		m_scale_images.resize(m_downsamples - 1);
+		for(std::size_t i = 0; i < m_scale_images.size(); ++i)
+		{
+			m_scale_images[i].Resize(size.x >> (i + 1), size.y >> (i + 1));
+		}
+
+		sf::Vector2u firstpass_size(size.x >> m_downsamples, size.y >> m_downsamples);
+		m_firstpass_images[0].Resize(firstpass_size.x, firstpass_size.y);
+		m_firstpass_images[1].Resize(firstpass_size.x, firstpass_size.y);
+		m_secondpass_images[0].Resize(firstpass_size.x / 2, firstpass_size.y / 2);
+		m_secondpass_images[1].Resize(firstpass_size.x / 2, firstpass_size.y / 2);
+	}
+}
+
+void CpuBloomEffect::BlurMultipass(ImageArray& images)
+{
+	for(std::size_t count = 0; count < m_blur_iterations; ++count)
+	{
+		RunRows(images[1].m_height, [&](std::size_t first, std::size_t end)
+		{
+			BloomKernels::BlurVertical(images[0], images[1], first, end);
+		});
+		RunRows(images[0].m_height, [&](std::size_t first, std::size_t end)
+		{
+			BloomKernels::BlurHorizontal(images[1], images[0], first, end);
+		});
+	}
+}
+
+void CpuBloomEffect::DrawOutput(const sf::Texture& texture, sf::RenderTarget& output)
+{
+	//The input may be drawn at a lower resolution than the output, see QualitySettings::m_render_scale
+	sf::Sprite sprite(texture);
+	sprite.setScale(static_cast<float>(output.getSize().x) / texture.getSize().x, static_cast<float>(output.getSize().y) / texture.getSize().y);
+	output.draw(sprite, sf::BlendNone);
+}
+
+void CpuBloomEffect::RunRows(std::size_t row_count, const RowKernel& kernel)
+{
+	std::size_t job_count = (row_count + RowsPerJob - 1) / RowsPerJob;
+	m_jobs.ParallelFor(job_count, 1, [&](std::size_t job)
+	{
+		std::size_t first = job * RowsPerJob;
+		kernel(first, std::min(row_count, first + RowsPerJob));
+	});
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "PostEffect.hpp"
+#include "BloomKernels.hpp"
+
+#include <SFML/Graphics/Texture.hpp>
+
+#include <array>
+#include <functional>
+#include <vector>
+
+class JobSystem;
+
+//BloomEffect done on the CPU for machines without shaders. The frame is read back, run through the same
+//passes as the shaders with BloomKernels, rows shared out over the jobs, and drawn to the output as a texture
+class CpuBloomEffect : public PostEffect
+{
+public:
+	explicit CpuBloomEffect(JobSystem& jobs);
+
+	virtual void Apply(const sf::RenderTexture& input, sf::RenderTarget& output);
+	//See BloomEffect::SetQuality
+	void SetQuality(std::size_t downsamples, std::size_t blur_iterations);
+
+
+private:
+	typedef std::array<BloomKernels::Image, 2> ImageArray;
+	typedef std::function<void(std::size_t, std::size_t)> RowKernel;
+
+
+private:
+	void PrepareImages(sf::Vector2u size);
+	void BlurMultipass(ImageArray& images);
+	void DrawOutput(const sf::Texture& texture, sf::RenderTarget& output);
+	//Calls kernel with ranges of rows that cover [0, row_count) on as many threads as there are
+	void RunRows(std::size_t row_count, const RowKernel& kernel);
+
+
+private:
+	JobSystem& m_jobs;
+	std::size_t m_downsamples;
+	std::size_t m_blur_iterations;
+	std::size_t m_prepared_downsamples;
+
+	BloomKernels::Image m_brightness_image;
+	//Halvings of the bright pass on the way to the first octave, used again to scale the bloom back up
+	std::vector<BloomKernels::Image> m_scale_images;
+	ImageArray m_firstpass_images;
+	ImageArray m_secondpass_images;
+	std::vector<sf::Uint8> m_output_pixels;
+	sf::Texture m_output_texture;
+};
+
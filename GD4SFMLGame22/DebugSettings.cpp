@@ -0,0 +1,8 @@
+#include "DebugSettings.hpp"
+
+DebugSettings::DebugSettings()
+	: m_report_statistics(false)
+	, m_unbatched_sends(false)
+	, m_server_threads(0)
+{
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <cstddef>
+
+//Diagnostics switched on from the command line, see Main.cpp. Nothing here changes how the game plays
+struct DebugSettings
+{
+	DebugSettings();
+
+	//Print how long startup took and the timings and counters of the world and the server every few seconds
+	bool m_report_statistics;
+	//Servers write every packet to its socket straight away, which is how they used to behave, to compare against batching
+	bool m_unbatched_sends;
+	//Threads a server shares its peers out over, its own included. 0 leaves it to the server
+	std::size_t m_server_threads;
+};
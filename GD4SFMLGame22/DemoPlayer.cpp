@@ -0,0 +1,207 @@
+#include "DemoPlayer.hpp"
+#include "NetworkProtocol.hpp"
+
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	const std::size_t HeaderSize = sizeof(DEMO_MAGIC) + 4 + 4;
+	const std::size_t RecordHeaderSize = 8 + 4 + 1 + 4 + 4;
+}
+
+DemoPlayer::DemoPlayer()
+	: m_data(nullptr)
+	, m_size(0)
+	, m_read(0)
+#ifdef _WIN32
+	, m_file(INVALID_HANDLE_VALUE)
+	, m_mapping(nullptr)
+#else
+	, m_file(-1)
+#endif
+{
+}
+
+DemoPlayer::~DemoPlayer()
+{
+	Close();
+}
+
+bool DemoPlayer::Open(const std::string& path)
+{
+	Close();
+	if (!Map(path))
+	{
+		std::cout << "Could not open demo file " << path << std::endl;
+		return false;
+	}
+
+	if (m_size < HeaderSize || std::memcmp(m_data, DEMO_MAGIC, sizeof(DEMO_MAGIC)) != 0 || ReadInteger(sizeof(DEMO_MAGIC), 4) != DEMO_FORMAT_VERSION)
+	{
+		std::cout << path << " is not a demo file" << std::endl;
+		Close();
+		return false;
+	}
+
+	//Messages from another protocol version would be misread
+	sf::Uint64 protocol_version = ReadInteger(sizeof(DEMO_MAGIC) + 4, 4);
+	if (protocol_version != PROTOCOL_VERSION)
+	{
+		std::cout << path << " was recorded with protocol version " << protocol_version << ", this is version " << PROTOCOL_VERSION << std::endl;
+		Close();
+		return false;
+	}
+
+	m_read = HeaderSize;
+	return true;
+}
+
+void DemoPlayer::Close()
+{
+	Unmap();
+	m_read = 0;
+}
+
+bool DemoPlayer::PollMessage(sf::Time time, DemoMessage& message)
+{
+	if (IsFinished())
+	{
+		return false;
+	}
+
+	sf::Time record_time = sf::microseconds(static_cast<sf::Int64>(ReadInteger(m_read, 8)));
+	if (record_time > time)
+	{
+		return false;
+	}
+
+	message.m_time = record_time;
+	message.m_tick = static_cast<sf::Uint32>(ReadInteger(m_read + 8, 4));
+	message.m_direction = static_cast<DemoDirection>(ReadInteger(m_read + 12, 1));
+	message.m_connection = static_cast<sf::Uint32>(ReadInteger(m_read + 13, 4));
+	message.m_size = static_cast<std::size_t>(ReadInteger(m_read + 17, 4));
+	message.m_data = m_data + m_read + RecordHeaderSize;
+	m_read += RecordHeaderSize + message.m_size;
+	return true;
+}
+
+bool DemoPlayer::IsFinished() const
+{
+	//A record that was only partly written when the recording stopped is ignored
+	if (m_data == nullptr || m_size - m_read < RecordHeaderSize)
+	{
+		return true;
+	}
+	return m_size - m_read - RecordHeaderSize < ReadInteger(m_read + 17, 4);
+}
+
+sf::Uint64 DemoPlayer::ReadInteger(std::size_t offset, std::size_t bytes) const
+{
+	sf::Uint64 value = 0;
+	for (std::size_t i = 0; i < bytes; ++i)
+	{
+		value |= static_cast<sf::Uint64>(static_cast<unsigned char>(m_data[offset + i])) << (8 * i);
+	}
+	return value;
+}
+
+#ifdef _WIN32
+
+bool DemoPlayer::Map(const std::string& path)
+{
+	m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	LARGE_INTEGER size;
+	if (m_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_file, &size) || size.QuadPart == 0)
+	{
+		Unmap();
+		return false;
+	}
+
+	m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	void* view = m_mapping ? MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (!view)
+	{
+		Unmap();
+		return false;
+	}
+
+	m_data = static_cast<const char*>(view);
+	m_size = static_cast<std::size_t>(size.QuadPart);
+	return true;
+}
+
+void DemoPlayer::Unmap()
+{
+	if (m_data)
+	{
+		UnmapViewOfFile(m_data);
+	}
+	if (m_mapping)
+	{
+		CloseHandle(m_mapping);
+	}
+	if (m_file != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_file);
+	}
+
+	m_data = nullptr;
+	m_size = 0;
+	m_mapping = nullptr;
+	m_file = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+bool DemoPlayer::Map(const std::string& path)
+{
+	m_file = open(path.c_str(), O_RDONLY);
+	struct stat status;
+	if (m_file < 0 || fstat(m_file, &status) != 0 || status.st_size == 0)
+	{
+		Unmap();
+		return false;
+	}
+
+	void* view = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, m_file, 0);
+	if (view == MAP_FAILED)
+	{
+		Unmap();
+		return false;
+	}
+
+	//The file is read front to back exactly once
+	madvise(view, static_cast<std::size_t>(status.st_size), MADV_SEQUENTIAL);
+	m_data = static_cast<const char*>(view);
+	m_size = static_cast<std::size_t>(status.st_size);
+	return true;
+}
+
+void DemoPlayer::Unmap()
+{
+	if (m_data)
+	{
+		munmap(const_cast<char*>(m_data), m_size);
+	}
+	if (m_file >= 0)
+	{
+		close(m_file);
+	}
+
+	m_data = nullptr;
+	m_size = 0;
+	m_file = -1;
+}
+
+#endif
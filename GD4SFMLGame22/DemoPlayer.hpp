@@ -0,0 +1,54 @@
+#pragma once
+#include <SFML/Config.hpp>
+#include <SFML/System/NonCopyable.hpp>
+#include <SFML/System/Time.hpp>
+
+#include <cstddef>
+#include <string>
+
+#include "DemoRecorder.hpp"
+
+struct DemoMessage
+{
+	sf::Time m_time;
+	sf::Uint32 m_tick;
+	DemoDirection m_direction;
+	sf::Uint32 m_connection;
+	//Points into the mapped file, valid until the player is closed
+	const char* m_data;
+	std::size_t m_size;
+};
+
+//Plays back a file written by DemoRecorder. The file is memory mapped and read in place, so handing out a
+//message costs no system call and no copy however large the demo is
+
+class DemoPlayer : private sf::NonCopyable
+{
+public:
+	DemoPlayer();
+	~DemoPlayer();
+
+	bool Open(const std::string& path);
+	void Close();
+
+	//Hands out the next message if it was recorded at or before time
+	bool PollMessage(sf::Time time, DemoMessage& message);
+	//True once every complete record has been handed out
+	bool IsFinished() const;
+
+private:
+	bool Map(const std::string& path);
+	void Unmap();
+	sf::Uint64 ReadInteger(std::size_t offset, std::size_t bytes) const;
+
+private:
+	const char* m_data;
+	std::size_t m_size;
+	std::size_t m_read;
+#ifdef _WIN32
+	void* m_file;
+	void* m_mapping;
+#else
+	int m_file;
+#endif
+};
@@ -0,0 +1,93 @@
+#include "DemoRecorder.hpp"
+#include "NetworkProtocol.hpp"
+
+#include <iostream>
+
+namespace
+{
+	const std::size_t FlushSize = 64 * 1024;
+
+	void AppendInteger(std::vector<char>& buffer, sf::Uint64 value, std::size_t bytes)
+	{
+		for (std::size_t i = 0; i < bytes; ++i)
+		{
+			buffer.emplace_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+		}
+	}
+}
+
+DemoSettings::DemoSettings()
+	: m_playback_speed(1.f)
+{
+}
+
+DemoRecorder::DemoRecorder()
+{
+	m_buffer.reserve(FlushSize);
+}
+
+DemoRecorder::~DemoRecorder()
+{
+	Close();
+}
+
+bool DemoRecorder::Open(const std::string& path)
+{
+	Close();
+	m_file.open(path, std::ios::binary | std::ios::trunc);
+	if (!m_file)
+	{
+		std::cout << "Could not open demo file " << path << " for recording" << std::endl;
+		return false;
+	}
+
+	m_buffer.insert(m_buffer.end(), DEMO_MAGIC, DEMO_MAGIC + sizeof(DEMO_MAGIC));
+	AppendInteger(m_buffer, DEMO_FORMAT_VERSION, 4);
+	AppendInteger(m_buffer, PROTOCOL_VERSION, 4);
+	Flush();
+
+	m_clock.restart();
+	return true;
+}
+
+bool DemoRecorder::IsOpen() const
+{
+	return m_file.is_open();
+}
+
+void DemoRecorder::Close()
+{
+	if (m_file.is_open())
+	{
+		Flush();
+		m_file.close();
+	}
+}
+
+void DemoRecorder::Record(DemoDirection direction, sf::Uint32 tick, sf::Uint32 connection, const void* data, std::size_t size)
+{
+	if (!m_file.is_open())
+	{
+		return;
+	}
+
+	AppendInteger(m_buffer, static_cast<sf::Uint64>(m_clock.getElapsedTime().asMicroseconds()), 8);
+	AppendInteger(m_buffer, tick, 4);
+	AppendInteger(m_buffer, static_cast<sf::Uint8>(direction), 1);
+	AppendInteger(m_buffer, connection, 4);
+	AppendInteger(m_buffer, size, 4);
+	const char* bytes = static_cast<const char*>(data);
+	m_buffer.insert(m_buffer.end(), bytes, bytes + size);
+
+	if (m_buffer.size() >= FlushSize)
+	{
+		Flush();
+	}
+}
+
+void DemoRecorder::Flush()
+{
+	m_file.write(m_buffer.data(), m_buffer.size());
+	m_file.flush();
+	m_buffer.clear();
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <SFML/Config.hpp>
+#include <SFML/System/Clock.hpp>
+#include <SFML/System/NonCopyable.hpp>
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+
+//Demo files hold every message a client or server sent and received, in the order it happened:
+//	Header	- "GD4DEMO" and a zero byte, Uint32 DEMO_FORMAT_VERSION, Uint32 PROTOCOL_VERSION
+//	Records	- Int64 microseconds since recording started, Uint32 tick, Uint8 DemoDirection,
+//			  Uint32 connection, Uint32 size, then the message itself exactly as it went over the wire
+//All integers are little endian. Records are only ever appended, so a demo cut short by a crash can
+//still be played up to the last complete record
+
+const char DEMO_MAGIC[8] = { 'G', 'D', '4', 'D', 'E', 'M', 'O', '\0' };
+const sf::Uint32 DEMO_FORMAT_VERSION = 1;
+
+enum class DemoDirection
+{
+	Received,
+	Sent
+};
+
+struct DemoSettings
+{
+	DemoSettings();
+
+	//Empty when not recording
+	std::string m_record_path;
+	//A demo to play instead of showing the title screen
+	std::string m_playback_path;
+	float m_playback_speed;
+	//The draw calls of a demo played back are written here, so the rendering of two builds can be compared
+	std::string m_render_log_path;
+};
+
+class DemoRecorder : private sf::NonCopyable
+{
+public:
+	DemoRecorder();
+	~DemoRecorder();
+
+	bool Open(const std::string& path);
+	bool IsOpen() const;
+	void Close();
+
+	//Connection tells apart the peers of a server, or the successive connections of a client
+	void Record(DemoDirection direction, sf::Uint32 tick, sf::Uint32 connection, const void* data, std::size_t size);
+
+private:
+	void Flush();
+
+private:
+	std::ofstream m_file;
+	sf::Clock m_clock;
+	//Records are collected here and written in large blocks, not one small write per message
+	std::vector<char> m_buffer;
+};
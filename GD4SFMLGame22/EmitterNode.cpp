@@ -1,38 +1,20 @@
 #include "EmitterNode.hpp"
 #include "ParticleNode.hpp"
-#include "CommandQueue.hpp"
-#include "Command.hpp"
+#include "ParticleRegistry.hpp"
 
 
-EmitterNode::EmitterNode(ParticleType type)
+EmitterNode::EmitterNode(ParticleType type, const ParticleRegistry& particles)
 	: SceneNode()
 	, m_accumulated_time(sf::Time::Zero)
 	, m_type(type)
-	, m_particle_system(nullptr)
+	, m_particle_system(particles.Find(type))
+	, m_has_previous_position(false)
 {
 }
 
-void EmitterNode::UpdateCurrent(sf::Time dt, CommandQueue& commands)
+void EmitterNode::UpdateCurrent(sf::Time dt, CommandQueue&)
 {
-	if (m_particle_system)
-	{
-		EmitParticles(dt);
-	}
-	else
-	{
-		// Find particle node with the same type as emitter node
-		auto finder = [this](ParticleNode& container, sf::Time)
-		{
-			if (container.GetParticleType() == m_type)
-				m_particle_system = &container;
-		};
-
-		Command command;
-		command.category = Category::kParticleSystem;
-		command.action = DerivedAction<ParticleNode>(finder);
-
-		commands.Push(command);
-	}
+	EmitParticles(dt);
 }
 
 void EmitterNode::EmitParticles(sf::Time dt)
@@ -40,12 +22,30 @@ void EmitterNode::EmitParticles(sf::Time dt)
 	const float emissionRate = 30.f;
 	const sf::Time interval = sf::seconds(1.f) / emissionRate;
 
+	sf::Vector2f position = GetWorldPosition();
+	sf::Vector2f previous = m_has_previous_position ? m_previous_position : position;
+	m_previous_position = position;
+	m_has_previous_position = true;
+
+	if (!m_particle_system)
+		return;
+
 	m_accumulated_time += dt;
 
+	// Each particle is placed where the emitter was at the moment it is due, along the way the emitter moved
+	// this step, so long steps leave a continuous trail instead of clumps
 	while (m_accumulated_time > interval)
 	{
 		m_accumulated_time -= interval;
-		m_particle_system->AddParticle(GetWorldPosition());
+		float progress = 1.f - m_accumulated_time / dt;
+		m_positions.emplace_back(previous + (position - previous) * progress);
 	}
 }
 
+void EmitterNode::AddEmittedParticlesCurrent()
+{
+	// Emitters can be updated side by side, so the particle node is only fed once the update is over
+	for (sf::Vector2f position : m_positions)
+		m_particle_system->AddParticle(position);
+	m_positions.clear();
+}
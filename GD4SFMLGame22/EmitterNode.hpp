@@ -3,14 +3,20 @@
 #include "ParticleType.hpp"
 #include "SceneNode.hpp"
 
+#include <vector>
+
+class ParticleRegistry;
+
 class EmitterNode : public SceneNode
 {
 public:
-	explicit EmitterNode(ParticleType type);
+	// Feeds the particle node of the type registered in particles, emits nothing if there is none
+	EmitterNode(ParticleType type, const ParticleRegistry& particles);
 
 
 private:
 	virtual void UpdateCurrent(sf::Time dt, CommandQueue& commands);
+	virtual void AddEmittedParticlesCurrent();
 
 	void EmitParticles(sf::Time dt);
 
@@ -19,5 +25,8 @@ private:
 	sf::Time m_accumulated_time;
 	ParticleType m_type;
 	ParticleNode* m_particle_system;
+	sf::Vector2f m_previous_position;
+	bool m_has_previous_position;
+	// Emitted during the last update, added to the particle node by AddEmittedParticlesCurrent
+	std::vector<sf::Vector2f> m_positions;
 };
-
@@ -0,0 +1,7 @@
+#include "FrameTiming.hpp"
+
+FrameTiming::FrameTiming()
+	: m_step(0)
+	, m_interpolation(1.f)
+{
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include <SFML/Config.hpp>
+
+//Owned by Application and shared through State::Context. The simulation advances in fixed steps while
+//frames are drawn as often as the display allows, so a frame usually falls between two steps
+struct FrameTiming
+{
+	FrameTiming();
+
+	//Number of the simulation step that ran last
+	sf::Uint64 m_step;
+	//How far the next frame is from that step towards the next one, 0 to 1
+	float m_interpolation;
+};
@@ -2,21 +2,72 @@
 #include "NetworkProtocol.hpp"
 #include <SFML/System.hpp>
 
-#include <SFML/Network/Packet.hpp>
-
 #include "Aircraft.hpp"
+#include "KeyBinding.hpp"
 #include "PickupType.hpp"
 #include "Utility.hpp"
+#include "WireFormat.hpp"
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <limits>
+
+namespace
+{
+	//Poller key of the listening socket, every other key is the slot of a peer in m_peers or one of the keys below
+	const std::size_t ListenerKey = std::numeric_limits<std::size_t>::max();
+	const std::size_t LinkListenerKey = ListenerKey - 1;
+	//The link on side s has key FirstLinkKey + s
+	const std::size_t FirstLinkKey = LinkListenerKey - 2;
+	//No peer is connected in this slot
+	const std::size_t NoPeerSlot = std::numeric_limits<std::size_t>::max();
+
+	//A client that lets this much unsent data pile up is not reading and gets dropped
+	const std::size_t MaxPendingOutput = 1024 * 1024;
+
+	const sf::Time StatsReportInterval = sf::seconds(10.f);
+
+	//Below this many peers handing the work to other threads costs more than it saves
+	const std::size_t ParallelPeerThreshold = 4;
+	//The server shares the machine with the hosting client's game
+	const std::size_t MaxWorkerThreads = 3;
+
+	const sf::Time TimerResolution = sf::milliseconds(1);
+	const sf::Time FirstEnemySpawn = sf::seconds(5.f);
+
+	//Enemies are spawned this far above the battlefield so they fly into view
+	const float EnemySpawnDistance = 500.f;
+
+	//How far beyond the edges of the battlefield a client still wants updates
+	const float RelevanceMargin = 200.f;
+	const float RelevanceCellSize = 256.f;
+
+	//A client only moves to the next shard once its aircraft is this far into that shard's band, so one flying
+	//along the boundary does not bounce between the two
+	const float MigrationMargin = 100.f;
+	//How long a shard holds on to aircraft it took over for a client that has not shown up
+	const sf::Time HandoffTimeout = sf::seconds(5.f);
+	const sf::Time LinkRetryInterval = sf::seconds(1.f);
+	const sf::Time LinkConnectTimeout = sf::seconds(1.f);
+	const sf::Time LinkConnectPollInterval = sf::milliseconds(20);
+	//The fewest bytes an aircraft takes in a handoff: one byte varints, a 4 byte position and the input bits
+	const std::size_t MinHandoffAircraftSize = 9;
+}
 
 //It is essential to set the sockets to non-blocking - m_socket.setBlocking(false)
 //otherwise the server will hang waiting to read input from a connection
 
-GameServer::RemotePeer::RemotePeer():m_ready(false), m_timed_out(false)
+GameServer::RemotePeer::RemotePeer():m_slot(0), m_connection_number(0), m_flush_pending(false), m_timeout_timer(TimerWheel::InvalidTimer), m_ready(false), m_timed_out(false), m_migrating(false), m_migration_token(0), m_migration_shard(0)
 {
 	m_socket.setBlocking(false);
 }
 
-GameServer::GameServer(sf::Vector2f battlefield_size)
+GameServer::ShardLink::ShardLink():m_shard_index(0), m_connected(false), m_ready(false), m_connecting(false)
+{
+}
+
+GameServer::GameServer(sf::Vector2f battlefield_size, const ShardConfig& shard_config, const std::string& demo_path, const DebugSettings& debug_settings)
 	: m_thread(&GameServer::ExecutionThread, this)
 	, m_listening_state(false)
 	, m_client_timeout(sf::seconds(1.f))
@@ -26,14 +77,26 @@ GameServer::GameServer(sf::Vector2f battlefield_size)
 	, m_battlefield_rect(0.f, m_world_height-battlefield_size.y, battlefield_size.x, battlefield_size.y)
 	, m_battlefield_scrollspeed(-50.f)
 	, m_aircraft_count(0)
-	, m_peers(1)
-	, m_aircraft_identifier_counter(1)
+	, m_aircraft_grid(RelevanceCellSize)
+	, m_host_slot(NoPeerSlot)
+	, m_connection_counter(0)
+	//Every shard hands out different identifiers: 1 + index, 1 + index + count, ...
+	, m_aircraft_identifier_counter(static_cast<sf::Int32>(1 + shard_config.GetIndex()))
 	, m_waiting_thread_end(false)
-	, m_last_spawn_time(sf::Time::Zero)
-	, m_time_for_next_spawn(sf::seconds(5.f))
+	, m_batched_sends(!debug_settings.m_unbatched_sends)
+	, m_report_statistics(debug_settings.m_report_statistics)
+	, m_ticks_since_report(0)
+	, m_jobs(debug_settings.m_server_threads > 0 ? debug_settings.m_server_threads - 1 : std::min(JobSystem::GetSpareThreadCount(), MaxWorkerThreads))
+	, m_parallel_stage(false)
+	, m_timers(TimerResolution)
+	, m_peer_timed_out(false)
+	, m_shard_config(shard_config)
+	, m_migration_counter(0)
+	, m_demo_path(demo_path)
+	, m_tick_count(0)
 {
 	m_listener_socket.setBlocking(false);
-	m_peers[0].reset(new RemotePeer());
+	m_link_listener.setBlocking(false);
 	m_thread.launch();
 }
 
@@ -47,37 +110,26 @@ GameServer::~GameServer()
 
 void GameServer::NotifyPlayerSpawn(sf::Int32 aircraft_identifier)
 {
-	sf::Packet packet;
+	Wire::Writer message = BeginMessage();
 	//First thing for every packet is what type of packet it is
-	packet << static_cast<sf::Int32>(Server::PacketType::PlayerConnect);
-	packet << aircraft_identifier << m_aircraft_info[aircraft_identifier].m_position.x << m_aircraft_info[aircraft_identifier].m_position.y;
-	for(std::size_t i=0; i < m_connected_players; ++i)
-	{
-		if(m_peers[i]->m_ready)
-		{
-			m_peers[i]->m_socket.send(packet);
-		}
-	}
+	message << Wire::Tag(Server::PacketType::PlayerConnect);
+	message << Wire::VarInt(aircraft_identifier) << Wire::Position(m_aircraft_info[aircraft_identifier].m_position);
+	SendToAll(message);
+	MarkRelevantToAll(aircraft_identifier);
 }
 
 //This is the same as PlayerEvent, but for real-time actions. This means that we are changing an ongoing state to either true or false, so we add a Boolean value to the parameters
 
 void GameServer::NotifyPlayerRealtimeChange(sf::Int32 aircraft_identifier, sf::Int32 action, bool action_enabled)
 {
-	sf::Packet packet;
+	Wire::Writer message = BeginMessage();
 	//First thing for every packet is what type of packet it is
-	packet << static_cast<sf::Int32>(Server::PacketType::PlayerRealtimeChange);
-	packet << aircraft_identifier;
-	packet << action;
-	packet << action_enabled;
-
-	for (std::size_t i = 0; i < m_connected_players; ++i)
-	{
-		if (m_peers[i]->m_ready)
-		{
-			m_peers[i]->m_socket.send(packet);
-		}
-	}
+	message << Wire::Tag(Server::PacketType::PlayerRealtimeChange);
+	message << Wire::VarInt(aircraft_identifier);
+	message << Wire::VarInt(action);
+	message << Wire::Flags(action_enabled);
+	SendToAll(message);
+	RelayToShards(message, m_aircraft_info[aircraft_identifier].m_position);
 }
 
 //This takes two sf::Int32 variables, the aircraft identifier and the action identifier
@@ -86,19 +138,13 @@ void GameServer::NotifyPlayerRealtimeChange(sf::Int32 aircraft_identifier, sf::I
 
 void GameServer::NotifyPlayerEvent(sf::Int32 aircraft_identifier, sf::Int32 action)
 {
-	sf::Packet packet;
+	Wire::Writer message = BeginMessage();
 	//First thing for every packet is what type of packet it is
-	packet << static_cast<sf::Int32>(Server::PacketType::PlayerEvent);
-	packet << aircraft_identifier;
-	packet << action;
-
-	for (std::size_t i = 0; i < m_connected_players; ++i)
-	{
-		if (m_peers[i]->m_ready)
-		{
-			m_peers[i]->m_socket.send(packet);
-		}
-	}
+	message << Wire::Tag(Server::PacketType::PlayerEvent);
+	message << Wire::VarInt(aircraft_identifier);
+	message << Wire::VarInt(action);
+	SendToAll(message);
+	RelayToShards(message, m_aircraft_info[aircraft_identifier].m_position);
 }
 
 void GameServer::SetListening(bool enable)
@@ -108,11 +154,19 @@ void GameServer::SetListening(bool enable)
 	{
 		if (!m_listening_state)
 		{
-			m_listening_state = (m_listener_socket.listen(SERVER_PORT) == sf::TcpListener::Done);
+			m_listening_state = (m_listener_socket.listen(m_shard_config.GetClientPort(m_shard_config.GetIndex())) == sf::TcpListener::Done);
+			if (m_listening_state)
+			{
+				m_poller.Add(m_listener_socket, ListenerKey);
+			}
 		}
 	}
 	else
 	{
+		if (m_listening_state)
+		{
+			m_poller.Remove(m_listener_socket);
+		}
 		m_listener_socket.close();
 		m_listening_state = false;
 	}
@@ -121,7 +175,20 @@ void GameServer::SetListening(bool enable)
 
 void GameServer::ExecutionThread()
 {
+	//Opened here so that the recorder is only ever touched by the server thread
+	if(!m_demo_path.empty())
+	{
+		m_demo_recorder.Open(m_demo_path);
+	}
+
 	SetListening(true);
+	if(m_shard_config.IsSharded())
+	{
+		StartShardLinks();
+	}
+
+	m_timers.Schedule(Now() + FirstEnemySpawn, [this] { SpawnEnemyWave(); });
+	m_timers.Schedule(Now() + StatsReportInterval, [this] { ReportTransportStats(); });
 
 	sf::Time frame_rate = sf::seconds(1.f / 60.f);
 	sf::Time frame_time = sf::Time::Zero;
@@ -131,8 +198,46 @@ void GameServer::ExecutionThread()
 
 	while(!m_waiting_thread_end)
 	{
-		HandleIncomingConnections();
-		HandleIncomingPackets();
+		//Sleep until a socket has something for us, the next tick is due or a timer expires, then only visit the sockets that woke us
+		sf::Time timeout = tick_rate - tick_time - tick_clock.getElapsedTime();
+		sf::Time next_deadline;
+		if(m_timers.GetNextDeadline(next_deadline))
+		{
+			timeout = std::min(timeout, next_deadline - Now());
+		}
+
+		m_ready_sockets.clear();
+		m_poller.Wait(timeout, m_ready_sockets);
+
+		bool detected_timeout = false;
+		for(std::size_t key : m_ready_sockets)
+		{
+			if(key == ListenerKey)
+			{
+				HandleIncomingConnections();
+			}
+			else if(key == LinkListenerKey)
+			{
+				HandleIncomingLink();
+			}
+			else if(key >= FirstLinkKey)
+			{
+				HandleLinkPackets(static_cast<LinkSide>(key - FirstLinkKey));
+			}
+			else if(m_peers[key])
+			{
+				HandleIncomingPackets(*m_peers[key], detected_timeout);
+			}
+		}
+
+		//Timeouts, enemy waves and other scheduled work
+		m_timers.Advance(Now());
+
+		if(detected_timeout || m_peer_timed_out)
+		{
+			m_peer_timed_out = false;
+			HandleDisconnections();
+		}
 
 		frame_time += frame_clock.getElapsedTime();
 		frame_clock.restart();
@@ -150,26 +255,36 @@ void GameServer::ExecutionThread()
 		//Fixed tick step
 		while(tick_time >= tick_rate)
 		{
+			sf::Clock cpu_clock;
 			Tick();
+			m_tick_cpu_time += cpu_clock.getElapsedTime();
+			m_ticks_since_report++;
 			tick_time -= tick_rate;
 		}
 
-		//sleep
-		sf::sleep(sf::milliseconds(100));
-
+		//Everything queued during this iteration leaves in one write per peer
+		FlushPeers();
 	}
 }
 
 void GameServer::Tick()
 {
-	UpdateClientState();
+	m_tick_count++;
+
+	if(m_shard_config.IsSharded())
+	{
+		CheckMigrations();
+		SendWorldState();
+	}
+
+	UpdatePeers();
 
 	//Check if the game is over = all planes position.y < offset
 	bool all_aircraft_done = true;
 	for(const auto& current : m_aircraft_info)
 	{
 		//As long one player has not crossed the finish line game on
-		if(current.second.m_position.y > 0.f)
+		if(IsLocalAircraft(current.second) && current.second.m_position.y > 0.f)
 		{
 			all_aircraft_done = false;
 		}
@@ -177,15 +292,15 @@ void GameServer::Tick()
 
 	if(all_aircraft_done)
 	{
-		sf::Packet mission_success_packet;
-		mission_success_packet << static_cast<sf::Int32>(Server::PacketType::MissionSuccess);
-		SendToAll(mission_success_packet);
+		Wire::Writer mission_success_message = BeginMessage();
+		mission_success_message << Wire::Tag(Server::PacketType::MissionSuccess);
+		SendToAll(mission_success_message);
 	}
 
-	//Remove aircraft that have been destroyed
+	//Remove aircraft that have been destroyed, copies from other shards go when their owner stops sending them
 	for (auto itr = m_aircraft_info.begin(); itr != m_aircraft_info.end();)
 	{
-		if(itr->second.m_hitpoints <= 0)
+		if(IsLocalAircraft(itr->second) && itr->second.m_hitpoints <= 0)
 		{
 			m_aircraft_info.erase(itr++);
 		}
@@ -194,45 +309,54 @@ void GameServer::Tick()
 			++itr;
 		}
 	}
+}
 
-	//Check if it is time to spawn enemies
-	if(Now() >= m_time_for_next_spawn + m_last_spawn_time)
+void GameServer::SpawnEnemyWave()
+{
+	//Not going to spawn enemies near the end
+	if(m_battlefield_rect.top <= 600.f)
 	{
-		//Not going to spawn enemies near the end
-		if(m_battlefield_rect.top > 600.f)
-		{
-			std::size_t enemy_count = 1 + Utility::RandomInt(2);
-			float spawn_centre = static_cast<float>(Utility::RandomInt(500) - 250);
+		return;
+	}
 
-			//If there is only one enemy it is at the spawn_centre
-			float plane_distance = 0.f;
-			float next_spawn_position = spawn_centre;
+	//Every shard runs this timer, only the one that owns the band the enemies appear in spawns them
+	float spawn_height = m_battlefield_rect.top - EnemySpawnDistance;
+	if(m_shard_config.GetShardAt(spawn_height, m_world_height) == m_shard_config.GetIndex())
+	{
+		std::size_t enemy_count = 1 + Utility::RandomInt(2);
+		float spawn_centre = static_cast<float>(Utility::RandomInt(500) - 250);
 
-			//If there are two then they are centred on the spawn centre
-			if(enemy_count == 2)
-			{
-				plane_distance = static_cast<float>(150 + Utility::RandomInt(250));
-				next_spawn_position = spawn_centre - plane_distance / 2.f;
-			}
+		//If there is only one enemy it is at the spawn_centre
+		float plane_distance = 0.f;
+		float next_spawn_position = spawn_centre;
 
-			//TODO Do we really need two packets here?
-			//Send a spawn packet to the clients
-			for (std::size_t i = 0; i < enemy_count; ++i)
-			{
-				sf::Packet packet;
-				packet << static_cast<sf::Int32>(Server::PacketType::SpawnEnemy);
-				packet << static_cast<sf::Int32>(1 + Utility::RandomInt(static_cast<int>(AircraftType::kAircraftCount) - 1));
-				packet << m_world_height - m_battlefield_rect.top + 500;
-				packet << next_spawn_position;
-
-				next_spawn_position += plane_distance / 2.f;
-				SendToAll(packet);
-			}
+		//If there are two then they are centred on the spawn centre
+		if(enemy_count == 2)
+		{
+			plane_distance = static_cast<float>(150 + Utility::RandomInt(250));
+			next_spawn_position = spawn_centre - plane_distance / 2.f;
+		}
 
-			m_last_spawn_time = Now();
-			m_time_for_next_spawn = sf::milliseconds(2000 + Utility::RandomInt(6000));
+		//TODO Do we really need two packets here?
+		//Send a spawn packet to the clients
+		for (std::size_t i = 0; i < enemy_count; ++i)
+		{
+			Wire::Writer message = BeginMessage();
+			message << Wire::Tag(Server::PacketType::SpawnEnemy);
+			message << Wire::VarInt(1 + Utility::RandomInt(static_cast<int>(AircraftType::kAircraftCount) - 1));
+			message << Wire::CoordinateY(m_world_height - m_battlefield_rect.top + EnemySpawnDistance);
+			message << Wire::CoordinateX(next_spawn_position);
+
+			//Clients place the enemy relative to the centre of the battlefield
+			sf::Vector2f spawn_position(m_battlefield_rect.left + m_battlefield_rect.width / 2.f + next_spawn_position, m_battlefield_rect.top - EnemySpawnDistance);
+
+			next_spawn_position += plane_distance / 2.f;
+			SendToRelevantPeers(message, spawn_position);
+			RelayToShards(message, spawn_position);
 		}
 	}
+
+	m_timers.Schedule(Now() + sf::milliseconds(2000 + Utility::RandomInt(6000)), [this] { SpawnEnemyWave(); });
 }
 
 sf::Time GameServer::Now() const
@@ -240,70 +364,152 @@ sf::Time GameServer::Now() const
 	return m_clock.getElapsedTime();
 }
 
-void GameServer::HandleIncomingPackets()
+//The poller is edge-triggered, so a readable socket has to be drained completely before we move on
+
+void GameServer::HandleIncomingPackets(RemotePeer& peer, bool& detected_timeout)
 {
-	bool detected_timeout = false;
+	sf::Socket::Status status = peer.m_transport.Receive(peer.m_socket, m_transport_stats);
 
-	for(PeerPtr& peer : m_peers)
+	//Packets are read in place from the receive buffer
+	Wire::Reader packet;
+	while(peer.m_transport.PollFrame(packet))
 	{
-		if(peer->m_ready)
-		{
-			sf::Packet packet;
-			while(peer->m_socket.receive(packet) == sf::Socket::Done)
-			{
-				//Interpret the packet and react to it
-				HandleIncomingPacket(packet, *peer, detected_timeout);
+		m_demo_recorder.Record(DemoDirection::Received, m_tick_count, static_cast<sf::Uint32>(peer.m_slot), packet.GetRemainingData(), packet.GetRemainingSize());
 
-				peer->m_last_packet_time = Now();
-				packet.clear();
-			}
+		//Interpret the packet and react to it
+		HandleIncomingPacket(packet, peer, detected_timeout);
 
-			if(Now() > peer->m_last_packet_time + m_client_timeout)
-			{
-				peer->m_timed_out = true;
-				detected_timeout = true;
-			}
+		peer.m_last_packet_time = Now();
+		m_transport_stats.m_packets_received++;
+	}
 
-		}
+	//The client closed the connection, no need to wait for the timeout
+	if(status == sf::Socket::Disconnected || status == sf::Socket::Error)
+	{
+		peer.m_timed_out = true;
+		detected_timeout = true;
 	}
+}
 
-	if(detected_timeout)
+//Turns a tick of input into the realtime changes and one-shot events the clients already understand.
+//Every tick carries the full input state, so ticks lost beyond the history only lose one-shot actions
+
+void GameServer::ApplyPlayerInput(sf::Int32 aircraft_identifier, sf::Uint32 tick, sf::Uint8 input)
+{
+	auto found = m_aircraft_info.find(aircraft_identifier);
+	if (found == m_aircraft_info.end() || tick < found->second.m_next_input_tick)
 	{
-		HandleDisconnections();
+		return;
+	}
+
+	AircraftInfo& aircraft = found->second;
+	sf::Uint8 changed = input ^ aircraft.m_input;
+	for (int i = 0; i < static_cast<int>(PlayerAction::kActionCount); ++i)
+	{
+		sf::Uint8 bit = static_cast<sf::Uint8>(1 << i);
+		if (IsRealtimeAction(static_cast<PlayerAction>(i)))
+		{
+			if (changed & bit)
+			{
+				NotifyPlayerRealtimeChange(aircraft_identifier, i, (input & bit) != 0);
+			}
+		}
+		else if (input & bit)
+		{
+			NotifyPlayerEvent(aircraft_identifier, i);
+		}
 	}
 
+	aircraft.m_input = input;
+	aircraft.m_next_input_tick = tick + 1;
 }
 
-void GameServer::HandleIncomingPacket(sf::Packet& packet, RemotePeer& receiving_peer, bool& detected_timeout)
+//Receiving a packet only updates m_last_packet_time. When the timer fires it is pushed back to the new
+//deadline instead, so busy peers cost one timer operation per timeout period rather than one per packet
+
+void GameServer::ScheduleTimeout(RemotePeer& peer)
 {
-	sf::Int32 packet_type;
-	packet >> packet_type;
+	std::size_t slot = peer.m_slot;
+	peer.m_timeout_timer = m_timers.Schedule(peer.m_last_packet_time + m_client_timeout, [this, slot] { CheckPeerTimeout(slot); });
+}
 
-	switch (static_cast<Client::PacketType> (packet_type))
+void GameServer::CheckPeerTimeout(std::size_t slot)
+{
+	//The timer is cancelled when the peer disconnects, so the slot still holds the same peer
+	RemotePeer& peer = *m_peers[slot];
+	if(Now() > peer.m_last_packet_time + m_client_timeout)
 	{
-	case Client::PacketType::Quit:
+		peer.m_timeout_timer = TimerWheel::InvalidTimer;
+		peer.m_timed_out = true;
+		m_peer_timed_out = true;
+	}
+	else
 	{
-		receiving_peer.m_timed_out = true;
-		detected_timeout = true;
+		ScheduleTimeout(peer);
 	}
-	break;
+}
 
-	case Client::PacketType::PlayerEvent:
+void GameServer::HandleIncomingPacket(Wire::Reader& packet, RemotePeer& receiving_peer, bool& detected_timeout)
+{
+	Client::PacketType packet_type;
+	if (!(packet >> Wire::Tag(packet_type)))
 	{
-		sf::Int32 aircraft_identifier;
-		sf::Int32 action;
-		packet >> aircraft_identifier >> action;
-		NotifyPlayerEvent(aircraft_identifier, action);
+		return;
+	}
+
+	//Until the client has said hello in our protocol version nothing else it sends can be understood
+	if (!receiving_peer.m_ready)
+	{
+		if (packet_type == Client::PacketType::Hello)
+		{
+			sf::Uint32 version = 0;
+			packet >> Wire::VarInt(version);
+			if (version == PROTOCOL_VERSION)
+			{
+				sf::Uint32 migration_token = 0;
+				packet >> Wire::VarInt(migration_token);
+				auto handoff = m_pending_handoffs.find(migration_token);
+				if (migration_token == 0)
+				{
+					AcceptPlayer(receiving_peer);
+				}
+				else if (handoff != m_pending_handoffs.end())
+				{
+					m_timers.Cancel(handoff->second.m_expiry_timer);
+					AcceptMigratedPlayer(receiving_peer, handoff->second);
+					m_pending_handoffs.erase(handoff);
+				}
+				else
+				{
+					//Took too long, its aircraft were already removed
+					receiving_peer.m_timed_out = true;
+					detected_timeout = true;
+				}
+			}
+			else
+			{
+				std::cout << "Rejecting client with protocol version " << version << std::endl;
+				Wire::Writer frame = receiving_peer.m_transport.BeginFrame();
+				frame << Wire::Tag(Server::PacketType::ProtocolMismatch) << Wire::VarInt(PROTOCOL_VERSION);
+				EndFrame(receiving_peer);
+				receiving_peer.m_transport.Flush(receiving_peer.m_socket, m_transport_stats);
+				receiving_peer.m_timed_out = true;
+				detected_timeout = true;
+			}
+		}
+		return;
 	}
+
+	switch (packet_type)
+	{
+	//Only expected once, before the client is ready
+	case Client::PacketType::Hello:
 	break;
 
-	case Client::PacketType::PlayerRealtimeChange:
+	case Client::PacketType::Quit:
 	{
-		sf::Int32 aircraft_identifier;
-		sf::Int32 action;
-		bool action_enabled;
-		packet >> aircraft_identifier >> action >> action_enabled;
-		NotifyPlayerRealtimeChange(aircraft_identifier, action, action_enabled);
+		receiving_peer.m_timed_out = true;
+		detected_timeout = true;
 	}
 	break;
 
@@ -313,40 +519,39 @@ void GameServer::HandleIncomingPacket(sf::Packet& packet, RemotePeer& receiving_
 		m_aircraft_info[m_aircraft_identifier_counter].m_position = sf::Vector2f(m_battlefield_rect.width / 2, m_battlefield_rect.top + m_battlefield_rect.height / 2);
 		m_aircraft_info[m_aircraft_identifier_counter].m_hitpoints = 100;
 		m_aircraft_info[m_aircraft_identifier_counter].m_missile_ammo = 2;
+		m_aircraft_info[m_aircraft_identifier_counter].m_owner_shard = m_shard_config.GetIndex();
 
-		sf::Packet request_packet;
-		request_packet << static_cast<sf::Int32>(Server::PacketType::AcceptCoopPartner);
-		request_packet << m_aircraft_identifier_counter;
-		request_packet << m_aircraft_info[m_aircraft_identifier_counter].m_position.x;
-		request_packet << m_aircraft_info[m_aircraft_identifier_counter].m_position.y;
-
-		receiving_peer.m_socket.send(request_packet);
+		Wire::Writer request_frame = receiving_peer.m_transport.BeginFrame();
+		request_frame << Wire::Tag(Server::PacketType::AcceptCoopPartner);
+		request_frame << Wire::VarInt(m_aircraft_identifier_counter);
+		request_frame << Wire::Position(m_aircraft_info[m_aircraft_identifier_counter].m_position);
+		EndFrame(receiving_peer);
 		m_aircraft_count++;
 
 		// Tell everyone else about the new plane
-		sf::Packet notify_packet;
-		notify_packet << static_cast<sf::Int32>(Server::PacketType::PlayerConnect);
-		notify_packet << m_aircraft_identifier_counter;
-		notify_packet << m_aircraft_info[m_aircraft_identifier_counter].m_position.x;
-		notify_packet << m_aircraft_info[m_aircraft_identifier_counter].m_position.y;
+		Wire::Writer notify_message = BeginMessage();
+		notify_message << Wire::Tag(Server::PacketType::PlayerConnect);
+		notify_message << Wire::VarInt(m_aircraft_identifier_counter);
+		notify_message << Wire::Position(m_aircraft_info[m_aircraft_identifier_counter].m_position);
 
 		for (PeerPtr& peer : m_peers)
 		{
-			if (peer.get() != &receiving_peer && peer->m_ready)
+			if (peer && peer.get() != &receiving_peer && peer->m_ready)
 			{
 
-				peer->m_socket.send(notify_packet);
+				SendToPeer(*peer, notify_message);
 			}
 		}
 
-		m_aircraft_identifier_counter++;
+		MarkRelevantToAll(m_aircraft_identifier_counter);
+		m_aircraft_identifier_counter += static_cast<sf::Int32>(m_shard_config.GetCount());
 	}
 	break;
 
 	case Client::PacketType::PositionUpdate:
 	{
 		sf::Int32 num_aircraft;
-		packet >> num_aircraft;
+		packet >> Wire::VarInt(num_aircraft);
 
 		for (sf::Int32 i = 0; i < num_aircraft; ++i)
 		{
@@ -354,10 +559,40 @@ void GameServer::HandleIncomingPacket(sf::Packet& packet, RemotePeer& receiving_
 			sf::Int32 aircraft_hitpoints;
 			sf::Int32 missile_ammo;
 			sf::Vector2f aircraft_position;
-			packet >> aircraft_identifier >> aircraft_position.x >> aircraft_position.y >> aircraft_hitpoints >> missile_ammo;
-			m_aircraft_info[aircraft_identifier].m_position = aircraft_position;
-			m_aircraft_info[aircraft_identifier].m_hitpoints = aircraft_hitpoints;
-			m_aircraft_info[aircraft_identifier].m_missile_ammo = missile_ammo;
+			packet >> Wire::VarInt(aircraft_identifier) >> Wire::Position(aircraft_position) >> Wire::VarInt(aircraft_hitpoints) >> Wire::VarInt(missile_ammo);
+
+			//The input history comes newest first, apply it oldest first
+			sf::Uint32 newest_tick;
+			sf::Uint32 input_count;
+			packet >> Wire::VarInt(newest_tick) >> Wire::VarInt(input_count);
+			if (!packet || input_count > INPUT_HISTORY_SIZE)
+			{
+				break;
+			}
+
+			std::array<sf::Uint8, INPUT_HISTORY_SIZE> inputs;
+			for (sf::Uint32 j = 0; j < input_count; ++j)
+			{
+				packet >> inputs[j];
+			}
+
+			//Aircraft that belong to another shard are only updated by that shard
+			auto found = m_aircraft_info.find(aircraft_identifier);
+			if (found != m_aircraft_info.end() && !IsLocalAircraft(found->second))
+			{
+				continue;
+			}
+
+			AircraftInfo& aircraft = m_aircraft_info[aircraft_identifier];
+			aircraft.m_position = aircraft_position;
+			aircraft.m_hitpoints = aircraft_hitpoints;
+			aircraft.m_missile_ammo = missile_ammo;
+			aircraft.m_owner_shard = m_shard_config.GetIndex();
+
+			for (sf::Uint32 j = input_count; j > 0 && packet; --j)
+			{
+				ApplyPlayerInput(aircraft_identifier, newest_tick - (j - 1), inputs[j - 1]);
+			}
 		}
 	}
 	break;
@@ -365,24 +600,20 @@ void GameServer::HandleIncomingPacket(sf::Packet& packet, RemotePeer& receiving_
 	case Client::PacketType::GameEvent:
 	{
 		sf::Int32 action;
-		float x;
-		float y;
-
-		packet >> action;
-		packet >> x;
-		packet >> y;
+		sf::Vector2f position;
+		packet >> Wire::VarInt(action) >> Wire::Position(position);
 
 		//Enemy explodes, with a certain probability, drop a pickup
 		//To avoid multiple messages only listen to the first peer (host)
-		if (action == GameActions::EnemyExplode && Utility::RandomInt(3) == 0 && &receiving_peer == m_peers[0].get())
+		if (action == GameActions::EnemyExplode && Utility::RandomInt(3) == 0 && receiving_peer.m_slot == m_host_slot)
 		{
-			sf::Packet packet;
-			packet << static_cast<sf::Int32>(Server::PacketType::SpawnPickup);
-			packet << static_cast<sf::Int32>(Utility::RandomInt(static_cast<int>(PickupType::kPickupCount)));
-			packet << x;
-			packet << y;
+			Wire::Writer message = BeginMessage();
+			message << Wire::Tag(Server::PacketType::SpawnPickup);
+			message << Wire::VarInt(Utility::RandomInt(static_cast<int>(PickupType::kPickupCount)));
+			message << Wire::Position(position);
 
-			SendToAll(packet);
+			SendToRelevantPeers(message, position);
+			RelayToShards(message, position);
 		}
 	}
 	}
@@ -391,142 +622,1105 @@ void GameServer::HandleIncomingPacket(sf::Packet& packet, RemotePeer& receiving_
 
 void GameServer::HandleIncomingConnections()
 {
-	if(!m_listening_state)
+	//Accept everything that is pending, one wakeup can carry several connections
+	while(m_listening_state)
 	{
-		return;
-	}
-
-	if(m_listener_socket.accept(m_peers[m_connected_players]->m_socket) == sf::TcpListener::Done)
-	{
-		//Order the new client to spawn its player 1
-		m_aircraft_info[m_aircraft_identifier_counter].m_position = sf::Vector2f(m_battlefield_rect.width / 2, m_battlefield_rect.top + m_battlefield_rect.height / 2);
-		m_aircraft_info[m_aircraft_identifier_counter].m_hitpoints = 100;
-		m_aircraft_info[m_aircraft_identifier_counter].m_missile_ammo = 2;
-
-		sf::Packet packet;
-		packet << static_cast<sf::Int32>(Server::PacketType::SpawnSelf);
-		packet << m_aircraft_identifier_counter;
-		packet << m_aircraft_info[m_aircraft_identifier_counter].m_position.x;
-		packet << m_aircraft_info[m_aircraft_identifier_counter].m_position.y;
-
-		m_peers[m_connected_players]->m_aircraft_identifiers.emplace_back(m_aircraft_identifier_counter);
-
-		BroadcastMessage("New player");
-		InformWorldState(m_peers[m_connected_players]->m_socket);
-		NotifyPlayerSpawn(m_aircraft_identifier_counter++);
+		PeerPtr peer(new RemotePeer());
+		if(m_listener_socket.accept(peer->m_socket) != sf::TcpListener::Done)
+		{
+			return;
+		}
 
-		m_peers[m_connected_players]->m_socket.send(packet);
-		m_peers[m_connected_players]->m_ready = true;
-		m_peers[m_connected_players]->m_last_packet_time = Now();
+		//The peer joins the game once its hello arrives, see AcceptPlayer
+		std::size_t slot = AllocatePeerSlot();
+		peer->m_slot = slot;
+		peer->m_connection_number = m_connection_counter++;
+		peer->m_last_packet_time = Now();
+		m_poller.Add(peer->m_socket, slot);
+		ScheduleTimeout(*peer);
+		m_peers[slot] = std::move(peer);
+		if(m_host_slot == NoPeerSlot)
+		{
+			m_host_slot = slot;
+		}
 
-		m_aircraft_count++;
 		m_connected_players++;
 
 		if(m_connected_players >= m_max_connected_players)
 		{
 			SetListening(false);
 		}
-		else
+	}
+}
+
+void GameServer::AcceptPlayer(RemotePeer& peer)
+{
+	//Order the new client to spawn its player 1
+	m_aircraft_info[m_aircraft_identifier_counter].m_position = sf::Vector2f(m_battlefield_rect.width / 2, m_battlefield_rect.top + m_battlefield_rect.height / 2);
+	m_aircraft_info[m_aircraft_identifier_counter].m_hitpoints = 100;
+	m_aircraft_info[m_aircraft_identifier_counter].m_missile_ammo = 2;
+	m_aircraft_info[m_aircraft_identifier_counter].m_owner_shard = m_shard_config.GetIndex();
+
+	sf::Int32 aircraft_identifier = m_aircraft_identifier_counter;
+	m_aircraft_identifier_counter += static_cast<sf::Int32>(m_shard_config.GetCount());
+	peer.m_aircraft_identifiers.emplace_back(aircraft_identifier);
+
+	BroadcastMessage("New player");
+	InformWorldState(peer);
+	NotifyPlayerSpawn(aircraft_identifier);
+
+	//The initial state told the new client about the aircraft of every other player and SpawnSelf about its own,
+	//anything else comes in with AircraftEnter
+	for(const PeerPtr& other : m_peers)
+	{
+		if(other && other->m_ready)
+		{
+			peer.m_relevant_aircraft.insert(peer.m_relevant_aircraft.end(), other->m_aircraft_identifiers.begin(), other->m_aircraft_identifiers.end());
+		}
+	}
+	peer.m_relevant_aircraft.emplace_back(aircraft_identifier);
+	std::sort(peer.m_relevant_aircraft.begin(), peer.m_relevant_aircraft.end());
+	peer.m_relevance_rect = ComputeRelevanceRect();
+
+	Wire::Writer frame = peer.m_transport.BeginFrame();
+	frame << Wire::Tag(Server::PacketType::SpawnSelf);
+	frame << Wire::VarInt(aircraft_identifier);
+	frame << Wire::Position(m_aircraft_info[aircraft_identifier].m_position);
+	EndFrame(peer);
+	peer.m_ready = true;
+
+	m_aircraft_count++;
+}
+
+std::size_t GameServer::AllocatePeerSlot()
+{
+	if(m_free_peer_slots.empty())
+	{
+		m_peers.emplace_back(nullptr);
+		return m_peers.size() - 1;
+	}
+
+	std::size_t slot = m_free_peer_slots.back();
+	m_free_peer_slots.pop_back();
+	return slot;
+}
+
+std::size_t GameServer::FindOldestPeerSlot() const
+{
+	std::size_t oldest = NoPeerSlot;
+	for(std::size_t slot = 0; slot < m_peers.size(); ++slot)
+	{
+		if(m_peers[slot] && (oldest == NoPeerSlot || m_peers[slot]->m_connection_number < m_peers[oldest]->m_connection_number))
 		{
-			m_peers.emplace_back(PeerPtr(new RemotePeer()));
+			oldest = slot;
 		}
 	}
+	return oldest;
 }
 
 void GameServer::HandleDisconnections()
 {
-	for(auto itr = m_peers.begin(); itr != m_peers.end();)
+	for(std::size_t slot = 0; slot < m_peers.size(); ++slot)
 	{
-		if((*itr)->m_timed_out)
+		PeerPtr& peer = m_peers[slot];
+		if(peer && peer->m_timed_out)
 		{
+			bool was_ready = peer->m_ready;
+
 			//Inform everyone of a disconnection, erase
-			for(sf::Int32 identifer : (*itr)->m_aircraft_identifiers)
+			for(sf::Int32 identifer : peer->m_aircraft_identifiers)
 			{
-				SendToAll((sf::Packet() << static_cast<sf::Int32>(Server::PacketType::PlayerDisconnect) << identifer));
+				Wire::Writer message = BeginMessage();
+				message << Wire::Tag(Server::PacketType::PlayerDisconnect) << Wire::VarInt(identifer);
+				SendToAll(message);
 				m_aircraft_info.erase(identifer);
 			}
 
 			m_connected_players--;
-			m_aircraft_count -= (*itr)->m_aircraft_identifiers.size();
+			m_aircraft_count -= peer->m_aircraft_identifiers.size();
 
-			itr = m_peers.erase(itr);
+			//Empty the slot rather than erasing it so every other peer keeps its poller key
+			m_timers.Cancel(peer->m_timeout_timer);
+			m_poller.Remove(peer->m_socket);
+			peer.reset();
+			m_free_peer_slots.emplace_back(slot);
 
 			//If the number of peers has dropped below max_connections
 			if(m_connected_players < m_max_connected_players)
 			{
-				m_peers.emplace_back(PeerPtr(new RemotePeer()));
 				SetListening(true);
 			}
 
-			BroadcastMessage("A player has disconnected");
-
-		}
-		else
-		{
-			++itr;
+			//Clients that never completed the handshake were never announced
+			if(was_ready)
+			{
+				BroadcastMessage("A player has disconnected");
+			}
 		}
 	}
 
-	
+	//The host left, the peer that has been connected the longest takes over
+	if(m_host_slot != NoPeerSlot && !m_peers[m_host_slot])
+	{
+		m_host_slot = FindOldestPeerSlot();
+	}
 }
 
-void GameServer::InformWorldState(sf::TcpSocket& socket)
+void GameServer::InformWorldState(RemotePeer& receiving_peer)
 {
-	sf::Packet packet;
-	packet << static_cast<sf::Int32>(Server::PacketType::InitialState);
-	packet << m_world_height << m_battlefield_rect.top + m_battlefield_rect.height;
-	packet << static_cast<sf::Int32>(m_aircraft_count);
+	Wire::Writer frame = receiving_peer.m_transport.BeginFrame();
+	frame << Wire::Tag(Server::PacketType::InitialState);
+	frame << Wire::CoordinateY(m_world_height) << Wire::CoordinateY(m_battlefield_rect.top + m_battlefield_rect.height);
+	frame << Wire::VarInt(m_aircraft_count);
 
-	for(std::size_t i=0; i < m_connected_players; ++i)
+	for(PeerPtr& peer : m_peers)
 	{
-		if(m_peers[i]->m_ready)
+		if(peer && peer->m_ready)
 		{
-			for(sf::Int32 identifier : m_peers[i]->m_aircraft_identifiers)
+			for(sf::Int32 identifier : peer->m_aircraft_identifiers)
 			{
-				packet << identifier << m_aircraft_info[identifier].m_position.x << m_aircraft_info[identifier].m_position.y << m_aircraft_info[identifier].m_hitpoints << m_aircraft_info[identifier].m_missile_ammo;
+				frame << Wire::VarInt(identifier) << Wire::Position(m_aircraft_info[identifier].m_position) << Wire::VarInt(m_aircraft_info[identifier].m_hitpoints) << Wire::VarInt(m_aircraft_info[identifier].m_missile_ammo);
 			}
 		}
 	}
 
-	socket.send(packet);
+	EndFrame(receiving_peer);
 }
 
 void GameServer::BroadcastMessage(const std::string& message)
 {
-	sf::Packet packet;
-	packet << static_cast<sf::Int32>(Server::PacketType::BroadcastMessage);
-	packet << message;
-	for(std::size_t i=0; i < m_connected_players; ++i)
+	Wire::Writer broadcast = BeginMessage();
+	broadcast << Wire::Tag(Server::PacketType::BroadcastMessage);
+	broadcast << Wire::Text(message);
+	SendToAll(broadcast);
+}
+
+//Messages that go to several peers are encoded once into m_message_buffer and copied into each
+//peer's transport. Only one message can be built at a time
+
+Wire::Writer GameServer::BeginMessage()
+{
+	m_message_buffer.clear();
+	return Wire::Writer(m_message_buffer);
+}
+
+void GameServer::SendToAll(const Wire::Writer& message)
+{
+	for(PeerPtr& peer : m_peers)
 	{
-		if(m_peers[i]->m_ready)
+		if(peer && peer->m_ready)
 		{
-			m_peers[i]->m_socket.send(packet);
+			SendToPeer(*peer, message);
 		}
 	}
 }
 
-void GameServer::SendToAll(sf::Packet& packet)
+void GameServer::SendToRelevantPeers(const Wire::Writer& message, sf::Vector2f position)
 {
 	for(PeerPtr& peer : m_peers)
 	{
-		if(peer->m_ready)
+		if(peer && peer->m_ready && peer->m_relevance_rect.contains(position))
 		{
-			peer->m_socket.send(packet);
+			SendToPeer(*peer, message);
 		}
 	}
 }
 
-void GameServer::UpdateClientState()
+//Each client only hears about the aircraft inside its own relevance area, so the size of
+//every update depends on how crowded that area is rather than on the total number of players
+
+void GameServer::UpdateClientState(RemotePeer& peer)
+{
+	Wire::Writer frame = peer.m_transport.BeginFrame();
+	frame << Wire::Tag(Server::PacketType::UpdateClientState);
+	frame << Wire::CoordinateY(m_battlefield_rect.top + m_battlefield_rect.height);
+	frame << Wire::VarInt(peer.m_relevant_aircraft.size());
+
+	for(sf::Int32 identifier : peer.m_relevant_aircraft)
+	{
+		const AircraftInfo& aircraft = m_aircraft_info.find(identifier)->second;
+		frame << Wire::VarInt(identifier) << Wire::Position(aircraft.m_position) << Wire::VarInt(aircraft.m_hitpoints) << Wire::VarInt(aircraft.m_missile_ammo);
+	}
+
+	EndFrame(peer);
+}
+
+sf::FloatRect GameServer::ComputeRelevanceRect() const
 {
-	sf::Packet update_client_state_packet;
-	update_client_state_packet << static_cast<sf::Int32>(Server::PacketType::UpdateClientState);
-	update_client_state_packet << static_cast<float>(m_battlefield_rect.top + m_battlefield_rect.height);
-	update_client_state_packet << static_cast<sf::Int32>(m_aircraft_count);
+	//Every client's view scrolls with the battlefield and keeps its aircraft inside, so the battlefield is all a
+	//client can see, plus a margin for sprites that stick out over its edges and the band above where enemies
+	//are spawned. What this leaves out are aircraft that fell behind the scrolling and the copies of aircraft
+	//flying further along in another shard's band
+	return sf::FloatRect(m_battlefield_rect.left - RelevanceMargin, m_battlefield_rect.top - RelevanceMargin - EnemySpawnDistance,
+		m_battlefield_rect.width + 2.f * RelevanceMargin, m_battlefield_rect.height + 2.f * RelevanceMargin + EnemySpawnDistance);
+}
 
+//Everything a peer is sent at the end of a tick depends only on the settled world and on that peer, so
+//once the grid is rebuilt the peers can be written independently. With enough of them the writing and
+//the socket write are shared out over the job system
+
+void GameServer::UpdatePeers()
+{
+	m_aircraft_grid.Clear();
 	for(const auto& aircraft : m_aircraft_info)
 	{
-		update_client_state_packet << aircraft.first << aircraft.second.m_position.x << aircraft.second.m_position.y << aircraft.second.m_hitpoints << aircraft.second.m_missile_ammo;
+		m_aircraft_grid.Insert(aircraft.first, aircraft.second.m_position);
+	}
+
+	m_tick_peers.clear();
+	for(const PeerPtr& peer : m_peers)
+	{
+		if(peer && peer->m_ready)
+		{
+			m_tick_peers.emplace_back(peer->m_slot);
+		}
+	}
+
+	//Unbatched sends and demo recording both go through shared state for every frame
+	bool parallel = m_tick_peers.size() >= ParallelPeerThreshold && m_jobs.GetThreadCount() > 1 && m_batched_sends && !m_demo_recorder.IsOpen();
+	if(!parallel)
+	{
+		for(std::size_t slot : m_tick_peers)
+		{
+			UpdatePeer(*m_peers[slot]);
+		}
+		return;
+	}
+
+	m_parallel_stage = true;
+	m_jobs.ParallelFor(m_tick_peers.size(), 1, [this](std::size_t index)
+	{
+		RemotePeer& peer = *m_peers[m_tick_peers[index]];
+		UpdatePeer(peer);
+
+		sf::Socket::Status status = peer.m_transport.Flush(peer.m_socket, peer.m_stats);
+		if(status == sf::Socket::Disconnected || status == sf::Socket::Error || peer.m_transport.GetPendingOutputSize() > MaxPendingOutput)
+		{
+			peer.m_timed_out = true;
+		}
+	});
+	m_parallel_stage = false;
+
+	//What OnPacketQueued and FlushPeers would have done for these peers
+	for(std::size_t slot : m_tick_peers)
+	{
+		RemotePeer& peer = *m_peers[slot];
+		m_transport_stats.Add(peer.m_stats);
+		peer.m_stats.Reset();
+
+		if(peer.m_timed_out)
+		{
+			m_peer_timed_out = true;
+		}
+
+		if(peer.m_transport.HasPendingOutput() && !peer.m_flush_pending)
+		{
+			peer.m_flush_pending = true;
+			m_peers_to_flush.emplace_back(peer.m_slot);
+		}
+	}
+}
+
+//Runs on a worker thread during the parallel stage, so it may only change the peer it is given
+
+void GameServer::UpdatePeer(RemotePeer& peer)
+{
+	UpdatePeerRelevance(peer);
+	UpdateClientState(peer);
+}
+
+void GameServer::UpdatePeerRelevance(RemotePeer& peer)
+{
+	peer.m_relevance_rect = ComputeRelevanceRect();
+
+	//A client always knows about its own aircraft, wherever they are
+	std::vector<sf::Int32>& query = peer.m_relevance_query;
+	query.clear();
+	m_aircraft_grid.Query(peer.m_relevance_rect, query);
+	for(sf::Int32 identifier : peer.m_aircraft_identifiers)
+	{
+		if(m_aircraft_info.count(identifier) > 0)
+		{
+			query.emplace_back(identifier);
+		}
+	}
+	std::sort(query.begin(), query.end());
+	query.erase(std::unique(query.begin(), query.end()), query.end());
+
+	//Walk both sorted lists to find what crossed the boundary since the last tick
+	const std::vector<sf::Int32>& previous = peer.m_relevant_aircraft;
+	auto before = previous.begin();
+	auto now = query.begin();
+	while(before != previous.end() || now != query.end())
+	{
+		if(now == query.end() || (before != previous.end() && *before < *now))
+		{
+			//Aircraft that no longer exist were already announced with PlayerDisconnect or destroyed on the client
+			auto found = m_aircraft_info.find(*before);
+			if(found != m_aircraft_info.end())
+			{
+				Wire::Writer leave_frame = peer.m_transport.BeginFrame();
+				leave_frame << Wire::Tag(Server::PacketType::AircraftLeave) << Wire::VarInt(*before);
+				EndFrame(peer);
+			}
+			++before;
+		}
+		else if(before == previous.end() || *now < *before)
+		{
+			const AircraftInfo& aircraft = m_aircraft_info.find(*now)->second;
+			Wire::Writer enter_frame = peer.m_transport.BeginFrame();
+			enter_frame << Wire::Tag(Server::PacketType::AircraftEnter);
+			enter_frame << Wire::VarInt(*now) << Wire::Position(aircraft.m_position) << Wire::VarInt(aircraft.m_hitpoints) << Wire::VarInt(aircraft.m_missile_ammo);
+			EndFrame(peer);
+			++now;
+		}
+		else
+		{
+			++before;
+			++now;
+		}
 	}
 
-	SendToAll(update_client_state_packet);
+	peer.m_relevant_aircraft.swap(query);
+}
+
+void GameServer::MarkRelevantToAll(sf::Int32 aircraft_identifier)
+{
+	for(PeerPtr& peer : m_peers)
+	{
+		if(peer && peer->m_ready)
+		{
+			std::vector<sf::Int32>& relevant = peer->m_relevant_aircraft;
+			auto position = std::lower_bound(relevant.begin(), relevant.end(), aircraft_identifier);
+			if(position == relevant.end() || *position != aircraft_identifier)
+			{
+				relevant.insert(position, aircraft_identifier);
+			}
+		}
+	}
+}
+
+void GameServer::SendToPeer(RemotePeer& peer, const Wire::Writer& message)
+{
+	peer.m_transport.Queue(message.GetData(), message.GetSize());
+	OnPacketQueued(peer);
+}
+
+//Messages meant for a single peer skip m_message_buffer and are written straight into its transport
+//between m_transport.BeginFrame() and EndFrame(peer)
+
+void GameServer::EndFrame(RemotePeer& peer)
+{
+	peer.m_transport.EndFrame();
+
+	//Workers must not touch the shared flush list and stats, UpdatePeers catches up once they are done
+	if(m_parallel_stage)
+	{
+		peer.m_stats.m_packets_sent++;
+		return;
+	}
+	OnPacketQueued(peer);
+}
+
+void GameServer::OnPacketQueued(RemotePeer& peer)
+{
+	m_transport_stats.m_packets_sent++;
+
+	if(m_demo_recorder.IsOpen())
+	{
+		Wire::Reader frame = peer.m_transport.GetLastFrame();
+		m_demo_recorder.Record(DemoDirection::Sent, m_tick_count, static_cast<sf::Uint32>(peer.m_slot), frame.GetRemainingData(), frame.GetRemainingSize());
+	}
+
+	if(!m_batched_sends)
+	{
+		peer.m_transport.Flush(peer.m_socket, m_transport_stats);
+	}
+
+	if(peer.m_transport.HasPendingOutput() && !peer.m_flush_pending)
+	{
+		peer.m_flush_pending = true;
+		m_peers_to_flush.emplace_back(peer.m_slot);
+	}
+}
+
+void GameServer::FlushPeers()
+{
+	bool detected_timeout = false;
+
+	//Peers that could not take everything stay on the list for the next iteration
+	std::size_t still_pending = 0;
+	for(std::size_t slot : m_peers_to_flush)
+	{
+		PeerPtr& peer = m_peers[slot];
+		if(!peer || !peer->m_flush_pending)
+		{
+			continue;
+		}
+
+		sf::Socket::Status status = peer->m_transport.Flush(peer->m_socket, m_transport_stats);
+		if(status == sf::Socket::Disconnected || status == sf::Socket::Error || peer->m_transport.GetPendingOutputSize() > MaxPendingOutput)
+		{
+			peer->m_timed_out = true;
+			detected_timeout = true;
+		}
+
+		if(peer->m_transport.HasPendingOutput())
+		{
+			m_peers_to_flush[still_pending++] = slot;
+		}
+		else
+		{
+			peer->m_flush_pending = false;
+		}
+	}
+	m_peers_to_flush.resize(still_pending);
+
+	FlushLinks();
+
+	if(detected_timeout)
+	{
+		HandleDisconnections();
+	}
+}
+
+void GameServer::ReportTransportStats()
+{
+	sf::Time elapsed = Now() - m_last_stats_report;
+
+	if(m_report_statistics && m_transport_stats.m_packets_sent + m_transport_stats.m_packets_received > 0)
+	{
+		std::size_t packets = m_transport_stats.m_packets_sent + m_transport_stats.m_packets_received;
+		std::size_t calls = m_transport_stats.m_send_calls + m_transport_stats.m_receive_calls;
+
+		if(m_shard_config.IsSharded())
+		{
+			std::cout << "Shard " << m_shard_config.GetIndex() << "/" << m_shard_config.GetCount() << " ";
+		}
+
+		std::cout << "Server transport (" << (m_batched_sends ? "batched" : "unbatched") << "): "
+			<< m_transport_stats.m_packets_sent / elapsed.asSeconds() << " packets/s sent, "
+			<< m_transport_stats.m_packets_received / elapsed.asSeconds() << " packets/s received, "
+			<< calls / elapsed.asSeconds() << " socket calls/s, "
+			<< m_transport_stats.m_cpu_time.asMicroseconds() / static_cast<float>(packets) << "us CPU/packet, "
+			<< m_tick_cpu_time.asMicroseconds() / static_cast<float>(std::max<std::size_t>(1, m_ticks_since_report)) << "us/tick on "
+			<< m_jobs.GetThreadCount() << " threads" << std::endl;
+	}
+
+	m_transport_stats.Reset();
+	m_ticks_since_report = 0;
+	m_tick_cpu_time = sf::Time::Zero;
+	m_last_stats_report = Now();
+	m_timers.Schedule(Now() + StatsReportInterval, [this] { ReportTransportStats(); });
+}
+
+bool GameServer::IsLocalAircraft(const AircraftInfo& aircraft) const
+{
+	return aircraft.m_owner_shard == m_shard_config.GetIndex();
+}
+
+//Each shard listens for the shard below it and connects to the shard above it. All shards run on the
+//same machine, they are told apart by their ports
+
+void GameServer::StartShardLinks()
+{
+	std::size_t index = m_shard_config.GetIndex();
+	if(index > 0 && m_link_listener.listen(m_shard_config.GetLinkPort(index)) == sf::TcpListener::Done)
+	{
+		m_poller.Add(m_link_listener, LinkListenerKey);
+	}
+
+	if(index + 1 < m_shard_config.GetCount())
+	{
+		ConnectUpperLink();
+	}
+}
+
+void GameServer::ConnectUpperLink()
+{
+	ShardLink& link = m_links[UpperLink];
+	if(link.m_connected || link.m_connecting)
+	{
+		return;
+	}
+
+	//Never waits inside the tick, the connect is only started here and CheckUpperLink sees it through
+	link.m_socket.setBlocking(false);
+	sf::Socket::Status status = link.m_socket.connect(sf::IpAddress::LocalHost, m_shard_config.GetLinkPort(m_shard_config.GetIndex() + 1));
+	if(status == sf::Socket::Done || status == sf::Socket::NotReady)
+	{
+		link.m_connecting = true;
+		link.m_connect_deadline = Now() + LinkConnectTimeout;
+		CheckUpperLink();
+	}
+	else
+	{
+		m_timers.Schedule(Now() + LinkRetryInterval, [this] { ConnectUpperLink(); });
+	}
+}
+
+void GameServer::CheckUpperLink()
+{
+	ShardLink& link = m_links[UpperLink];
+	if(!link.m_connecting)
+	{
+		return;
+	}
+
+	//The socket only has a remote address once the connect has gone through
+	if(link.m_socket.getRemoteAddress() != sf::IpAddress::None)
+	{
+		link.m_connecting = false;
+		OpenLink(UpperLink);
+	}
+	else if(Now() > link.m_connect_deadline)
+	{
+		link.m_connecting = false;
+		link.m_socket.disconnect();
+		m_timers.Schedule(Now() + LinkRetryInterval, [this] { ConnectUpperLink(); });
+	}
+	else
+	{
+		m_timers.Schedule(Now() + LinkConnectPollInterval, [this] { CheckUpperLink(); });
+	}
+}
+
+void GameServer::HandleIncomingLink()
+{
+	ShardLink& link = m_links[LowerLink];
+	while(true)
+	{
+		if(link.m_connected)
+		{
+			//There is only one shard below us, anyone else is turned away
+			sf::TcpSocket extra;
+			if(m_link_listener.accept(extra) != sf::TcpListener::Done)
+			{
+				return;
+			}
+		}
+		else
+		{
+			if(m_link_listener.accept(link.m_socket) != sf::TcpListener::Done)
+			{
+				return;
+			}
+			OpenLink(LowerLink);
+		}
+	}
+}
+
+void GameServer::OpenLink(LinkSide side)
+{
+	ShardLink& link = m_links[side];
+	link.m_socket.setBlocking(false);
+	link.m_transport.Clear();
+	link.m_connected = true;
+	link.m_ready = false;
+	m_poller.Add(link.m_socket, FirstLinkKey + side);
+
+	Wire::Writer frame = link.m_transport.BeginFrame();
+	frame << Wire::Tag(Shard::PacketType::Hello) << Wire::VarInt(PROTOCOL_VERSION) << Wire::VarInt(m_shard_config.GetIndex());
+	EndLinkFrame(link);
+}
+
+void GameServer::CloseLink(LinkSide side)
+{
+	ShardLink& link = m_links[side];
+	if(!link.m_connected)
+	{
+		return;
+	}
+
+	m_poller.Remove(link.m_socket);
+	link.m_socket.disconnect();
+	link.m_transport.Clear();
+	link.m_connected = false;
+
+	if(link.m_ready)
+	{
+		link.m_ready = false;
+		std::cout << "Lost the link to shard " << link.m_shard_index << std::endl;
+
+		//Its aircraft can no longer be kept up to date, and handoffs to it will not be answered
+		m_world_state_identifiers.clear();
+		for(const auto& aircraft : m_aircraft_info)
+		{
+			if(aircraft.second.m_owner_shard == link.m_shard_index)
+			{
+				m_world_state_identifiers.emplace_back(aircraft.first);
+			}
+		}
+		for(sf::Int32 identifier : m_world_state_identifiers)
+		{
+			RemoveRemoteAircraft(identifier);
+		}
+
+		for(PeerPtr& peer : m_peers)
+		{
+			if(peer && peer->m_migrating && peer->m_migration_shard == link.m_shard_index)
+			{
+				peer->m_migrating = false;
+			}
+		}
+	}
+
+	if(side == UpperLink)
+	{
+		m_timers.Schedule(Now() + LinkRetryInterval, [this] { ConnectUpperLink(); });
+	}
+}
+
+void GameServer::HandleLinkPackets(LinkSide side)
+{
+	ShardLink& link = m_links[side];
+	if(!link.m_connected)
+	{
+		return;
+	}
+
+	sf::Socket::Status status = link.m_transport.Receive(link.m_socket, m_transport_stats);
+
+	Wire::Reader packet;
+	while(link.m_connected && link.m_transport.PollFrame(packet))
+	{
+		HandleLinkPacket(packet, side);
+		m_transport_stats.m_packets_received++;
+	}
+
+	if(status == sf::Socket::Disconnected || status == sf::Socket::Error)
+	{
+		CloseLink(side);
+	}
+}
+
+void GameServer::HandleLinkPacket(Wire::Reader& packet, LinkSide side)
+{
+	ShardLink& link = m_links[side];
+	Shard::PacketType packet_type;
+	if(!(packet >> Wire::Tag(packet_type)))
+	{
+		return;
+	}
+
+	if(!link.m_ready)
+	{
+		//Only the neighbour on this side, running the same version, may link up
+		sf::Uint32 version = 0;
+		std::size_t shard_index = 0;
+		packet >> Wire::VarInt(version) >> Wire::VarInt(shard_index);
+		std::size_t expected_index = side == LowerLink ? m_shard_config.GetIndex() - 1 : m_shard_config.GetIndex() + 1;
+		if(packet_type != Shard::PacketType::Hello || version != PROTOCOL_VERSION || shard_index != expected_index)
+		{
+			std::cout << "Rejecting shard link from shard " << shard_index << " with protocol version " << version << std::endl;
+			CloseLink(side);
+			return;
+		}
+
+		link.m_shard_index = shard_index;
+		link.m_ready = true;
+		std::cout << "Linked to shard " << shard_index << std::endl;
+		return;
+	}
+
+	switch(packet_type)
+	{
+	//Only expected once, before the link is ready
+	case Shard::PacketType::Hello:
+	break;
+
+	case Shard::PacketType::WorldState:
+	{
+		ApplyWorldState(packet, link);
+	}
+	break;
+
+	case Shard::PacketType::Handoff:
+	{
+		AcceptHandoff(packet, link);
+	}
+	break;
+
+	case Shard::PacketType::HandoffAccepted:
+	{
+		sf::Uint32 migration_token;
+		if(packet >> Wire::VarInt(migration_token))
+		{
+			CompleteHandoff(migration_token, link);
+		}
+	}
+	break;
+
+	case Shard::PacketType::Relay:
+	{
+		sf::Vector2f position;
+		if(packet >> Wire::Position(position))
+		{
+			//The rest of the frame is already a message for our clients
+			Wire::Writer message = BeginMessage();
+			message.append(packet.GetRemainingData(), packet.GetRemainingSize());
+			SendToRelevantPeers(message, position);
+		}
+	}
+	break;
+	}
+}
+
+void GameServer::EndLinkFrame(ShardLink& link)
+{
+	link.m_transport.EndFrame();
+	m_transport_stats.m_packets_sent++;
+}
+
+void GameServer::FlushLinks()
+{
+	for(std::size_t side = 0; side < LinkCount; ++side)
+	{
+		ShardLink& link = m_links[side];
+		if(!link.m_connected || !link.m_transport.HasPendingOutput())
+		{
+			continue;
+		}
+
+		sf::Socket::Status status = link.m_transport.Flush(link.m_socket, m_transport_stats);
+		if(status == sf::Socket::Disconnected || status == sf::Socket::Error || link.m_transport.GetPendingOutputSize() > MaxPendingOutput)
+		{
+			CloseLink(static_cast<LinkSide>(side));
+		}
+	}
+}
+
+//Every tick each shard sends its neighbours all of its own aircraft. There are at most a few dozen, so
+//sending them all is cheaper than working out which ones a neighbour's clients can see
+
+void GameServer::SendWorldState()
+{
+	std::size_t local_count = 0;
+	for(const auto& aircraft : m_aircraft_info)
+	{
+		if(IsLocalAircraft(aircraft.second))
+		{
+			local_count++;
+		}
+	}
+
+	for(ShardLink& link : m_links)
+	{
+		if(!link.m_ready)
+		{
+			continue;
+		}
+
+		Wire::Writer frame = link.m_transport.BeginFrame();
+		frame << Wire::Tag(Shard::PacketType::WorldState);
+		frame << Wire::CoordinateY(m_battlefield_rect.top) << Wire::VarInt(local_count);
+		for(const auto& aircraft : m_aircraft_info)
+		{
+			if(IsLocalAircraft(aircraft.second))
+			{
+				frame << Wire::VarInt(aircraft.first) << Wire::Position(aircraft.second.m_position) << Wire::VarInt(aircraft.second.m_hitpoints) << Wire::VarInt(aircraft.second.m_missile_ammo);
+			}
+		}
+		EndLinkFrame(link);
+	}
+}
+
+void GameServer::ApplyWorldState(Wire::Reader& packet, ShardLink& link)
+{
+	float battlefield_top;
+	sf::Int32 aircraft_count;
+	packet >> Wire::CoordinateY(battlefield_top) >> Wire::VarInt(aircraft_count);
+	if(!packet)
+	{
+		return;
+	}
+
+	//Shard 0 keeps the time for everyone, each shard follows the one below it so all of them scroll together
+	if(link.m_shard_index < m_shard_config.GetIndex())
+	{
+		m_battlefield_rect.top = battlefield_top;
+	}
+
+	m_world_state_identifiers.clear();
+	for(sf::Int32 i = 0; i < aircraft_count; ++i)
+	{
+		sf::Int32 aircraft_identifier;
+		sf::Int32 hitpoints;
+		sf::Int32 missile_ammo;
+		sf::Vector2f position;
+		packet >> Wire::VarInt(aircraft_identifier) >> Wire::Position(position) >> Wire::VarInt(hitpoints) >> Wire::VarInt(missile_ammo);
+		if(!packet)
+		{
+			return;
+		}
+
+		//Handed over to us since this was sent
+		auto found = m_aircraft_info.find(aircraft_identifier);
+		if(found != m_aircraft_info.end() && IsLocalAircraft(found->second))
+		{
+			continue;
+		}
+
+		AircraftInfo& aircraft = m_aircraft_info[aircraft_identifier];
+		aircraft.m_position = position;
+		aircraft.m_hitpoints = hitpoints;
+		aircraft.m_missile_ammo = missile_ammo;
+		aircraft.m_owner_shard = link.m_shard_index;
+		m_world_state_identifiers.emplace_back(aircraft_identifier);
+	}
+
+	//Whatever the neighbour no longer sends was destroyed, disconnected or moved further away
+	std::sort(m_world_state_identifiers.begin(), m_world_state_identifiers.end());
+	std::vector<sf::Int32> removed;
+	for(const auto& aircraft : m_aircraft_info)
+	{
+		if(aircraft.second.m_owner_shard == link.m_shard_index && !std::binary_search(m_world_state_identifiers.begin(), m_world_state_identifiers.end(), aircraft.first))
+		{
+			removed.emplace_back(aircraft.first);
+		}
+	}
+	for(sf::Int32 identifier : removed)
+	{
+		RemoveRemoteAircraft(identifier);
+	}
+}
+
+void GameServer::RemoveRemoteAircraft(sf::Int32 aircraft_identifier)
+{
+	for(PeerPtr& peer : m_peers)
+	{
+		if(!peer || !peer->m_ready)
+		{
+			continue;
+		}
+
+		std::vector<sf::Int32>& relevant = peer->m_relevant_aircraft;
+		auto position = std::lower_bound(relevant.begin(), relevant.end(), aircraft_identifier);
+		if(position != relevant.end() && *position == aircraft_identifier)
+		{
+			relevant.erase(position);
+			Wire::Writer leave_frame = peer->m_transport.BeginFrame();
+			leave_frame << Wire::Tag(Server::PacketType::AircraftLeave) << Wire::VarInt(aircraft_identifier);
+			EndFrame(*peer);
+		}
+	}
+
+	m_aircraft_info.erase(aircraft_identifier);
+}
+
+//Events near a boundary matter to the clients of the neighbouring shard as well, they get them wrapped in a Relay
+
+void GameServer::RelayToShards(const Wire::Writer& message, sf::Vector2f position)
+{
+	for(ShardLink& link : m_links)
+	{
+		if(link.m_ready)
+		{
+			Wire::Writer frame = link.m_transport.BeginFrame();
+			frame << Wire::Tag(Shard::PacketType::Relay) << Wire::Position(position);
+			frame.append(message.GetData(), message.GetSize());
+			EndLinkFrame(link);
+		}
+	}
+}
+
+//A client moves when its first aircraft is well inside a neighbouring band. Its coop partner moves with it:
+//1. This shard sends Handoff with the client's aircraft and what the client currently knows about
+//2. The neighbour takes the aircraft over straight away, so both shards agree on the owner, and answers HandoffAccepted
+//3. This shard tells the client to Migrate and forgets it
+//4. The client reconnects to the neighbour with the token, which hands its aircraft back to it
+
+void GameServer::CheckMigrations()
+{
+	std::size_t index = m_shard_config.GetIndex();
+	for(PeerPtr& peer : m_peers)
+	{
+		if(!peer || !peer->m_ready || peer->m_migrating || peer->m_aircraft_identifiers.empty())
+		{
+			continue;
+		}
+
+		auto found = m_aircraft_info.find(peer->m_aircraft_identifiers.front());
+		if(found == m_aircraft_info.end())
+		{
+			continue;
+		}
+
+		float y = found->second.m_position.y;
+		if(index + 1 < m_shard_config.GetCount() && y < m_shard_config.GetBandTop(index, m_world_height) - MigrationMargin && m_links[UpperLink].m_ready)
+		{
+			BeginHandoff(*peer, m_links[UpperLink]);
+		}
+		else if(index > 0 && y > m_shard_config.GetBandBottom(index, m_world_height) + MigrationMargin && m_links[LowerLink].m_ready)
+		{
+			BeginHandoff(*peer, m_links[LowerLink]);
+		}
+	}
+}
+
+void GameServer::BeginHandoff(RemotePeer& peer, ShardLink& link)
+{
+	//Tokens from different shards never collide: index + 1, index + 1 + count, ...
+	peer.m_migrating = true;
+	peer.m_migration_shard = link.m_shard_index;
+	peer.m_migration_token = static_cast<sf::Uint32>(m_migration_counter++ * m_shard_config.GetCount() + m_shard_config.GetIndex() + 1);
+
+	std::size_t aircraft_count = 0;
+	for(sf::Int32 identifier : peer.m_aircraft_identifiers)
+	{
+		aircraft_count += m_aircraft_info.count(identifier);
+	}
+
+	Wire::Writer frame = link.m_transport.BeginFrame();
+	frame << Wire::Tag(Shard::PacketType::Handoff);
+	frame << Wire::VarInt(peer.m_migration_token) << Wire::VarInt(aircraft_count);
+	for(sf::Int32 identifier : peer.m_aircraft_identifiers)
+	{
+		auto found = m_aircraft_info.find(identifier);
+		if(found != m_aircraft_info.end())
+		{
+			const AircraftInfo& aircraft = found->second;
+			frame << Wire::VarInt(identifier) << Wire::Position(aircraft.m_position) << Wire::VarInt(aircraft.m_hitpoints) << Wire::VarInt(aircraft.m_missile_ammo);
+			frame << aircraft.m_input << Wire::VarInt(aircraft.m_next_input_tick);
+		}
+	}
+
+	frame << Wire::VarInt(peer.m_relevant_aircraft.size());
+	for(sf::Int32 identifier : peer.m_relevant_aircraft)
+	{
+		frame << Wire::VarInt(identifier);
+	}
+	EndLinkFrame(link);
+}
+
+void GameServer::AcceptHandoff(Wire::Reader& packet, ShardLink& link)
+{
+	sf::Uint32 migration_token;
+	sf::Int32 aircraft_count;
+	packet >> Wire::VarInt(migration_token) >> Wire::VarInt(aircraft_count);
+
+	//A count the rest of the frame cannot hold is broken or hostile, drop it before sizing anything by it
+	if(!packet || aircraft_count < 0 || static_cast<std::size_t>(aircraft_count) > packet.GetRemainingSize() / MinHandoffAircraftSize)
+	{
+		return;
+	}
+
+	//Read everything before changing anything, a broken handoff is dropped as a whole
+	std::vector<std::pair<sf::Int32, AircraftInfo>> aircraft(aircraft_count);
+	for(auto& entry : aircraft)
+	{
+		AircraftInfo& info = entry.second;
+		packet >> Wire::VarInt(entry.first) >> Wire::Position(info.m_position) >> Wire::VarInt(info.m_hitpoints) >> Wire::VarInt(info.m_missile_ammo);
+		packet >> info.m_input >> Wire::VarInt(info.m_next_input_tick);
+		info.m_owner_shard = m_shard_config.GetIndex();
+	}
+
+	PendingHandoff handoff;
+	sf::Int32 relevant_count = 0;
+	packet >> Wire::VarInt(relevant_count);
+	for(sf::Int32 i = 0; i < relevant_count && packet; ++i)
+	{
+		sf::Int32 identifier;
+		packet >> Wire::VarInt(identifier);
+		handoff.m_relevant_aircraft.emplace_back(identifier);
+	}
+
+	if(!packet)
+	{
+		return;
+	}
+
+	for(const auto& entry : aircraft)
+	{
+		m_aircraft_info[entry.first] = entry.second;
+		handoff.m_aircraft_identifiers.emplace_back(entry.first);
+	}
+	handoff.m_expiry_timer = m_timers.Schedule(Now() + HandoffTimeout, [this, migration_token] { ExpireHandoff(migration_token); });
+	m_pending_handoffs[migration_token] = std::move(handoff);
+
+	Wire::Writer frame = link.m_transport.BeginFrame();
+	frame << Wire::Tag(Shard::PacketType::HandoffAccepted) << Wire::VarInt(migration_token);
+	EndLinkFrame(link);
+}
+
+void GameServer::CompleteHandoff(sf::Uint32 migration_token, ShardLink& link)
+{
+	for(PeerPtr& peer : m_peers)
+	{
+		if(!peer || !peer->m_migrating || peer->m_migration_token != migration_token)
+		{
+			continue;
+		}
+
+		//From now on the aircraft are copies kept up to date by their new owner
+		for(sf::Int32 identifier : peer->m_aircraft_identifiers)
+		{
+			auto found = m_aircraft_info.find(identifier);
+			if(found != m_aircraft_info.end())
+			{
+				found->second.m_owner_shard = link.m_shard_index;
+			}
+		}
+		m_aircraft_count -= peer->m_aircraft_identifiers.size();
+		peer->m_aircraft_identifiers.clear();
+
+		Wire::Writer frame = peer->m_transport.BeginFrame();
+		frame << Wire::Tag(Server::PacketType::Migrate);
+		frame << Wire::VarInt(m_shard_config.GetClientPort(link.m_shard_index)) << Wire::VarInt(migration_token);
+		EndFrame(*peer);
+
+		//Nothing else is sent to it, the connection is dropped quietly once the client goes
+		peer->m_ready = false;
+		peer->m_migrating = false;
+		return;
+	}
+}
+
+void GameServer::ExpireHandoff(sf::Uint32 migration_token)
+{
+	auto found = m_pending_handoffs.find(migration_token);
+	if(found == m_pending_handoffs.end())
+	{
+		return;
+	}
+
+	//The client never arrived
+	for(sf::Int32 identifier : found->second.m_aircraft_identifiers)
+	{
+		Wire::Writer message = BeginMessage();
+		message << Wire::Tag(Server::PacketType::PlayerDisconnect) << Wire::VarInt(identifier);
+		SendToAll(message);
+		m_aircraft_info.erase(identifier);
+	}
+	m_pending_handoffs.erase(found);
+}
+
+void GameServer::AcceptMigratedPlayer(RemotePeer& peer, PendingHandoff& handoff)
+{
+	for(sf::Int32 identifier : handoff.m_aircraft_identifiers)
+	{
+		if(m_aircraft_info.count(identifier) > 0)
+		{
+			peer.m_aircraft_identifiers.emplace_back(identifier);
+		}
+	}
+	m_aircraft_count += peer.m_aircraft_identifiers.size();
+
+	//Carry on from what the previous shard told the client. Anything we do not know about is taken away,
+	//the rest is diffed as usual on the next tick
+	for(sf::Int32 identifier : handoff.m_relevant_aircraft)
+	{
+		if(m_aircraft_info.count(identifier) > 0)
+		{
+			peer.m_relevant_aircraft.emplace_back(identifier);
+		}
+		else
+		{
+			Wire::Writer leave_frame = peer.m_transport.BeginFrame();
+			leave_frame << Wire::Tag(Server::PacketType::AircraftLeave) << Wire::VarInt(identifier);
+			EndFrame(peer);
+		}
+	}
+	peer.m_relevance_rect = ComputeRelevanceRect();
+	peer.m_ready = true;
 }
@@ -1,7 +1,9 @@
 #pragma once
+#include <array>
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 #include <SFML/Config.hpp>
 #include <SFML/Graphics/Rect.hpp>
 #include <SFML/System/Vector2.hpp>
@@ -10,10 +12,22 @@
 #include <SFML/System/Clock.hpp>
 #include <SFML/System/Thread.hpp>
 
+#include "DebugSettings.hpp"
+#include "DemoRecorder.hpp"
+#include "JobSystem.hpp"
+#include "NetworkPoller.hpp"
+#include "PacketTransport.hpp"
+#include "ShardConfig.hpp"
+#include "SpatialGrid.hpp"
+#include "TimerWheel.hpp"
+#include "WireFormat.hpp"
+
 class GameServer
 {
 public:
-	explicit GameServer(sf::Vector2f battlefield_size);
+	//A server that is one shard of several only owns its band of the world, see ShardConfig.
+	//With a demo path every message to and from the clients is recorded there
+	explicit GameServer(sf::Vector2f battlefield_size, const ShardConfig& shard_config = ShardConfig(), const std::string& demo_path = std::string(), const DebugSettings& debug_settings = DebugSettings());
 	~GameServer();
 	void NotifyPlayerSpawn(sf::Int32 aircraft_identifier);
 	void NotifyPlayerRealtimeChange(sf::Int32 aircraft_identifier, sf::Int32 action, bool action_enabled);
@@ -24,10 +38,26 @@ private:
 	{
 		RemotePeer();
 		sf::TcpSocket m_socket;
+		PacketTransport m_transport;
+		std::size_t m_slot;
+		//Peers that connected earlier have lower numbers
+		sf::Uint64 m_connection_number;
+		bool m_flush_pending;
 		sf::Time m_last_packet_time;
+		TimerWheel::TimerId m_timeout_timer;
 		std::vector<sf::Int32> m_aircraft_identifiers;
+		//What this client currently knows about, kept sorted so it can be diffed against a fresh query
+		sf::FloatRect m_relevance_rect;
+		std::vector<sf::Int32> m_relevant_aircraft;
+		std::vector<sf::Int32> m_relevance_query;
+		//Counted here while peers are written in parallel and added to the server's stats afterwards
+		TransportStats m_stats;
 		bool m_ready;
 		bool m_timed_out;
+		//Waiting for the neighbouring shard to take over the aircraft
+		bool m_migrating;
+		sf::Uint32 m_migration_token;
+		std::size_t m_migration_shard;
 	};
 
 	struct AircraftInfo
@@ -35,7 +65,40 @@ private:
 		sf::Vector2f m_position;
 		sf::Int32 m_hitpoints;
 		sf::Int32 m_missile_ammo;
-		std::map<sf::Int32, bool> m_realtime_actions;
+		//Input bits of the last tick applied for this aircraft, older ticks that arrive again are ignored
+		sf::Uint8 m_input;
+		sf::Uint32 m_next_input_tick;
+		//Aircraft owned by a neighbouring shard are copies that it keeps up to date with WorldState
+		std::size_t m_owner_shard;
+	};
+
+	//The connection to the shard directly below or above this one
+	struct ShardLink
+	{
+		ShardLink();
+		sf::TcpSocket m_socket;
+		PacketTransport m_transport;
+		std::size_t m_shard_index;
+		bool m_connected;
+		bool m_ready;
+		//Only the upper link connects, it is started and then checked from a timer until it goes through
+		bool m_connecting;
+		sf::Time m_connect_deadline;
+	};
+
+	enum LinkSide
+	{
+		LowerLink,
+		UpperLink,
+		LinkCount
+	};
+
+	//Aircraft taken over from a neighbour, waiting for their client to reconnect
+	struct PendingHandoff
+	{
+		std::vector<sf::Int32> m_aircraft_identifiers;
+		std::vector<sf::Int32> m_relevant_aircraft;
+		TimerWheel::TimerId m_expiry_timer;
 	};
 
 	typedef std::unique_ptr<RemotePeer> PeerPtr;
@@ -44,23 +107,68 @@ private:
 	void SetListening(bool enable);
 	void ExecutionThread();
 	void Tick();
+	void SpawnEnemyWave();
 	sf::Time Now() const;
 
-	void HandleIncomingPackets();
-	void HandleIncomingPacket(sf::Packet& packet, RemotePeer& receiving_peer, bool& detected_timeout);
+	void HandleIncomingPackets(RemotePeer& peer, bool& detected_timeout);
+	void HandleIncomingPacket(Wire::Reader& packet, RemotePeer& receiving_peer, bool& detected_timeout);
+	void ScheduleTimeout(RemotePeer& peer);
+	void CheckPeerTimeout(std::size_t slot);
+	void ApplyPlayerInput(sf::Int32 aircraft_identifier, sf::Uint32 tick, sf::Uint8 input);
 
 	void HandleIncomingConnections();
+	void AcceptPlayer(RemotePeer& peer);
 	void HandleDisconnections();
+	std::size_t AllocatePeerSlot();
+	std::size_t FindOldestPeerSlot() const;
 
-	void InformWorldState(sf::TcpSocket& socket);
+	void InformWorldState(RemotePeer& peer);
 	void BroadcastMessage(const std::string& message);
-	void SendToAll(sf::Packet& packet);
-	void UpdateClientState();
+	Wire::Writer BeginMessage();
+	void SendToAll(const Wire::Writer& message);
+	void SendToRelevantPeers(const Wire::Writer& message, sf::Vector2f position);
+	void SendToPeer(RemotePeer& peer, const Wire::Writer& message);
+	void EndFrame(RemotePeer& peer);
+	void OnPacketQueued(RemotePeer& peer);
+	void FlushPeers();
+	void ReportTransportStats();
+	void UpdatePeers();
+	void UpdatePeer(RemotePeer& peer);
+	void UpdateClientState(RemotePeer& peer);
+
+	sf::FloatRect ComputeRelevanceRect() const;
+	void UpdatePeerRelevance(RemotePeer& peer);
+	void MarkRelevantToAll(sf::Int32 aircraft_identifier);
+	bool IsLocalAircraft(const AircraftInfo& aircraft) const;
+
+	void StartShardLinks();
+	void ConnectUpperLink();
+	void CheckUpperLink();
+	void OpenLink(LinkSide side);
+	void CloseLink(LinkSide side);
+	void HandleIncomingLink();
+	void HandleLinkPackets(LinkSide side);
+	void HandleLinkPacket(Wire::Reader& packet, LinkSide side);
+	void EndLinkFrame(ShardLink& link);
+	void FlushLinks();
+	void SendWorldState();
+	void ApplyWorldState(Wire::Reader& packet, ShardLink& link);
+	void RemoveRemoteAircraft(sf::Int32 aircraft_identifier);
+	void RelayToShards(const Wire::Writer& message, sf::Vector2f position);
+
+	void CheckMigrations();
+	void BeginHandoff(RemotePeer& peer, ShardLink& link);
+	void AcceptHandoff(Wire::Reader& packet, ShardLink& link);
+	void CompleteHandoff(sf::Uint32 migration_token, ShardLink& link);
+	void ExpireHandoff(sf::Uint32 migration_token);
+	void AcceptMigratedPlayer(RemotePeer& peer, PendingHandoff& handoff);
 
 private:
 	sf::Thread m_thread;
 	sf::Clock m_clock;
 	sf::TcpListener m_listener_socket;
+	NetworkPoller m_poller;
+	std::vector<std::size_t> m_ready_sockets;
 	bool m_listening_state;
 	sf::Time m_client_timeout;
 
@@ -73,12 +181,45 @@ private:
 
 	std::size_t m_aircraft_count;
 	std::map<sf::Int32, AircraftInfo> m_aircraft_info;
+	SpatialGrid<sf::Int32> m_aircraft_grid;
 
+	//Peers never move once connected, a disconnect empties the slot and it is reused by the next connection
 	std::vector<PeerPtr> m_peers;
+	std::vector<std::size_t> m_free_peer_slots;
+	//The longest connected peer, its game decides where pickups drop. Slots are reused, so slot 0 is not it
+	std::size_t m_host_slot;
+	sf::Uint64 m_connection_counter;
 	sf::Int32 m_aircraft_identifier_counter;
 	bool m_waiting_thread_end;
 
-	sf::Time m_last_spawn_time;
-	sf::Time m_time_for_next_spawn;
+	bool m_batched_sends;
+	std::vector<char> m_message_buffer;
+	std::vector<std::size_t> m_peers_to_flush;
+	TransportStats m_transport_stats;
+	sf::Time m_last_stats_report;
+	//Only prints the transport stats with --stats, the counters are reset either way
+	bool m_report_statistics;
+	std::size_t m_ticks_since_report;
+	sf::Time m_tick_cpu_time;
+
+	//Every peer's part of a tick only touches that peer, so with enough of them it is shared out here
+	JobSystem m_jobs;
+	std::vector<std::size_t> m_tick_peers;
+	bool m_parallel_stage;
+
+	//Peer timeouts, enemy waves and the stats report all run off this
+	TimerWheel m_timers;
+	bool m_peer_timed_out;
+
+	ShardConfig m_shard_config;
+	sf::TcpListener m_link_listener;
+	std::array<ShardLink, LinkCount> m_links;
+	std::map<sf::Uint32, PendingHandoff> m_pending_handoffs;
+	sf::Uint32 m_migration_counter;
+	std::vector<sf::Int32> m_world_state_identifiers;
+
+	std::string m_demo_path;
+	DemoRecorder m_demo_recorder;
+	sf::Uint32 m_tick_count;
 };
 
@@ -2,14 +2,19 @@
 
 #include <iostream>
 
+#include "DebugSettings.hpp"
 #include "Player.hpp"
 
 GameState::GameState(StateStack& stack, Context context)
 : State(stack, context)
-, m_world(*context.window, *context.fonts, *context.sounds, false)
+, m_world(*context.window, *context.fonts, *context.sounds, *context.timing, *context.jobs, *context.quality, *context.textures, false)
 , m_player(nullptr, 1, context.keys1)
 {
 	m_world.AddAircraft(1);
+	if (context.debug->m_report_statistics)
+	{
+		m_world.EnableStatistics();
+	}
 	m_player.SetMissionStatus(MissionStatus::kMissionRunning);
 	// Play game theme
 	context.music->Play(MusicThemes::kMissionTheme);
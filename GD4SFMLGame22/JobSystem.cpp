@@ -0,0 +1,280 @@
+#include "JobSystem.hpp"
+
+#include <SFML/System/Clock.hpp>
+
+#include <algorithm>
+#include <cassert>
+
+JobSystem::Queue::Queue() : m_first(0)
+{
+}
+
+JobSystem::JobSystem(std::size_t thread_count)
+	: m_job_count(0)
+	, m_unfinished_jobs(0)
+	, m_generation(0)
+	, m_active_workers(0)
+	, m_stopping(false)
+{
+	for (std::size_t i = 0; i < thread_count + 1; ++i)
+	{
+		m_queues.emplace_back(new Queue());
+	}
+
+	//Queue 0 belongs to the thread that calls Run
+	for (std::size_t i = 0; i < thread_count; ++i)
+	{
+		m_threads.emplace_back(&JobSystem::WorkerThread, this, i + 1);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_work_ready.notify_all();
+
+	for (std::thread& thread : m_threads)
+	{
+		thread.join();
+	}
+}
+
+std::size_t JobSystem::GetThreadCount() const
+{
+	return m_threads.size() + 1;
+}
+
+std::size_t JobSystem::GetSpareThreadCount()
+{
+	std::size_t cores = std::thread::hardware_concurrency();
+	return cores > 1 ? cores - 1 : 0;
+}
+
+JobSystem::JobId JobSystem::AddJob(Work work)
+{
+	return AddJob(std::move(work), std::vector<JobId>());
+}
+
+JobSystem::JobId JobSystem::AddJob(Work work, const std::vector<JobId>& prerequisites)
+{
+	JobId id = AddJob();
+	Job& job = m_jobs[id];
+	job.m_work = std::move(work);
+	job.m_waiting_for = prerequisites.size();
+	for (JobId prerequisite : prerequisites)
+	{
+		assert(prerequisite < id);
+		m_jobs[prerequisite].m_dependents.emplace_back(id);
+	}
+	return id;
+}
+
+JobSystem::JobId JobSystem::AddJob()
+{
+	//Reuse a job left from an earlier run, its dependents were emptied by Clear but kept their capacity
+	JobId id = m_job_count++;
+	if (id == m_jobs.size())
+	{
+		m_jobs.emplace_back();
+	}
+
+	Job& job = m_jobs[id];
+	job.m_body = nullptr;
+	job.m_begin = 0;
+	job.m_end = 0;
+	job.m_waiting_for = 0;
+	job.m_time = sf::Time::Zero;
+	return id;
+}
+
+void JobSystem::Run()
+{
+	if (m_job_count == 0)
+	{
+		return;
+	}
+
+	//Share the jobs that can start straight away between the queues, the rest are queued as they become ready.
+	//Locked like any other push, a worker that woke late for the last run may still be looking at the queues
+	std::size_t next_queue = 0;
+	for (JobId id = 0; id < m_job_count; ++id)
+	{
+		if (m_jobs[id].m_waiting_for == 0)
+		{
+			PushJob(next_queue, id);
+			next_queue = (next_queue + 1) % m_queues.size();
+		}
+	}
+	m_unfinished_jobs = m_job_count;
+
+	if (!m_threads.empty())
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_generation++;
+		}
+		m_work_ready.notify_all();
+	}
+
+	RunJobs(0);
+	WaitForWorkers();
+}
+
+sf::Time JobSystem::GetJobTime(JobId job) const
+{
+	return m_jobs[job].m_time;
+}
+
+void JobSystem::Clear()
+{
+	for (JobId id = 0; id < m_job_count; ++id)
+	{
+		m_jobs[id].m_work = nullptr;
+		m_jobs[id].m_dependents.clear();
+	}
+	m_job_count = 0;
+}
+
+void JobSystem::ParallelFor(std::size_t count, std::size_t batch_size, const Body& body)
+{
+	assert(m_job_count == 0);
+	batch_size = std::max<std::size_t>(1, batch_size);
+
+	if (m_threads.empty() || count <= batch_size)
+	{
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			body(i);
+		}
+		return;
+	}
+
+	for (std::size_t begin = 0; begin < count; begin += batch_size)
+	{
+		Job& job = m_jobs[AddJob()];
+		job.m_body = &body;
+		job.m_begin = begin;
+		job.m_end = std::min(count, begin + batch_size);
+	}
+	Run();
+	Clear();
+}
+
+void JobSystem::WorkerThread(std::size_t queue_index)
+{
+	std::size_t seen_generation = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_work_ready.wait(lock, [this, seen_generation] { return m_stopping || m_generation != seen_generation; });
+			if (m_stopping)
+			{
+				return;
+			}
+
+			seen_generation = m_generation;
+			m_active_workers++;
+		}
+
+		RunJobs(queue_index);
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_active_workers--;
+		}
+		m_work_done.notify_all();
+	}
+}
+
+void JobSystem::RunJobs(std::size_t queue_index)
+{
+	while (m_unfinished_jobs > 0)
+	{
+		JobId id;
+		if (!PopJob(queue_index, id))
+		{
+			//Everything left is running elsewhere or waiting for a job that is
+			std::this_thread::yield();
+			continue;
+		}
+
+		Job& job = m_jobs[id];
+		sf::Clock clock;
+		if (job.m_body)
+		{
+			for (std::size_t i = job.m_begin; i < job.m_end; ++i)
+			{
+				(*job.m_body)(i);
+			}
+		}
+		else
+		{
+			job.m_work();
+		}
+		job.m_time = clock.getElapsedTime();
+
+		//The last prerequisite to finish queues the dependent job on its own thread, where its inputs are still warm
+		for (JobId dependent : job.m_dependents)
+		{
+			if (--m_jobs[dependent].m_waiting_for == 0)
+			{
+				PushJob(queue_index, dependent);
+			}
+		}
+		m_unfinished_jobs--;
+	}
+}
+
+bool JobSystem::PopJob(std::size_t queue_index, JobId& job)
+{
+	{
+		Queue& own = *m_queues[queue_index];
+		std::lock_guard<std::mutex> lock(own.m_mutex);
+		if (own.m_first < own.m_jobs.size())
+		{
+			job = own.m_jobs.back();
+			own.m_jobs.pop_back();
+			if (own.m_first == own.m_jobs.size())
+			{
+				own.m_jobs.clear();
+				own.m_first = 0;
+			}
+			return true;
+		}
+	}
+
+	for (std::size_t i = 1; i < m_queues.size(); ++i)
+	{
+		Queue& victim = *m_queues[(queue_index + i) % m_queues.size()];
+		std::lock_guard<std::mutex> lock(victim.m_mutex);
+		if (victim.m_first < victim.m_jobs.size())
+		{
+			job = victim.m_jobs[victim.m_first++];
+			if (victim.m_first == victim.m_jobs.size())
+			{
+				victim.m_jobs.clear();
+				victim.m_first = 0;
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+void JobSystem::PushJob(std::size_t queue_index, JobId job)
+{
+	Queue& queue = *m_queues[queue_index];
+	std::lock_guard<std::mutex> lock(queue.m_mutex);
+	queue.m_jobs.emplace_back(job);
+}
+
+void JobSystem::WaitForWorkers()
+{
+	//Workers that are still on their way out of this run must be gone before the jobs change
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_work_done.wait(lock, [this] { return m_active_workers == 0; });
+}
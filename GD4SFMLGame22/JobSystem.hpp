@@ -0,0 +1,98 @@
+#pragma once
+#include <SFML/System/NonCopyable.hpp>
+#include <SFML/System/Time.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//Runs a graph of jobs on a fixed set of threads. Jobs are added with the jobs they have to wait for, then
+//Run hands them out and returns once all of them are done, so jobs may use anything the caller owns. Every
+//thread, the caller included, has its own queue: it works through its own jobs newest first and takes the
+//oldest job of another thread when it runs out. SFML has no condition variable, which is why this uses the
+//standard threads. Jobs and queues keep their storage between runs, so a graph no bigger than an earlier one
+//allocates nothing beyond what its work functions need
+
+class JobSystem : private sf::NonCopyable
+{
+public:
+	typedef std::function<void()> Work;
+	typedef std::function<void(std::size_t)> Body;
+	typedef std::size_t JobId;
+
+public:
+	//thread_count extra threads next to the caller, 0 runs everything on the caller
+	explicit JobSystem(std::size_t thread_count);
+	~JobSystem();
+
+	//Threads that take part in a run, the caller included
+	std::size_t GetThreadCount() const;
+	//One thread for every core but the caller's
+	static std::size_t GetSpareThreadCount();
+
+	//The job runs once every prerequisite has finished. Jobs can only be added between runs
+	JobId AddJob(Work work);
+	JobId AddJob(Work work, const std::vector<JobId>& prerequisites);
+	void Run();
+	//How long the job took in the last run
+	sf::Time GetJobTime(JobId job) const;
+	//Forgets the jobs of the last run so the next graph can be built
+	void Clear();
+
+	//Runs body(0) to body(count - 1) in jobs of up to batch_size iterations. Nothing else may be waiting to run.
+	//The batches only point at body, so nothing is allocated for them
+	void ParallelFor(std::size_t count, std::size_t batch_size, const Body& body);
+
+private:
+	struct Job
+	{
+		Work m_work;
+		//Set instead of m_work for the batches of ParallelFor, which run (*m_body)(m_begin) to (*m_body)(m_end - 1)
+		const Body* m_body;
+		std::size_t m_begin;
+		std::size_t m_end;
+		std::vector<JobId> m_dependents;
+		std::atomic<std::size_t> m_waiting_for;
+		sf::Time m_time;
+	};
+
+	//Jobs from m_first on are queued. The owner pops from the back, others take from m_first, and the vector
+	//is emptied once both meet so it keeps its capacity
+	struct Queue
+	{
+		Queue();
+		std::mutex m_mutex;
+		std::vector<JobId> m_jobs;
+		std::size_t m_first;
+	};
+
+private:
+	JobId AddJob();
+	void WorkerThread(std::size_t queue_index);
+	void RunJobs(std::size_t queue_index);
+	bool PopJob(std::size_t queue_index, JobId& job);
+	void PushJob(std::size_t queue_index, JobId job);
+	void WaitForWorkers();
+
+private:
+	std::vector<std::thread> m_threads;
+	std::vector<std::unique_ptr<Queue>> m_queues;
+	std::mutex m_mutex;
+	std::condition_variable m_work_ready;
+	std::condition_variable m_work_done;
+
+	//A deque so jobs never move while other threads look at them. Only the first m_job_count are in use, the
+	//rest are kept from earlier runs
+	std::deque<Job> m_jobs;
+	std::size_t m_job_count;
+	std::atomic<std::size_t> m_unfinished_jobs;
+	std::size_t m_generation;
+	std::size_t m_active_workers;
+	bool m_stopping;
+};
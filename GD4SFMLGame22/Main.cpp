@@ -1,16 +1,136 @@
+#include <cstdlib>
 #include <iostream>
+#include <string>
+#include <SFML/System/Sleep.hpp>
 #include "Application.hpp"
+#include "DebugSettings.hpp"
+#include "DemoRecorder.hpp"
+#include "GameServer.hpp"
+#include "JobSystem.hpp"
+#include "ShardConfig.hpp"
 
-int main()
+namespace
 {
+	//GD4SFMLGame22 --server [--shard <index> --shards <count>] runs a server without a window. Start one
+	//process per shard on the same machine, e.g. --shard 0 --shards 3, --shard 1 --shards 3 and
+	//--shard 2 --shards 3, then join as usual. Clients are moved between them as the battlefield scrolls.
+	//--record-demo <file> records the network traffic of a client or server, --play-demo <file> replays a
+	//client's demo without connecting, --demo-speed <factor> plays it faster or slower. --simulation-rate <hz>
+	//steps the game less often on slow machines, drawing stays smooth. --threads <count> sets how many threads
+	//share each step, the main thread included, which is how the scaling of the per phase times is measured.
+	//--render-log <file> writes the draw calls of a demo played back, to diff against an earlier build.
+	//--target-fps <rate> lowers the drawing quality while frames are slower than that, 0 keeps it at the highest.
+	//--cpu-bloom does the bloom on the CPU on machines without shaders, which otherwise go without it.
+	//--stats prints how long startup took and the timings and counters of the world and the server every 10
+	//seconds. Playing the same demo with --stats and --threads 1, 2, ... up to the core count gives the
+	//scaling of each update phase.
+	//--unbatched makes a server write every packet straight away, to compare its --stats with batching.
+	//--server-threads <count> sets how many threads a server shares its peers out over, for the same kind of
+	//scaling measurement on the server.
+	void RunServer(const ShardConfig& shard_config, const DemoSettings& demo_settings, const DebugSettings& debug_settings)
+	{
+		//Same battlefield as the window of a hosting client
+		GameServer server(sf::Vector2f(1024.f, 768.f), shard_config, demo_settings.m_record_path, debug_settings);
+		std::cout << "Serving shard " << shard_config.GetIndex() << " of " << shard_config.GetCount() << " on port " << shard_config.GetClientPort(shard_config.GetIndex()) << std::endl;
+
+		//The server runs on its own thread, this one only has to keep the process alive
+		while (true)
+		{
+			sf::sleep(sf::seconds(1.f));
+		}
+	}
+}
+
+//PerformanceChecks.cpp has the entry point when PERFORMANCE_CHECKS is defined
+#ifndef PERFORMANCE_CHECKS
+int main(int argc, char* argv[])
+{
+	bool run_server = false;
+	std::size_t shard_index = 0;
+	std::size_t shard_count = 1;
+	DemoSettings demo_settings;
+	DebugSettings debug_settings;
+	unsigned int simulation_rate = 60;
+	unsigned int target_frame_rate = 60;
+	bool cpu_bloom = false;
+	std::size_t worker_threads = JobSystem::GetSpareThreadCount();
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string argument = argv[i];
+		if (argument == "--server")
+		{
+			run_server = true;
+		}
+		else if (argument == "--shard" && i + 1 < argc)
+		{
+			shard_index = std::strtoul(argv[++i], nullptr, 10);
+		}
+		else if (argument == "--shards" && i + 1 < argc)
+		{
+			shard_count = std::strtoul(argv[++i], nullptr, 10);
+		}
+		else if (argument == "--record-demo" && i + 1 < argc)
+		{
+			demo_settings.m_record_path = argv[++i];
+		}
+		else if (argument == "--play-demo" && i + 1 < argc)
+		{
+			demo_settings.m_playback_path = argv[++i];
+		}
+		else if (argument == "--demo-speed" && i + 1 < argc)
+		{
+			demo_settings.m_playback_speed = static_cast<float>(std::atof(argv[++i]));
+		}
+		else if (argument == "--render-log" && i + 1 < argc)
+		{
+			demo_settings.m_render_log_path = argv[++i];
+		}
+		else if (argument == "--stats")
+		{
+			debug_settings.m_report_statistics = true;
+		}
+		else if (argument == "--unbatched")
+		{
+			debug_settings.m_unbatched_sends = true;
+		}
+		else if (argument == "--server-threads" && i + 1 < argc)
+		{
+			debug_settings.m_server_threads = std::strtoul(argv[++i], nullptr, 10);
+		}
+		else if (argument == "--threads" && i + 1 < argc)
+		{
+			std::size_t threads = std::strtoul(argv[++i], nullptr, 10);
+			worker_threads = threads > 1 ? threads - 1 : 0;
+		}
+		else if (argument == "--cpu-bloom")
+		{
+			cpu_bloom = true;
+		}
+		else if (argument == "--target-fps" && i + 1 < argc)
+		{
+			target_frame_rate = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (argument == "--simulation-rate" && i + 1 < argc)
+		{
+			simulation_rate = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+		}
+	}
+
 	try
 	{
-		Application app;
-		app.Run();
+		if (run_server)
+		{
+			RunServer(ShardConfig(shard_index, shard_count), demo_settings, debug_settings);
+		}
+		else
+		{
+			Application app(demo_settings, debug_settings, simulation_rate, worker_threads, target_frame_rate, cpu_bloom);
+			app.Run();
+		}
 	}
 	catch (std::exception& e)
 	{
 		std::cout << "\nEXCEPTION: " << e.what() << std::endl;
 	}
 }
-
+#endif
@@ -10,6 +10,12 @@
 #include <SFML/Network/Packet.hpp>
 
 #include "PickupType.hpp"
+#include "WireFormat.hpp"
+
+namespace
+{
+	const sf::Time ConnectTimeout = sf::seconds(5.f);
+}
 
 sf::IpAddress GetAddressFromFile()
 {
@@ -31,11 +37,23 @@ sf::IpAddress GetAddressFromFile()
 }
 
 MultiplayerGameState::MultiplayerGameState(StateStack& stack, Context context, bool is_host)
+: MultiplayerGameState(stack, context, is_host, std::string())
+{
+}
+
+MultiplayerGameState::MultiplayerGameState(StateStack& stack, Context context, const std::string& demo_path)
+: MultiplayerGameState(stack, context, false, demo_path)
+{
+}
+
+MultiplayerGameState::MultiplayerGameState(StateStack& stack, Context context, bool is_host, const std::string& demo_path)
 : State(stack, context)
-, m_world(*context.window, *context.fonts, *context.sounds, true)
+, m_world(*context.window, *context.fonts, *context.sounds, *context.timing, *context.jobs, *context.quality, *context.textures, true)
 , m_window(*context.window)
 , m_texture_holder(*context.textures)
 , m_connected(false)
+, m_connecting(false)
+, m_migration_token(0)
 , m_game_server(nullptr)
 , m_active_state(true)
 , m_has_focus(true)
@@ -43,6 +61,10 @@ MultiplayerGameState::MultiplayerGameState(StateStack& stack, Context context, b
 , m_game_started(false)
 , m_client_timeout(sf::seconds(2.f))
 , m_time_since_last_packet(sf::seconds(0.f))
+, m_network_tick(0)
+, m_connection_count(0)
+, m_playback(!demo_path.empty())
+, m_playback_speed(context.demo->m_playback_speed)
 {
 	m_broadcast_text.setFont(context.fonts->Get(Fonts::Main));
 	m_broadcast_text.setPosition(1024.f / 2, 100.f);
@@ -53,7 +75,7 @@ MultiplayerGameState::MultiplayerGameState(StateStack& stack, Context context, b
 	m_player_invitation_text.setString("Press Enter to spawn player 2");
 	m_player_invitation_text.setPosition(1000 - m_player_invitation_text.getLocalBounds().width, 760 - m_player_invitation_text.getLocalBounds().height);
 
-	//We reuse this text for "Attempt to connect" and "Failed to connect" messages
+	//We reuse this text for "Attempt to connect" and "Failed to connect" messages, it is drawn until the connect completes
 	m_failed_connection_text.setFont(context.fonts->Get(Fonts::Main));
 	m_failed_connection_text.setString("Attempting to connect...");
 	m_failed_connection_text.setCharacterSize(35);
@@ -61,39 +83,194 @@ MultiplayerGameState::MultiplayerGameState(StateStack& stack, Context context, b
 	Utility::CentreOrigin(m_failed_connection_text);
 	m_failed_connection_text.setPosition(m_window.getSize().x / 2.f, m_window.getSize().y / 2.f);
 
-	//Render an "establishing connection" frame for user feedback
-	m_window.clear(sf::Color::Black);
-	m_window.draw(m_failed_connection_text);
-	m_window.display();
-	m_failed_connection_text.setString("Could not connect to the remote server");
-	Utility::CentreOrigin(m_failed_connection_text);
+	if(context.debug->m_report_statistics)
+	{
+		m_world.EnableStatistics();
+	}
 
-	sf::IpAddress ip;
-	if(m_host)
+	//A demo stands in for the server, messages are read from the file instead of a socket
+	if(m_playback)
 	{
-		m_game_server.reset(new GameServer(sf::Vector2f(m_window.getSize())));
-		ip = "127.0.0.1";
+		m_connected = m_demo_player.Open(demo_path);
+		if(!m_connected)
+		{
+			m_failed_connection_text.setString("Could not play the demo");
+			Utility::CentreOrigin(m_failed_connection_text);
+			m_failed_connection_clock.restart();
+		}
+		if(!context.demo->m_render_log_path.empty())
+		{
+			m_world.LogRendering(context.demo->m_render_log_path);
+		}
+		context.music->Play(MusicThemes::kMissionTheme);
+		return;
 	}
-	else
+
+	const std::string& record_path = context.demo->m_record_path;
+	if(!record_path.empty())
 	{
-		ip = GetAddressFromFile();
+		m_demo_recorder.Open(record_path);
 	}
 
-	if(m_socket.connect(ip, SERVER_PORT, sf::seconds(5.f)) == sf::TcpSocket::Done)
+	if(m_host)
 	{
-		m_connected = true;
+		//The hosted server records what it sees next to the client's demo
+		m_game_server.reset(new GameServer(sf::Vector2f(m_window.getSize()), ShardConfig(), record_path.empty() ? record_path : record_path + ".server", *context.debug));
+		m_server_address = "127.0.0.1";
 	}
 	else
 	{
-		m_failed_connection_clock.restart();
+		m_server_address = GetAddressFromFile();
 	}
 
-	m_socket.setBlocking(false);
+	//A sharded server is always joined through its first shard. The game starts once the connect completes
+	if(!Connect(SERVER_PORT, 0))
+	{
+		m_failed_connection_text.setString("Could not connect to the remote server");
+		Utility::CentreOrigin(m_failed_connection_text);
+		m_failed_connection_clock.restart();
+	}
 
 	//Play game theme
 	context.music->Play(MusicThemes::kMissionTheme);
 }
 
+//Only starts the connect, so neither joining nor following a migration stalls the game. UpdateConnection
+//finishes it in a later frame. Returns false if the connect failed straight away
+
+bool MultiplayerGameState::Connect(unsigned short port, sf::Uint32 migration_token)
+{
+	m_socket.disconnect();
+	m_socket.setBlocking(false);
+	sf::Socket::Status status = m_socket.connect(m_server_address, port);
+	if(status != sf::Socket::Done && status != sf::Socket::NotReady)
+	{
+		m_connecting = false;
+		return false;
+	}
+
+	m_connecting = true;
+	m_migration_token = migration_token;
+	m_connect_clock.restart();
+	UpdateConnection();
+	return true;
+}
+
+void MultiplayerGameState::UpdateConnection()
+{
+	//A socket only has a remote address once the connect has gone through
+	if(m_socket.getRemoteAddress() == sf::IpAddress::None)
+	{
+		if(m_connect_clock.getElapsedTime() > ConnectTimeout)
+		{
+			m_socket.disconnect();
+			m_connecting = false;
+			m_connected = false;
+			m_failed_connection_text.setString(m_connection_count == 0 ? "Could not connect to the remote server" : "Lost connection to the server");
+			Utility::CentreOrigin(m_failed_connection_text);
+			m_failed_connection_clock.restart();
+		}
+		return;
+	}
+
+	m_connecting = false;
+	m_connected = true;
+	m_time_since_last_packet = sf::Time::Zero;
+
+	//The server waits for this before spawning us, or before handing us back our aircraft after a migration
+	sf::Packet packet;
+	packet << Wire::Tag(Client::PacketType::Hello) << Wire::VarInt(PROTOCOL_VERSION) << Wire::VarInt(m_migration_token);
+	m_connection_count++;
+	SendPacket(packet);
+}
+
+void MultiplayerGameState::SendPacket(sf::Packet& packet)
+{
+	//Nothing can go out while the socket is still connecting to the next shard
+	if(m_connecting)
+	{
+		return;
+	}
+	m_demo_recorder.Record(DemoDirection::Sent, m_network_tick, m_connection_count, packet.getData(), packet.getDataSize());
+	m_socket.send(packet);
+}
+
+//Recorded messages go through HandlePacket exactly as if they had just arrived. Scaling the clock with
+//the playback speed replays a demo faster or slower than it was recorded
+
+void MultiplayerGameState::UpdatePlayback(sf::Time dt)
+{
+	m_playback_time += dt * m_playback_speed;
+
+	DemoMessage message;
+	while(m_demo_player.PollMessage(m_playback_time, message))
+	{
+		m_playback_packet.clear();
+		m_playback_packet.append(message.m_data, message.m_size);
+
+		sf::Int32 packet_type;
+		if(!(m_playback_packet >> Wire::Tag(packet_type)))
+		{
+			continue;
+		}
+
+		if(message.m_direction == DemoDirection::Received)
+		{
+			HandlePacket(packet_type, m_playback_packet);
+		}
+		else if(static_cast<Client::PacketType>(packet_type) == Client::PacketType::PositionUpdate)
+		{
+			ApplyRecordedPositionUpdate(m_playback_packet);
+		}
+	}
+
+	if(m_demo_player.IsFinished())
+	{
+		m_connected = false;
+		m_failed_connection_text.setString("End of the demo");
+		Utility::CentreOrigin(m_failed_connection_text);
+		m_failed_connection_clock.restart();
+	}
+}
+
+//The server never echoes a client's own aircraft back to it, so the local aircraft are moved to where the
+//recorded client said they were
+
+void MultiplayerGameState::ApplyRecordedPositionUpdate(sf::Packet& packet)
+{
+	sf::Int32 aircraft_count;
+	packet >> Wire::VarInt(aircraft_count);
+
+	for(sf::Int32 i = 0; i < aircraft_count; ++i)
+	{
+		sf::Int32 aircraft_identifier;
+		sf::Vector2f aircraft_position;
+		sf::Int32 hitpoints;
+		sf::Int32 missile_ammo;
+		sf::Uint32 newest_tick;
+		sf::Uint32 input_count;
+		packet >> Wire::VarInt(aircraft_identifier) >> Wire::Position(aircraft_position) >> Wire::VarInt(hitpoints) >> Wire::VarInt(missile_ammo);
+		packet >> Wire::VarInt(newest_tick) >> Wire::VarInt(input_count);
+		for(sf::Uint32 j = 0; j < input_count && packet; ++j)
+		{
+			sf::Uint8 input;
+			packet >> input;
+		}
+
+		if(!packet)
+		{
+			return;
+		}
+
+		if(Aircraft* aircraft = m_world.GetAircraft(aircraft_identifier))
+		{
+			aircraft->setPosition(aircraft_position);
+			aircraft->SetHitpoints(hitpoints);
+			aircraft->SetMissileAmmo(missile_ammo);
+		}
+	}
+}
+
 void MultiplayerGameState::Draw()
 {
 	if(m_connected)
@@ -121,6 +298,11 @@ void MultiplayerGameState::Draw()
 
 bool MultiplayerGameState::Update(sf::Time dt)
 {
+	if(m_connecting)
+	{
+		UpdateConnection();
+	}
+
 	//Connected to the Server: Handle all the network logic
 	if(m_connected)
 	{
@@ -157,8 +339,8 @@ bool MultiplayerGameState::Update(sf::Time dt)
 			RequestStackPush(StateID::kGameOver);
 		}
 
-		//Only handle the realtime input if the window has focus and the game is unpaused
-		if(m_active_state && m_has_focus)
+		//Only handle the realtime input if the window has focus and the game is unpaused. A demo plays by itself
+		if(m_active_state && m_has_focus && !m_playback)
 		{
 			CommandQueue& commands = m_world.GetCommandQueue();
 			for(auto& pair : m_players)
@@ -174,25 +356,40 @@ bool MultiplayerGameState::Update(sf::Time dt)
 			pair.second->HandleRealtimeNetworkInput(commands);
 		}
 
-		//Handle messages from the server that may have arrived
-		sf::Packet packet;
-		if(m_socket.receive(packet) == sf::Socket::Done)
+		//Handle messages from the server that may have arrived, or the ones recorded in the demo
+		if(m_playback)
 		{
-			m_time_since_last_packet = sf::seconds(0.f);
-			sf::Int32 packet_type;
-			packet >> packet_type;
-			HandlePacket(packet_type, packet);
+			UpdatePlayback(dt);
 		}
-		else
+		else if(!m_connecting)
 		{
-			//Check for timeout with the server
-			if(m_time_since_last_packet > m_client_timeout)
+			//The server batches a whole tick of packets into one write, so drain everything that is waiting
+			sf::Packet packet;
+			bool received_packet = false;
+			while(m_socket.receive(packet) == sf::Socket::Done)
 			{
-				m_connected = false;
-				m_failed_connection_text.setString("Lost connection to the server");
-				Utility::CentreOrigin(m_failed_connection_text);
+				m_demo_recorder.Record(DemoDirection::Received, m_network_tick, m_connection_count, packet.getData(), packet.getDataSize());
+				m_time_since_last_packet = sf::seconds(0.f);
+				received_packet = true;
+				sf::Int32 packet_type;
+				if(packet >> Wire::Tag(packet_type))
+				{
+					HandlePacket(packet_type, packet);
+				}
+				packet.clear();
+			}
 
-				m_failed_connection_clock.restart();
+			if(!received_packet)
+			{
+				//Check for timeout with the server
+				if(m_time_since_last_packet > m_client_timeout)
+				{
+					m_connected = false;
+					m_failed_connection_text.setString("Lost connection to the server");
+					Utility::CentreOrigin(m_failed_connection_text);
+
+					m_failed_connection_clock.restart();
+				}
 			}
 		}
 
@@ -209,37 +406,55 @@ bool MultiplayerGameState::Update(sf::Time dt)
 		GameActions::Action game_action;
 		while(m_world.PollGameAction(game_action))
 		{
+			if(m_playback)
+			{
+				continue;
+			}
+
 			sf::Packet packet;
-			packet << static_cast<sf::Int32>(Client::PacketType::GameEvent);
-			packet << static_cast<sf::Int32>(game_action.type);
-			packet << game_action.position.x;
-			packet << game_action.position.y;
+			packet << Wire::Tag(Client::PacketType::GameEvent);
+			packet << Wire::VarInt(game_action.type);
+			packet << Wire::Position(game_action.position);
 
-			m_socket.send(packet);
+			SendPacket(packet);
 		}
 
-		//Regular position updates
-		if(m_tick_clock.getElapsedTime() > sf::seconds(1.f/20.f))
+		//Regular position updates, which also carry the input of the local players
+		if(!m_playback && !m_connecting && m_tick_clock.getElapsedTime() > sf::seconds(1.f/20.f))
 		{
-			sf::Packet position_update_packet;
-			position_update_packet << static_cast<sf::Int32>(Client::PacketType::PositionUpdate);
-			position_update_packet << static_cast<sf::Int32>(m_local_player_identifiers.size());
+			sf::Int32 aircraft_count = 0;
+			for(sf::Int32 identifier : m_local_player_identifiers)
+			{
+				if(m_world.GetAircraft(identifier))
+				{
+					aircraft_count++;
+				}
+			}
+
+			m_position_update_packet.clear();
+			m_position_update_packet << Wire::Tag(Client::PacketType::PositionUpdate);
+			m_position_update_packet << Wire::VarInt(aircraft_count);
 
 			for(sf::Int32 identifier : m_local_player_identifiers)
 			{
 				if(Aircraft* aircraft = m_world.GetAircraft(identifier))
 				{
-					position_update_packet << identifier << aircraft->getPosition().x << aircraft->getPosition().y << static_cast<sf::Int32>(aircraft->GetHitPoints()) << static_cast<sf::Int32>(aircraft->GetMissileAmmo());
+					Player& player = *m_players[identifier];
+					player.SampleInput(m_active_state && m_has_focus);
+
+					m_position_update_packet << Wire::VarInt(identifier) << Wire::Position(aircraft->getPosition()) << Wire::VarInt(aircraft->GetHitPoints()) << Wire::VarInt(aircraft->GetMissileAmmo());
+					player.WriteInput(m_position_update_packet);
 				}
 			}
-			m_socket.send(position_update_packet);
+			SendPacket(m_position_update_packet);
 			m_tick_clock.restart();
+			m_network_tick++;
 		}
 		m_time_since_last_packet += dt;
 	}
 
 	//Failed to connect and waited for more than 5 seconds: Back to menu
-	else if(m_failed_connection_clock.getElapsedTime() >= sf::seconds(5.f))
+	else if(!m_connecting && m_failed_connection_clock.getElapsedTime() >= sf::seconds(5.f))
 	{
 		RequestStackClear();
 		RequestStackPush(StateID::kMenu);
@@ -252,20 +467,23 @@ bool MultiplayerGameState::HandleEvent(const sf::Event& event)
 	//Game input handling
 	CommandQueue& commands = m_world.GetCommandQueue();
 
-	//Forward events to all players
+	//Forward events to all players, unless they are being played back
 	for(auto& pair : m_players)
 	{
-		pair.second->HandleEvent(event, commands);
+		if(!m_playback)
+		{
+			pair.second->HandleEvent(event, commands);
+		}
 	}
 
 	if(event.type == sf::Event::KeyPressed)
 	{
 		//If enter pressed, add second player co-op only if there is only 1 player
-		if(event.key.code == sf::Keyboard::Return && m_local_player_identifiers.size()==1)
+		if(event.key.code == sf::Keyboard::Return && m_local_player_identifiers.size()==1 && !m_playback)
 		{
 			sf::Packet packet;
-			packet << static_cast<sf::Int32>(Client::PacketType::RequestCoopPartner);
-			m_socket.send(packet);
+			packet << Wire::Tag(Client::PacketType::RequestCoopPartner);
+			SendPacket(packet);
 		}
 		//If escape is pressed, show the pause screen
 		else if(event.key.code == sf::Keyboard::Escape)
@@ -292,12 +510,12 @@ void MultiplayerGameState::OnActivate()
 
 void MultiplayerGameState::OnDestroy()
 {
-	if(!m_host && m_connected)
+	if(!m_host && m_connected && !m_playback)
 	{
 		//Inform server this client is dying
 		sf::Packet packet;
-		packet << static_cast<sf::Int32>(Client::PacketType::Quit);
-		m_socket.send(packet);
+		packet << Wire::Tag(Client::PacketType::Quit);
+		SendPacket(packet);
 	}
 }
 
@@ -338,11 +556,21 @@ void MultiplayerGameState::HandlePacket(sf::Int32 packet_type, sf::Packet& packe
 {
 	switch (static_cast<Server::PacketType>(packet_type))
 	{
+	//The server speaks a different version of the protocol, nothing else it sends can be read
+	case Server::PacketType::ProtocolMismatch:
+	{
+		m_connected = false;
+		m_failed_connection_text.setString("The server is running a different version of the game");
+		Utility::CentreOrigin(m_failed_connection_text);
+		m_failed_connection_clock.restart();
+	}
+	break;
+
 		//Send message to all Clients
 	case Server::PacketType::BroadcastMessage:
 	{
 		std::string message;
-		packet >> message;
+		packet >> Wire::Text(message);
 		m_broadcasts.push_back(message);
 
 		//Just added the first message, display immediately
@@ -360,7 +588,7 @@ void MultiplayerGameState::HandlePacket(sf::Int32 packet_type, sf::Packet& packe
 	{
 		sf::Int32 aircraft_identifier;
 		sf::Vector2f aircraft_position;
-		packet >> aircraft_identifier >> aircraft_position.x >> aircraft_position.y;
+		packet >> Wire::VarInt(aircraft_identifier) >> Wire::Position(aircraft_position);
 		Aircraft* aircraft = m_world.AddAircraft(aircraft_identifier);
 		aircraft->setPosition(aircraft_position);
 		m_players[aircraft_identifier].reset(new Player(&m_socket, aircraft_identifier, GetContext().keys1));
@@ -373,7 +601,7 @@ void MultiplayerGameState::HandlePacket(sf::Int32 packet_type, sf::Packet& packe
 	{
 		sf::Int32 aircraft_identifier;
 		sf::Vector2f aircraft_position;
-		packet >> aircraft_identifier >> aircraft_position.x >> aircraft_position.y;
+		packet >> Wire::VarInt(aircraft_identifier) >> Wire::Position(aircraft_position);
 
 		Aircraft* aircraft = m_world.AddAircraft(aircraft_identifier);
 		aircraft->setPosition(aircraft_position);
@@ -384,7 +612,7 @@ void MultiplayerGameState::HandlePacket(sf::Int32 packet_type, sf::Packet& packe
 	case Server::PacketType::PlayerDisconnect:
 	{
 		sf::Int32 aircraft_identifier;
-		packet >> aircraft_identifier;
+		packet >> Wire::VarInt(aircraft_identifier);
 		m_world.RemoveAircraft(aircraft_identifier);
 		m_players.erase(aircraft_identifier);
 	}
@@ -394,19 +622,19 @@ void MultiplayerGameState::HandlePacket(sf::Int32 packet_type, sf::Packet& packe
 	{
 		sf::Int32 aircraft_count;
 		float world_height, current_scroll;
-		packet >> world_height >> current_scroll;
+		packet >> Wire::CoordinateY(world_height) >> Wire::CoordinateY(current_scroll);
 
 		m_world.SetWorldHeight(world_height);
 		m_world.SetCurrentBattleFieldPosition(current_scroll);
 
-		packet >> aircraft_count;
+		packet >> Wire::VarInt(aircraft_count);
 		for (sf::Int32 i = 0; i < aircraft_count; ++i)
 		{
 			sf::Int32 aircraft_identifier;
 			sf::Int32 hitpoints;
 			sf::Int32 missile_ammo;
 			sf::Vector2f aircraft_position;
-			packet >> aircraft_identifier >> aircraft_position.x >> aircraft_position.y >> hitpoints >> missile_ammo;
+			packet >> Wire::VarInt(aircraft_identifier) >> Wire::Position(aircraft_position) >> Wire::VarInt(hitpoints) >> Wire::VarInt(missile_ammo);
 
 			Aircraft* aircraft = m_world.AddAircraft(aircraft_identifier);
 			aircraft->setPosition(aircraft_position);
@@ -421,7 +649,7 @@ void MultiplayerGameState::HandlePacket(sf::Int32 packet_type, sf::Packet& packe
 	case Server::PacketType::AcceptCoopPartner:
 	{
 		sf::Int32 aircraft_identifier;
-		packet >> aircraft_identifier;
+		packet >> Wire::VarInt(aircraft_identifier);
 
 		m_world.AddAircraft(aircraft_identifier);
 		m_players[aircraft_identifier].reset(new Player(&m_socket, aircraft_identifier, GetContext().keys2));
@@ -434,7 +662,7 @@ void MultiplayerGameState::HandlePacket(sf::Int32 packet_type, sf::Packet& packe
 	{
 		sf::Int32 aircraft_identifier;
 		sf::Int32 action;
-		packet >> aircraft_identifier >> action;
+		packet >> Wire::VarInt(aircraft_identifier) >> Wire::VarInt(action);
 
 		auto itr = m_players.find(aircraft_identifier);
 		if (itr != m_players.end())
@@ -450,7 +678,7 @@ void MultiplayerGameState::HandlePacket(sf::Int32 packet_type, sf::Packet& packe
 		sf::Int32 aircraft_identifier;
 		sf::Int32 action;
 		bool action_enabled;
-		packet >> aircraft_identifier >> action >> action_enabled;
+		packet >> Wire::VarInt(aircraft_identifier) >> Wire::VarInt(action) >> Wire::Flags(action_enabled);
 
 		auto itr = m_players.find(aircraft_identifier);
 		if (itr != m_players.end())
@@ -466,7 +694,7 @@ void MultiplayerGameState::HandlePacket(sf::Int32 packet_type, sf::Packet& packe
 		float height;
 		sf::Int32 type;
 		float relative_x;
-		packet >> type >> height >> relative_x;
+		packet >> Wire::VarInt(type) >> Wire::CoordinateY(height) >> Wire::CoordinateX(relative_x);
 
 		m_world.AddEnemy(static_cast<AircraftType>(type), relative_x, height);
 		m_world.SortEnemies();
@@ -485,7 +713,7 @@ void MultiplayerGameState::HandlePacket(sf::Int32 packet_type, sf::Packet& packe
 	{
 		sf::Int32 type;
 		sf::Vector2f position;
-		packet >> type >> position.x >> position.y;
+		packet >> Wire::VarInt(type) >> Wire::Position(position);
 		std::cout << "Spawning pickup type " << type << std::endl;
 		m_world.CreatePickup(position, static_cast<PickupType>(type));
 	}
@@ -495,7 +723,7 @@ void MultiplayerGameState::HandlePacket(sf::Int32 packet_type, sf::Packet& packe
 	{
 		float current_world_position;
 		sf::Int32 aircraft_count;
-		packet >> current_world_position >> aircraft_count;
+		packet >> Wire::CoordinateY(current_world_position) >> Wire::VarInt(aircraft_count);
 
 		float current_view_position = m_world.GetViewBounds().top + m_world.GetViewBounds().height;
 
@@ -508,7 +736,7 @@ void MultiplayerGameState::HandlePacket(sf::Int32 packet_type, sf::Packet& packe
 			sf::Int32 aircraft_identifier;
 			sf::Int32 hitpoints;
 			sf::Int32 ammo;
-			packet >> aircraft_identifier >> aircraft_position.x >> aircraft_position.y >> hitpoints >> ammo;
+			packet >> Wire::VarInt(aircraft_identifier) >> Wire::Position(aircraft_position) >> Wire::VarInt(hitpoints) >> Wire::VarInt(ammo);
 
 			Aircraft* aircraft = m_world.GetAircraft(aircraft_identifier);
 			bool is_local_plane = std::find(m_local_player_identifiers.begin(), m_local_player_identifiers.end(), aircraft_identifier) != m_local_player_identifiers.end();
@@ -522,5 +750,60 @@ void MultiplayerGameState::HandlePacket(sf::Int32 packet_type, sf::Packet& packe
 		}
 	}
 	break;
+
+	//Another player's aircraft came close enough for the server to start sending it
+	case Server::PacketType::AircraftEnter:
+	{
+		sf::Int32 aircraft_identifier;
+		sf::Int32 hitpoints;
+		sf::Int32 missile_ammo;
+		sf::Vector2f aircraft_position;
+		packet >> Wire::VarInt(aircraft_identifier) >> Wire::Position(aircraft_position) >> Wire::VarInt(hitpoints) >> Wire::VarInt(missile_ammo);
+
+		if (!m_world.GetAircraft(aircraft_identifier))
+		{
+			Aircraft* aircraft = m_world.AddAircraft(aircraft_identifier);
+			aircraft->setPosition(aircraft_position);
+			aircraft->SetHitpoints(hitpoints);
+			aircraft->SetMissileAmmo(missile_ammo);
+
+			m_players[aircraft_identifier].reset(new Player(&m_socket, aircraft_identifier, nullptr));
+		}
+	}
+	break;
+
+	//And moved far enough away for the server to stop
+	case Server::PacketType::AircraftLeave:
+	{
+		sf::Int32 aircraft_identifier;
+		packet >> Wire::VarInt(aircraft_identifier);
+
+		bool is_local_plane = std::find(m_local_player_identifiers.begin(), m_local_player_identifiers.end(), aircraft_identifier) != m_local_player_identifiers.end();
+		if (!is_local_plane)
+		{
+			m_world.RemoveAircraft(aircraft_identifier);
+			m_players.erase(aircraft_identifier);
+		}
+	}
+	break;
+
+	//Our aircraft flew into the part of the world another server process looks after, it is expecting us
+	case Server::PacketType::Migrate:
+	{
+		sf::Int32 port;
+		sf::Uint32 migration_token;
+		packet >> Wire::VarInt(port) >> Wire::VarInt(migration_token);
+
+		//A demo simply carries on with the messages of the next connection. The world keeps running while the
+		//connect to the next shard completes
+		if (!m_playback && !Connect(static_cast<unsigned short>(port), migration_token))
+		{
+			m_connected = false;
+			m_failed_connection_text.setString("Lost connection to the server");
+			Utility::CentreOrigin(m_failed_connection_text);
+			m_failed_connection_clock.restart();
+		}
+	}
+	break;
 	}
 }
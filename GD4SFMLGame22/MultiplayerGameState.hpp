@@ -4,11 +4,17 @@
 #include "Player.hpp"
 #include "GameServer.hpp"
 #include "NetworkProtocol.hpp"
+#include "DemoPlayer.hpp"
+#include "DemoRecorder.hpp"
+
+#include <SFML/Network/IpAddress.hpp>
 
 class MultiplayerGameState : public State
 {
 public:
 	MultiplayerGameState(StateStack& stack, Context context, bool is_host);
+	//Plays a demo recorded by an earlier session instead of connecting
+	MultiplayerGameState(StateStack& stack, Context context, const std::string& demo_path);
 	virtual void Draw();
 	virtual bool Update(sf::Time dt);
 	virtual bool HandleEvent(const sf::Event& event);
@@ -17,6 +23,12 @@ public:
 	void DisableAllRealtimeActions();
 
 private:
+	MultiplayerGameState(StateStack& stack, Context context, bool is_host, const std::string& demo_path);
+	bool Connect(unsigned short port, sf::Uint32 migration_token);
+	void UpdateConnection();
+	void SendPacket(sf::Packet& packet);
+	void UpdatePlayback(sf::Time dt);
+	void ApplyRecordedPositionUpdate(sf::Packet& packet);
 	void UpdateBroadcastMessage(sf::Time elapsed_time);
 	void HandlePacket(sf::Int32 packet_type, sf::Packet& packet);
 
@@ -31,9 +43,17 @@ private:
 	std::map<int, PlayerPtr> m_players;
 	std::vector<sf::Int32> m_local_player_identifiers;
 	sf::TcpSocket m_socket;
+	//Every shard of a server is reached on the same address, only the port changes
+	sf::IpAddress m_server_address;
 	bool m_connected;
+	//A connect is under way, the socket is polled every frame until it completes or times out
+	bool m_connecting;
+	sf::Clock m_connect_clock;
+	sf::Uint32 m_migration_token;
 	std::unique_ptr<GameServer> m_game_server;
 	sf::Clock m_tick_clock;
+	//Reused every tick so its buffer is only allocated once
+	sf::Packet m_position_update_packet;
 
 	std::vector<std::string> m_broadcasts;
 	sf::Text m_broadcast_text;
@@ -51,5 +71,16 @@ private:
 	bool m_game_started;
 	sf::Time m_client_timeout;
 	sf::Time m_time_since_last_packet;
+
+	//Demos are stamped with the number of position updates sent and the connection they arrived on
+	DemoRecorder m_demo_recorder;
+	sf::Uint32 m_network_tick;
+	sf::Uint32 m_connection_count;
+
+	DemoPlayer m_demo_player;
+	bool m_playback;
+	float m_playback_speed;
+	sf::Time m_playback_time;
+	sf::Packet m_playback_packet;
 };
 
@@ -0,0 +1,108 @@
+#include "NetworkPoller.hpp"
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <stdexcept>
+#endif
+
+#ifdef __linux__
+namespace
+{
+	//Upper bound on the number of events taken from the kernel per wait, anything left over is returned by the next wait
+	const int MaxEventsPerWait = 256;
+
+	//sf::Socket only exposes its native handle to derived classes
+	struct SocketHandle : sf::Socket
+	{
+		static sf::Socket::Handle Get(sf::Socket& socket)
+		{
+			return (socket.*(&SocketHandle::getHandle))();
+		}
+	};
+}
+
+NetworkPoller::NetworkPoller()
+	: m_epoll_descriptor(epoll_create1(0))
+{
+	if (m_epoll_descriptor < 0)
+	{
+		throw std::runtime_error("NetworkPoller - Failed to create epoll instance");
+	}
+}
+
+NetworkPoller::~NetworkPoller()
+{
+	close(m_epoll_descriptor);
+}
+
+void NetworkPoller::Add(sf::Socket& socket, std::size_t key)
+{
+	epoll_event event = {};
+	event.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+	event.data.u64 = key;
+	epoll_ctl(m_epoll_descriptor, EPOLL_CTL_ADD, SocketHandle::Get(socket), &event);
+}
+
+void NetworkPoller::Remove(sf::Socket& socket)
+{
+	epoll_event event = {};
+	epoll_ctl(m_epoll_descriptor, EPOLL_CTL_DEL, SocketHandle::Get(socket), &event);
+}
+
+bool NetworkPoller::Wait(sf::Time timeout, std::vector<std::size_t>& ready_keys)
+{
+	epoll_event events[MaxEventsPerWait];
+	int timeout_ms = std::max(timeout.asMilliseconds(), 0);
+
+	int count = epoll_wait(m_epoll_descriptor, events, MaxEventsPerWait, timeout_ms);
+	for (int i = 0; i < count; ++i)
+	{
+		ready_keys.emplace_back(static_cast<std::size_t>(events[i].data.u64));
+	}
+	return count > 0;
+}
+
+#else
+
+NetworkPoller::NetworkPoller()
+{
+}
+
+NetworkPoller::~NetworkPoller()
+{
+}
+
+void NetworkPoller::Add(sf::Socket& socket, std::size_t key)
+{
+	m_selector.add(socket);
+	m_sockets[&socket] = key;
+}
+
+void NetworkPoller::Remove(sf::Socket& socket)
+{
+	m_selector.remove(socket);
+	m_sockets.erase(&socket);
+}
+
+bool NetworkPoller::Wait(sf::Time timeout, std::vector<std::size_t>& ready_keys)
+{
+	//sf::SocketSelector treats a zero timeout as "wait forever"
+	if (!m_selector.wait(std::max(timeout, sf::milliseconds(1))))
+	{
+		return false;
+	}
+
+	for (auto& pair : m_sockets)
+	{
+		if (m_selector.isReady(*pair.first))
+		{
+			ready_keys.emplace_back(pair.second);
+		}
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,38 @@
+#pragma once
+#include <SFML/System/NonCopyable.hpp>
+#include <SFML/System/Time.hpp>
+#include <SFML/Network/Socket.hpp>
+
+#include <cstddef>
+#include <vector>
+
+#ifndef __linux__
+#include <map>
+#include <SFML/Network/SocketSelector.hpp>
+#endif
+
+//Tells the server which of its sockets have data waiting so that it only has to visit those.
+//On Linux this is an edge-triggered epoll set - a socket is reported once per burst of data, so the
+//caller must keep reading (or accepting) until SFML returns NotReady.
+//Everywhere else it falls back to sf::SocketSelector which reports every ready socket on each wait
+
+class NetworkPoller : private sf::NonCopyable
+{
+public:
+	NetworkPoller();
+	~NetworkPoller();
+
+	void Add(sf::Socket& socket, std::size_t key);
+	void Remove(sf::Socket& socket);
+
+	//Blocks for at most timeout and fills ready_keys with the keys of the sockets that became readable
+	bool Wait(sf::Time timeout, std::vector<std::size_t>& ready_keys);
+
+private:
+#ifdef __linux__
+	int m_epoll_descriptor;
+#else
+	sf::SocketSelector m_selector;
+	std::map<sf::Socket*, std::size_t> m_sockets;
+#endif
+};
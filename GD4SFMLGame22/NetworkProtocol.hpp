@@ -1,25 +1,60 @@
 #pragma once
+#include <SFML/Config.hpp>
 #include <SFML/System/Vector2.hpp>
 
+#include <cstddef>
+
 const unsigned short SERVER_PORT = 50000;
+//Servers that split the world between them link up on SHARD_LINK_PORT + shard index, see ShardConfig
+const unsigned short SHARD_LINK_PORT = 50100;
+
+//Bump whenever a message below changes. Fields are written with the helpers in WireFormat.hpp,
+//the layout of each message is listed next to its type
+const sf::Uint32 PROTOCOL_VERSION = 3;
+
+//How many ticks of input every position update repeats
+const std::size_t INPUT_HISTORY_SIZE = 4;
 
 namespace Server
 {
 	//These are packets that come from the Server
 	enum class PacketType
 	{
+		//Must stay first in every protocol version: VarInt server version
+		ProtocolMismatch,
+		//Text message
 		BroadcastMessage,
+		//CoordinateY world height, CoordinateY battlefield bottom, VarInt count, count x (VarInt id, Position, VarInt hitpoints, VarInt missile ammo)
 		InitialState,
+		//VarInt id, VarInt action
 		PlayerEvent,
+		//VarInt id, VarInt action, Flags(enabled)
 		PlayerRealtimeChange,
+		//VarInt id, Position
 		PlayerConnect,
+		//VarInt id
 		PlayerDisconnect,
+		//VarInt id, Position
 		AcceptCoopPartner,
+		//VarInt aircraft type, CoordinateY height above the bottom of the world, CoordinateX offset from the centre
 		SpawnEnemy,
+		//VarInt pickup type, Position
 		SpawnPickup,
+		//VarInt id, Position
 		SpawnSelf,
+		//CoordinateY battlefield bottom, VarInt count, count x (VarInt id, Position, VarInt hitpoints, VarInt missile ammo)
 		UpdateClientState,
-		MissionSuccess
+		//Nothing
+		MissionSuccess,
+		//An aircraft moved into or out of the area the receiving client is interested in
+		//VarInt id, Position, VarInt hitpoints, VarInt missile ammo
+		AircraftEnter,
+		//VarInt id
+		AircraftLeave,
+		//The client's aircraft flew into the band of another shard. Reconnect to the same address on the
+		//new port and hand the token back in Hello
+		//VarInt port, VarInt migration token
+		Migrate
 	};
 }
 
@@ -28,15 +63,43 @@ namespace Client
 	//Messages sent from the Client
 	enum class PacketType
 	{
-		PlayerEvent,
-		PlayerRealtimeChange,
+		//Must stay first in every protocol version: VarInt protocol version, VarInt migration token (0 when
+		//joining the game). Sent once on connect
+		Hello,
+		//Nothing
 		RequestCoopPartner,
+		//VarInt count, count x (VarInt id, Position, VarInt hitpoints, VarInt missile ammo,
+		//VarInt newest input tick, VarInt input count, input count x Uint8 PlayerAction bits newest first)
 		PositionUpdate,
+		//VarInt action, Position
 		GameEvent,
+		//Nothing
 		Quit
 	};
 }
 
+namespace Shard
+{
+	//Messages between the servers of neighbouring bands
+	enum class PacketType
+	{
+		//VarInt protocol version, VarInt shard index. Sent by both ends once the link is up
+		Hello,
+		//The aircraft the sender owns, sent every tick. The lower shard keeps the time, the upper adopts its battlefield
+		//CoordinateY battlefield top, VarInt count, count x (VarInt id, Position, VarInt hitpoints, VarInt missile ammo)
+		WorldState,
+		//A client's aircraft are moving to the receiver, which takes them over and answers with HandoffAccepted
+		//VarInt migration token, VarInt count, count x (VarInt id, Position, VarInt hitpoints, VarInt missile ammo,
+		//Uint8 input bits, VarInt next input tick), VarInt relevant count, relevant count x VarInt id
+		Handoff,
+		//VarInt migration token
+		HandoffAccepted,
+		//A message for the receiver's clients near a position, e.g. an enemy spawn close to the boundary
+		//Position, then a complete Server message
+		Relay
+	};
+}
+
 namespace GameActions
 {
 	enum Type
@@ -0,0 +1,213 @@
+#include "PacketTransport.hpp"
+
+#include <SFML/System/Clock.hpp>
+
+namespace
+{
+	const std::size_t FrameHeaderSize = sizeof(sf::Uint32);
+	const std::size_t ReceiveChunkSize = 4096;
+	const std::size_t InitialBufferSize = 4096;
+	//Far more than any message of the protocol, a header asking for more comes from a broken or hostile peer
+	const std::size_t MaxFrameSize = 64 * 1024;
+	//Once this much of the outbound buffer has gone out it is dropped, even while the rest is still waiting
+	const std::size_t OutboundCompactSize = 64 * 1024;
+}
+
+TransportStats::TransportStats()
+{
+	Reset();
+}
+
+void TransportStats::Reset()
+{
+	m_packets_sent = 0;
+	m_packets_received = 0;
+	m_send_calls = 0;
+	m_receive_calls = 0;
+	m_bytes_sent = 0;
+	m_cpu_time = sf::Time::Zero;
+}
+
+void TransportStats::Add(const TransportStats& other)
+{
+	m_packets_sent += other.m_packets_sent;
+	m_packets_received += other.m_packets_received;
+	m_send_calls += other.m_send_calls;
+	m_receive_calls += other.m_receive_calls;
+	m_bytes_sent += other.m_bytes_sent;
+	m_cpu_time += other.m_cpu_time;
+}
+
+PacketTransport::PacketTransport()
+	: m_outbound_sent(0)
+	, m_frame_start(0)
+	, m_inbound_read(0)
+	, m_inbound_checked(0)
+{
+	m_outbound.reserve(InitialBufferSize);
+	m_inbound.reserve(InitialBufferSize);
+}
+
+void PacketTransport::Clear()
+{
+	m_outbound.clear();
+	m_outbound_sent = 0;
+	m_frame_start = 0;
+	m_inbound.clear();
+	m_inbound_read = 0;
+	m_inbound_checked = 0;
+}
+
+void PacketTransport::Queue(const void* data, std::size_t size)
+{
+	BeginFrame().append(data, size);
+	EndFrame();
+}
+
+Wire::Writer PacketTransport::BeginFrame()
+{
+	//Leave room for the header, the size is only known once the fields are written
+	m_frame_start = m_outbound.size();
+	m_outbound.resize(m_frame_start + FrameHeaderSize);
+	return Wire::Writer(m_outbound);
+}
+
+void PacketTransport::EndFrame()
+{
+	//Same header sf::TcpSocket writes in front of a packet
+	sf::Uint32 length = static_cast<sf::Uint32>(m_outbound.size() - m_frame_start - FrameHeaderSize);
+	char* header = m_outbound.data() + m_frame_start;
+	header[0] = static_cast<char>((length >> 24) & 0xFF);
+	header[1] = static_cast<char>((length >> 16) & 0xFF);
+	header[2] = static_cast<char>((length >> 8) & 0xFF);
+	header[3] = static_cast<char>(length & 0xFF);
+}
+
+Wire::Reader PacketTransport::GetLastFrame() const
+{
+	return Wire::Reader(m_outbound.data() + m_frame_start + FrameHeaderSize, m_outbound.size() - m_frame_start - FrameHeaderSize);
+}
+
+sf::Socket::Status PacketTransport::Flush(sf::TcpSocket& socket, TransportStats& stats)
+{
+	if (!HasPendingOutput())
+	{
+		return sf::Socket::Done;
+	}
+
+	sf::Clock cpu_clock;
+	std::size_t sent = 0;
+	sf::Socket::Status status = socket.send(m_outbound.data() + m_outbound_sent, m_outbound.size() - m_outbound_sent, sent);
+	stats.m_send_calls++;
+	stats.m_bytes_sent += sent;
+
+	//A non-blocking socket may only take part of the buffer, the rest goes out with the next flush
+	m_outbound_sent += sent;
+	if (m_outbound_sent == m_outbound.size())
+	{
+		m_outbound.clear();
+		m_outbound_sent = 0;
+	}
+	else if (m_outbound_sent >= OutboundCompactSize)
+	{
+		//A peer that never quite catches up would otherwise keep the sent part around for good
+		m_outbound.erase(m_outbound.begin(), m_outbound.begin() + m_outbound_sent);
+		m_frame_start = m_frame_start >= m_outbound_sent ? m_frame_start - m_outbound_sent : 0;
+		m_outbound_sent = 0;
+	}
+
+	stats.m_cpu_time += cpu_clock.getElapsedTime();
+	return status;
+}
+
+bool PacketTransport::HasPendingOutput() const
+{
+	return m_outbound_sent < m_outbound.size();
+}
+
+std::size_t PacketTransport::GetPendingOutputSize() const
+{
+	return m_outbound.size() - m_outbound_sent;
+}
+
+sf::Socket::Status PacketTransport::Receive(sf::TcpSocket& socket, TransportStats& stats)
+{
+	sf::Clock cpu_clock;
+
+	//Drop the frames that have already been handed out
+	if (m_inbound_read > 0)
+	{
+		m_inbound.erase(m_inbound.begin(), m_inbound.begin() + m_inbound_read);
+		m_inbound_checked -= m_inbound_read;
+		m_inbound_read = 0;
+	}
+
+	sf::Socket::Status status;
+	for (;;)
+	{
+		std::size_t used = m_inbound.size();
+		m_inbound.resize(used + ReceiveChunkSize);
+
+		std::size_t received = 0;
+		status = socket.receive(m_inbound.data() + used, ReceiveChunkSize, received);
+		stats.m_receive_calls++;
+		m_inbound.resize(used + received);
+
+		if (!CheckInboundFrames())
+		{
+			status = sf::Socket::Error;
+			break;
+		}
+
+		//Keep reading until the socket is empty, the poller will not report it again otherwise.
+		//A short read already means the kernel buffer was drained
+		if (status != sf::Socket::Done || received < ReceiveChunkSize)
+		{
+			break;
+		}
+	}
+
+	stats.m_cpu_time += cpu_clock.getElapsedTime();
+	return status;
+}
+
+bool PacketTransport::PollFrame(Wire::Reader& frame)
+{
+	//Only frames whose size was checked are handed out
+	std::size_t available = m_inbound_checked - m_inbound_read;
+	if (available < FrameHeaderSize)
+	{
+		return false;
+	}
+
+	const unsigned char* header = reinterpret_cast<const unsigned char*>(m_inbound.data() + m_inbound_read);
+	std::size_t length = (static_cast<std::size_t>(header[0]) << 24) | (static_cast<std::size_t>(header[1]) << 16) | (static_cast<std::size_t>(header[2]) << 8) | header[3];
+	if (available < FrameHeaderSize + length)
+	{
+		return false;
+	}
+
+	frame = Wire::Reader(m_inbound.data() + m_inbound_read + FrameHeaderSize, length);
+	m_inbound_read += FrameHeaderSize + length;
+	return true;
+}
+
+bool PacketTransport::CheckInboundFrames()
+{
+	//Walks the headers of the frames that have arrived whole, and of the one still arriving
+	while (m_inbound.size() - m_inbound_checked >= FrameHeaderSize)
+	{
+		const unsigned char* header = reinterpret_cast<const unsigned char*>(m_inbound.data() + m_inbound_checked);
+		std::size_t length = (static_cast<std::size_t>(header[0]) << 24) | (static_cast<std::size_t>(header[1]) << 16) | (static_cast<std::size_t>(header[2]) << 8) | header[3];
+		if (length > MaxFrameSize)
+		{
+			return false;
+		}
+		if (m_inbound.size() - m_inbound_checked < FrameHeaderSize + length)
+		{
+			break;
+		}
+		m_inbound_checked += FrameHeaderSize + length;
+	}
+	return true;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <SFML/Config.hpp>
+#include <SFML/Network/TcpSocket.hpp>
+#include <SFML/System/Time.hpp>
+
+#include <cstddef>
+#include <vector>
+
+#include "WireFormat.hpp"
+
+//Buffers the traffic of one TCP connection so that a whole tick of packets costs one send and
+//one receive system call rather than one (or more) per packet.
+//Frames use the same layout as sf::TcpSocket::send(sf::Packet&) - a 32 bit big endian size followed
+//by the packet data - so the other end can keep receiving with sf::Packet.
+//Both buffers keep their capacity, so once a connection has warmed up it no longer allocates
+
+struct TransportStats
+{
+	TransportStats();
+	void Reset();
+	void Add(const TransportStats& other);
+
+	std::size_t m_packets_sent;
+	std::size_t m_packets_received;
+	std::size_t m_send_calls;
+	std::size_t m_receive_calls;
+	std::size_t m_bytes_sent;
+	sf::Time m_cpu_time;
+};
+
+class PacketTransport
+{
+public:
+	PacketTransport();
+
+	//Drops everything buffered in both directions so the transport can be used for a new connection
+	void Clear();
+
+	void Queue(const void* data, std::size_t size);
+
+	//Write a frame straight into the outbound buffer: fields go into the returned writer and EndFrame
+	//fills in the size. Nothing else may be queued in between
+	Wire::Writer BeginFrame();
+	void EndFrame();
+	//The frame finished by the last EndFrame or Queue, valid until the next Flush
+	Wire::Reader GetLastFrame() const;
+
+	sf::Socket::Status Flush(sf::TcpSocket& socket, TransportStats& stats);
+	bool HasPendingOutput() const;
+	std::size_t GetPendingOutputSize() const;
+
+	//Reads everything the socket has, then hands the buffered frames out one at a time. The reader points
+	//into the receive buffer and is only valid until the next Receive. A frame header larger than the protocol
+	//ever sends makes Receive stop and return sf::Socket::Error, the connection should be dropped
+	sf::Socket::Status Receive(sf::TcpSocket& socket, TransportStats& stats);
+	bool PollFrame(Wire::Reader& frame);
+
+private:
+	bool CheckInboundFrames();
+
+private:
+	std::vector<char> m_outbound;
+	std::size_t m_outbound_sent;
+	std::size_t m_frame_start;
+	std::vector<char> m_inbound;
+	std::size_t m_inbound_read;
+	//Frames before this have had their headers checked
+	std::size_t m_inbound_checked;
+};
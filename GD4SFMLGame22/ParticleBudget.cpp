@@ -0,0 +1,84 @@
+#include "ParticleBudget.hpp"
+
+#include <algorithm>
+
+namespace
+{
+	//Below this share of the cap everything is emitted, above it emission falls off to nothing at the cap
+	const float FullLoad = 0.5f;
+	//Emitters this far outside the view emit the least, closer ones are scaled between that and everything
+	const float FadeDistance = 400.f;
+	const float FarShare = 0.25f;
+}
+
+ParticleBudget::Counters::Counters()
+	: m_emitted(0)
+	, m_dropped(0)
+{
+}
+
+ParticleBudget::ParticleBudget(std::size_t max_particles)
+	: m_max_particles(max_particles)
+	, m_live_particles(0)
+	, m_load_share(1.f)
+{
+}
+
+void ParticleBudget::BeginStep(std::size_t live_particles, const sf::FloatRect& view_bounds)
+{
+	m_live_particles = live_particles;
+	m_view_bounds = view_bounds;
+
+	//Worked out once per step, the particles added during the step only count against the hard cap
+	float load = static_cast<float>(m_live_particles) / m_max_particles;
+	m_load_share = std::min(std::max((1.f - load) / (1.f - FullLoad), 0.f), 1.f);
+}
+
+float ParticleBudget::GetShare(sf::Vector2f position) const
+{
+	//Distance from position to the nearest point of the view, zero inside it
+	float dx = std::max(std::max(m_view_bounds.left - position.x, position.x - (m_view_bounds.left + m_view_bounds.width)), 0.f);
+	float dy = std::max(std::max(m_view_bounds.top - position.y, position.y - (m_view_bounds.top + m_view_bounds.height)), 0.f);
+	float distance = std::max(dx, dy);
+
+	float distance_share = 1.f - (1.f - FarShare) * std::min(distance / FadeDistance, 1.f);
+	return distance_share * m_load_share;
+}
+
+bool ParticleBudget::TryAdd()
+{
+	if(m_live_particles >= m_max_particles)
+	{
+		m_counters.m_dropped++;
+		return false;
+	}
+
+	m_live_particles++;
+	m_counters.m_emitted++;
+	return true;
+}
+
+void ParticleBudget::AddDropped(std::size_t count)
+{
+	m_counters.m_dropped += count;
+}
+
+std::size_t ParticleBudget::GetLiveCount() const
+{
+	return m_live_particles;
+}
+
+std::size_t ParticleBudget::GetMaxCount() const
+{
+	return m_max_particles;
+}
+
+const ParticleBudget::Counters& ParticleBudget::GetCounters() const
+{
+	return m_counters;
+}
+
+void ParticleBudget::ResetCounters()
+{
+	m_counters = Counters();
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/System/Vector2.hpp>
+
+#include <cstddef>
+
+//Owned by World and shared by its particle nodes, so that all of them together never hold more than
+//max_particles. Emission is thinned out away from the camera and as the live particles get close to the cap,
+//which keeps the particles next to the player the last ones to go when a salvo of missiles is in the air
+class ParticleBudget
+{
+public:
+	struct Counters
+	{
+		Counters();
+
+		std::size_t m_emitted;
+		std::size_t m_dropped;
+	};
+
+public:
+	explicit ParticleBudget(std::size_t max_particles);
+	//Called once per step before any particles are added, with the particles the nodes still hold
+	void BeginStep(std::size_t live_particles, const sf::FloatRect& view_bounds);
+
+	//Share of the particles emitted at position that should be added, 0 to 1
+	float GetShare(sf::Vector2f position) const;
+	//Whether one more particle fits under the cap, it is counted as emitted or dropped either way
+	bool TryAdd();
+	void AddDropped(std::size_t count);
+
+	std::size_t GetLiveCount() const;
+	std::size_t GetMaxCount() const;
+	//Since the last ResetCounters
+	const Counters& GetCounters() const;
+	void ResetCounters();
+
+private:
+	std::size_t m_max_particles;
+	std::size_t m_live_particles;
+	sf::FloatRect m_view_bounds;
+	float m_load_share;
+	Counters m_counters;
+};
@@ -0,0 +1,61 @@
+#ifdef PERFORMANCE_CHECKS
+
+#include <SFML/System/Clock.hpp>
+
+#include <algorithm>
+#include <iostream>
+
+#include "ParticleBudget.hpp"
+#include "ParticleNode.hpp"
+#include "PerformanceChecks.hpp"
+#include "RecordingRenderBackend.hpp"
+#include "RenderQueue.hpp"
+#include "ResourceHolder.hpp"
+
+namespace
+{
+	const std::size_t ParticleSteps = 600;
+	const std::size_t ParticlesPerStep = 500;
+	const sf::Time ParticleStep = sf::seconds(1.f / 60.f);
+}
+
+//Emits a steady stream of smoke, which lives longest, and times the update and the vertices of the drawing
+
+void MeasureParticles()
+{
+	TextureHolder textures;
+	textures.Load(Textures::kParticle, "Media/Textures/Particle.png");
+
+	sf::FloatRect view(0.f, 0.f, 1024.f, 768.f);
+	ParticleBudget budget(ParticleSteps * ParticlesPerStep);
+	ParticleNode node(ParticleType::kSmoke, textures, budget);
+	RenderQueue queue;
+	RecordingRenderBackend backend;
+	RenderQueue::Counters render_counters;
+	SceneNode::DrawCounters draw_counters;
+
+	std::size_t particles_processed = 0;
+	sf::Time time;
+	for (std::size_t step = 0; step < ParticleSteps; ++step)
+	{
+		sf::Clock clock;
+		budget.BeginStep(node.GetParticleCount(), view);
+		for (std::size_t i = 0; i < ParticlesPerStep; ++i)
+		{
+			node.AddParticle(sf::Vector2f(static_cast<float>(i * 2 % 1024), static_cast<float>(step % 768)));
+		}
+		node.UpdateParticles(ParticleStep);
+		node.UpdateDrawBounds();
+
+		backend.BeginFrame();
+		node.DrawVisible(queue, sf::RenderStates::Default, view, draw_counters);
+		queue.Flush(backend, render_counters);
+		time += clock.getElapsedTime();
+		particles_processed += node.GetParticleCount();
+	}
+
+	std::cout << "Particles: " << node.GetParticleCount() << " live at the end, "
+		<< particles_processed / std::max(time.asSeconds() * 1000.f, 0.001f) << " particles updated and drawn per ms" << std::endl;
+}
+
+#endif
@@ -1,35 +1,148 @@
 #include "ParticleNode.hpp"
 #include "DataTables.hpp"
+#include "ParticleBudget.hpp"
+#include "RenderQueue.hpp"
 #include "ResourceHolder.hpp"
 
-#include <SFML/Graphics/RenderTarget.hpp>
 #include <SFML/Graphics/Texture.hpp>
 
 #include <algorithm>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PARTICLE_NODE_SSE
+#include <emmintrin.h>
+#endif
+
 
 namespace
 {
 	const std::vector<ParticleData> Table = InitializeParticleData();
+
+	// Grows by doubling, so the capacity stays a power of two and indices wrap with a mask
+	const std::size_t InitialCapacity = 256;
+	// The clock is wound back by this much now and then so the float times keep their precision
+	const float ClockRebaseTime = 1024.f;
+	// Two triangles per particle
+	const std::size_t VerticesPerParticle = 6;
+
+	// Calls function(begin, end) for the one or two runs of the ring buffer that hold particles
+	template <typename Function>
+	void ForEachSpan(std::size_t first, std::size_t count, std::size_t capacity, Function function)
+	{
+		std::size_t first_end = std::min(first + count, capacity);
+		if (first_end > first)
+			function(first, first_end);
+		if (first + count > capacity)
+			function(0, first + count - capacity);
+	}
+
+	// alpha = 255 * remaining lifetime / lifetime, four particles at a time where SSE is available
+	void ComputeAlphas(const float* expiry_times, std::size_t count, float time, float scale, sf::Uint8* alphas)
+	{
+		std::size_t i = 0;
+#ifdef PARTICLE_NODE_SSE
+		const __m128 now = _mm_set1_ps(time);
+		const __m128 factor = _mm_set1_ps(scale);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 opaque = _mm_set1_ps(255.f);
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 remaining = _mm_sub_ps(_mm_loadu_ps(expiry_times + i), now);
+			__m128 alpha = _mm_min_ps(_mm_max_ps(_mm_mul_ps(remaining, factor), zero), opaque);
+			__m128i integers = _mm_cvttps_epi32(alpha);
+			__m128i words = _mm_packs_epi32(integers, integers);
+			int packed = _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+			const sf::Uint8* bytes = reinterpret_cast<const sf::Uint8*>(&packed);
+			std::copy(bytes, bytes + 4, alphas + i);
+		}
+#endif
+		for (; i < count; ++i)
+		{
+			float alpha = std::min(std::max((expiry_times[i] - time) * scale, 0.f), 255.f);
+			alphas[i] = static_cast<sf::Uint8>(alpha);
+		}
+	}
+
+	// Widens [min, max] to take in every value
+	void ExtendRange(const float* values, std::size_t count, float& min, float& max)
+	{
+		std::size_t i = 0;
+#ifdef PARTICLE_NODE_SSE
+		if (count >= 4)
+		{
+			__m128 lowest = _mm_set1_ps(min);
+			__m128 highest = _mm_set1_ps(max);
+			for (; i + 4 <= count; i += 4)
+			{
+				__m128 block = _mm_loadu_ps(values + i);
+				lowest = _mm_min_ps(lowest, block);
+				highest = _mm_max_ps(highest, block);
+			}
+
+			float lows[4];
+			float highs[4];
+			_mm_storeu_ps(lows, lowest);
+			_mm_storeu_ps(highs, highest);
+			min = *std::min_element(lows, lows + 4);
+			max = *std::max_element(highs, highs + 4);
+		}
+#endif
+		for (; i < count; ++i)
+		{
+			min = std::min(min, values[i]);
+			max = std::max(max, values[i]);
+		}
+	}
 }
 
-ParticleNode::ParticleNode(ParticleType type, const TextureHolder& textures)
+ParticleNode::ParticleNode(ParticleType type, const TextureHolder& textures, ParticleBudget& budget)
 	: SceneNode()
+	, m_positions_x(InitialCapacity)
+	, m_positions_y(InitialCapacity)
+	, m_expiry_times(InitialCapacity)
+	, m_first(0)
+	, m_count(0)
+	, m_time(0.f)
 	, m_texture(textures.Get(Textures::kParticle))
+	, m_budget(budget)
 	, m_type(type)
-	, m_vertex_array(sf::TriangleStrip)
+	, m_color(Table[static_cast<int>(type)].m_color)
+	, m_lifetime(Table[static_cast<int>(type)].m_lifetime.asSeconds())
+	, m_density(1.f)
+	, m_density_accumulator(0.f)
 	, m_needs_vertex_update(true)
 {
 }
 
 void ParticleNode::AddParticle(sf::Vector2f position)
 {
-	Particle particle;
-	particle.m_position = position;
-	particle.m_colour = Table[static_cast<int>(m_type)].m_color;
-	particle.m_lifetime = Table[static_cast<int>(m_type)].m_lifetime;
+	// The particles left out are spread evenly over the ones emitted
+	m_density_accumulator += m_density * m_budget.GetShare(position);
+	if (m_density_accumulator < 1.f)
+	{
+		m_budget.AddDropped(1);
+		return;
+	}
+	m_density_accumulator -= 1.f;
+
+	if (!m_budget.TryAdd())
+		return;
+
+	if (m_count == m_expiry_times.size())
+		Grow();
+
+	std::size_t index = (m_first + m_count) & (m_expiry_times.size() - 1);
+	m_positions_x[index] = position.x;
+	m_positions_y[index] = position.y;
+	m_expiry_times[index] = m_time + m_lifetime;
+	++m_count;
+
+	m_needs_vertex_update = true;
+}
 
-	m_particles.emplace_back(particle);
+void ParticleNode::SetDensity(float density)
+{
+	m_density = density;
 }
 
 ParticleType ParticleNode::GetParticleType() const
@@ -37,27 +150,60 @@ ParticleType ParticleNode::GetParticleType() const
 	return m_type;
 }
 
+std::size_t ParticleNode::GetParticleCount() const
+{
+	return m_count;
+}
+
 unsigned int ParticleNode::GetCategory() const
 {
 	return Category::kParticleSystem;
 }
 
-void ParticleNode::UpdateCurrent(sf::Time dt, CommandQueue&)
+void ParticleNode::UpdateParticles(sf::Time dt)
 {
+	m_time += dt.asSeconds();
+
 	// Remove expired particles at beginning
-	while (!m_particles.empty() && m_particles.front().m_lifetime <= sf::Time::Zero)
-		m_particles.pop_front();
+	std::size_t mask = m_expiry_times.size() - 1;
+	while (m_count > 0 && m_expiry_times[m_first] <= m_time)
+	{
+		m_first = (m_first + 1) & mask;
+		--m_count;
+	}
 
-	// Decrease lifetime of existing particles
-	for (Particle& particle : m_particles)
+	if (m_time >= ClockRebaseTime)
 	{
-		particle.m_lifetime -= dt;
+		ForEachSpan(m_first, m_count, m_expiry_times.size(), [this](std::size_t begin, std::size_t end)
+		{
+			for (std::size_t i = begin; i < end; ++i)
+				m_expiry_times[i] -= ClockRebaseTime;
+		});
+		m_time -= ClockRebaseTime;
 	}
 
 	m_needs_vertex_update = true;
 }
 
-void ParticleNode::DrawCurrent(sf::RenderTarget& target, sf::RenderStates states) const
+sf::FloatRect ParticleNode::GetDrawBounds() const
+{
+	if (m_count == 0)
+		return sf::FloatRect();
+
+	// Particles are stored in world coordinates, each one is a texture sized quad around its position
+	sf::Vector2f min(m_positions_x[m_first], m_positions_y[m_first]);
+	sf::Vector2f max = min;
+	ForEachSpan(m_first, m_count, m_expiry_times.size(), [&](std::size_t begin, std::size_t end)
+	{
+		ExtendRange(&m_positions_x[begin], end - begin, min.x, max.x);
+		ExtendRange(&m_positions_y[begin], end - begin, min.y, max.y);
+	});
+
+	sf::Vector2f half = sf::Vector2f(m_texture.getSize()) / 2.f;
+	return sf::FloatRect(min - half, max - min + 2.f * half);
+}
+
+void ParticleNode::DrawCurrent(RenderQueue& queue, sf::RenderStates states) const
 {
 	if (m_needs_vertex_update)
 	{
@@ -69,17 +215,30 @@ void ParticleNode::DrawCurrent(sf::RenderTarget& target, sf::RenderStates states
 	states.texture = &m_texture;
 
 	// Draw vertices
-	target.draw(m_vertex_array, states);
+	queue.AddTriangles(m_vertices.data(), m_count * VerticesPerParticle, states);
 }
 
-void ParticleNode::AddVertex(float worldX, float worldY, float texCoordX, float texCoordY, const sf::Color& color) const
+void ParticleNode::Grow()
 {
-	sf::Vertex vertex;
-	vertex.position = sf::Vector2f(worldX, worldY);
-	vertex.texCoords = sf::Vector2f(texCoordX, texCoordY);
-	vertex.color = color;
+	// Unwrap the particles to the start of the bigger buffers
+	std::size_t capacity = m_expiry_times.size() * 2;
+	std::vector<float> positions_x(capacity);
+	std::vector<float> positions_y(capacity);
+	std::vector<float> expiry_times(capacity);
+
+	std::size_t copied = 0;
+	ForEachSpan(m_first, m_count, m_expiry_times.size(), [&](std::size_t begin, std::size_t end)
+	{
+		std::copy(m_positions_x.begin() + begin, m_positions_x.begin() + end, positions_x.begin() + copied);
+		std::copy(m_positions_y.begin() + begin, m_positions_y.begin() + end, positions_y.begin() + copied);
+		std::copy(m_expiry_times.begin() + begin, m_expiry_times.begin() + end, expiry_times.begin() + copied);
+		copied += end - begin;
+	});
 
-	m_vertex_array.append(vertex);
+	m_positions_x.swap(positions_x);
+	m_positions_y.swap(positions_y);
+	m_expiry_times.swap(expiry_times);
+	m_first = 0;
 }
 
 void ParticleNode::ComputeVertices() const
@@ -87,19 +246,38 @@ void ParticleNode::ComputeVertices() const
 	sf::Vector2f size(m_texture.getSize());
 	sf::Vector2f half = size / 2.f;
 
-	// Refill vertex array
-	m_vertex_array.clear();
-	for(const Particle & particle :  m_particles)
+	m_alphas.resize(m_count);
+	m_vertices.resize(m_count * VerticesPerParticle);
+
+	std::size_t particle = 0;
+	ForEachSpan(m_first, m_count, m_expiry_times.size(), [&](std::size_t begin, std::size_t end)
 	{
-		sf::Vector2f pos = particle.m_position;
-		sf::Color color = particle.m_colour;
+		ComputeAlphas(&m_expiry_times[begin], end - begin, m_time, 255.f / m_lifetime, &m_alphas[particle]);
+		particle += end - begin;
+	});
 
-		float ratio = particle.m_lifetime.asSeconds() / Table[static_cast<int>(m_type)].m_lifetime.asSeconds();
-		color.a = static_cast<sf::Uint8>(255 * std::max(ratio, 0.f));
+	// Written straight into place, the buffer only grows when there are more particles than ever before
+	sf::Vertex* vertex = m_vertices.data();
+	particle = 0;
+	ForEachSpan(m_first, m_count, m_expiry_times.size(), [&](std::size_t begin, std::size_t end)
+	{
+		for (std::size_t i = begin; i < end; ++i)
+		{
+			sf::Color color = m_color;
+			color.a = m_alphas[particle++];
 
-		AddVertex(pos.x - half.x, pos.y - half.y, 0.f, 0.f, color);
-		AddVertex(pos.x + half.x, pos.y - half.y, size.x, 0.f, color);
-		AddVertex(pos.x + half.x, pos.y + half.y, size.x, size.y, color);
-		AddVertex(pos.x - half.x, pos.y + half.y, 0.f, size.y, color);
-	}
-}
\ No newline at end of file
+			float left = m_positions_x[i] - half.x;
+			float top = m_positions_y[i] - half.y;
+			float right = m_positions_x[i] + half.x;
+			float bottom = m_positions_y[i] + half.y;
+
+			vertex[0] = sf::Vertex(sf::Vector2f(left, top), color, sf::Vector2f(0.f, 0.f));
+			vertex[1] = sf::Vertex(sf::Vector2f(right, top), color, sf::Vector2f(size.x, 0.f));
+			vertex[2] = sf::Vertex(sf::Vector2f(left, bottom), color, sf::Vector2f(0.f, size.y));
+			vertex[3] = vertex[2];
+			vertex[4] = vertex[1];
+			vertex[5] = sf::Vertex(sf::Vector2f(right, bottom), color, sf::Vector2f(size.x, size.y));
+			vertex += VerticesPerParticle;
+		}
+	});
+}
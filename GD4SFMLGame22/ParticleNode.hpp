@@ -1,36 +1,61 @@
 #pragma once
 #include <SFML/Graphics/Color.hpp>
-#include <SFML/Graphics/VertexArray.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+
+#include <vector>
 
-#include "Particle.hpp"
 #include "SceneNode.hpp"
 #include "ResourceIdentifiers.hpp"
 #include "ParticleType.hpp"
 
+class ParticleBudget;
+
 class ParticleNode : public SceneNode
 {
 public:
-	ParticleNode(ParticleType type, const TextureHolder& textures);
+	//Every particle added is taken out of budget, which may also turn it away
+	ParticleNode(ParticleType type, const TextureHolder& textures, ParticleBudget& budget);
 
 	void AddParticle(sf::Vector2f position);
+	// Only this share of the particles added is kept, spread evenly over them
+	void SetDensity(float density);
 	ParticleType GetParticleType() const;
+	std::size_t GetParticleCount() const;
 	virtual unsigned int GetCategory() const;
+	//Called by World next to the collision tests instead of during the scene graph update, it only touches
+	//this node's particles
+	void UpdateParticles(sf::Time dt);
+	virtual sf::FloatRect GetDrawBounds() const override;
 
 
 private:
-	virtual void UpdateCurrent(sf::Time dt, CommandQueue& commands);
-	virtual void DrawCurrent(sf::RenderTarget& target, sf::RenderStates states) const;
+	virtual void DrawCurrent(RenderQueue& queue, sf::RenderStates states) const;
 
-	void AddVertex(float worldX, float worldY, float texCoordX, float texCoordY, const sf::Color& color) const;
+	void Grow();
 	void ComputeVertices() const;
 
 
 private:
-	std::deque<Particle> m_particles;
+	// A ring buffer with one array per field, oldest particle first. All particles of a node live as long, so
+	// they expire in the order they were added. Each one keeps the time it expires on the node's clock, which
+	// saves counting every lifetime down
+	std::vector<float> m_positions_x;
+	std::vector<float> m_positions_y;
+	std::vector<float> m_expiry_times;
+	std::size_t m_first;
+	std::size_t m_count;
+	float m_time;
+
 	const sf::Texture& m_texture;
+	ParticleBudget& m_budget;
 	ParticleType m_type;
+	sf::Color m_color;
+	float m_lifetime;
+	float m_density;
+	float m_density_accumulator;
 
-	mutable sf::VertexArray	m_vertex_array;
+	mutable std::vector<sf::Vertex> m_vertices;
+	mutable std::vector<sf::Uint8> m_alphas;
 	mutable bool m_needs_vertex_update;
 };
 
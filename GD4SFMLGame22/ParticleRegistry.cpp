@@ -0,0 +1,30 @@
+#include "ParticleRegistry.hpp"
+#include "ParticleNode.hpp"
+
+#include <algorithm>
+
+ParticleRegistry::ParticleRegistry()
+	: m_by_type()
+{
+}
+
+void ParticleRegistry::Register(ParticleNode& node)
+{
+	ParticleNode*& slot = m_by_type[static_cast<int>(node.GetParticleType())];
+	if(slot != nullptr)
+	{
+		m_nodes.erase(std::remove(m_nodes.begin(), m_nodes.end(), slot), m_nodes.end());
+	}
+	slot = &node;
+	m_nodes.emplace_back(&node);
+}
+
+ParticleNode* ParticleRegistry::Find(ParticleType type) const
+{
+	return m_by_type[static_cast<int>(type)];
+}
+
+const std::vector<ParticleNode*>& ParticleRegistry::GetNodes() const
+{
+	return m_nodes;
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include "ParticleType.hpp"
+
+#include <array>
+#include <vector>
+
+class ParticleNode;
+
+//Owned by World. Its particle nodes are registered here by type when the scene is built, and emitters look
+//up the node they feed when they are constructed instead of searching the scene graph for it
+class ParticleRegistry
+{
+public:
+	ParticleRegistry();
+
+	//One node per type, a second one of the same type replaces the first
+	void Register(ParticleNode& node);
+	//nullptr when no node of type was registered
+	ParticleNode* Find(ParticleType type) const;
+	const std::vector<ParticleNode*>& GetNodes() const;
+
+private:
+	std::array<ParticleNode*, static_cast<int>(ParticleType::kParticleCount)> m_by_type;
+	std::vector<ParticleNode*> m_nodes;
+};
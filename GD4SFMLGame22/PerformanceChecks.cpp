@@ -0,0 +1,61 @@
+//Built instead of the game when PERFORMANCE_CHECKS is defined (C/C++ > Preprocessor in the project settings).
+//Run from the project directory so Media/ is found, with nothing else listening on the server port. It prints
+//the numbers behind the networking, threading and particle changes so they can be measured again on any
+//machine, and returns 1 if a check finds a regression
+#ifdef PERFORMANCE_CHECKS
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+#include "PerformanceChecks.hpp"
+
+namespace
+{
+	std::atomic<std::size_t> g_allocations(0);
+}
+
+void* operator new(std::size_t size)
+{
+	g_allocations++;
+	if (void* memory = std::malloc(size ? size : 1))
+	{
+		return memory;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+std::size_t GetAllocationCount()
+{
+	return g_allocations;
+}
+
+int main()
+{
+	try
+	{
+		CompareCodecs();
+		bool passed = CheckServerTickAllocations();
+		MeasureParticles();
+		MeasureServerTickScaling();
+		return passed ? 0 : 1;
+	}
+	catch (std::exception& e)
+	{
+		std::cout << "\nEXCEPTION: " << e.what() << std::endl;
+		return 1;
+	}
+}
+
+#endif
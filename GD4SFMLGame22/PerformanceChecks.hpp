@@ -0,0 +1,18 @@
+#pragma once
+#include <cstddef>
+
+//The checks PerformanceChecks.cpp runs instead of the game when PERFORMANCE_CHECKS is defined. Each prints
+//what it measured, the ones that return bool return false when they find a regression
+
+//Allocations made on every thread since the program started
+std::size_t GetAllocationCount();
+
+//CodecChecks.cpp
+void CompareCodecs();
+
+//ParticleChecks.cpp
+void MeasureParticles();
+
+//ServerChecks.cpp
+bool CheckServerTickAllocations();
+void MeasureServerTickScaling();
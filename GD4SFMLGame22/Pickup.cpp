@@ -1,8 +1,7 @@
 #include "Pickup.hpp"
 
-#include <SFML/Graphics/RenderTarget.hpp>
-
 #include "DataTables.hpp"
+#include "RenderQueue.hpp"
 #include "ResourceHolder.hpp"
 #include "Utility.hpp"
 
@@ -34,7 +33,7 @@ void Pickup::Apply(Aircraft& player) const
 	Table[static_cast<int>(m_type)].m_action(player);
 }
 
-void Pickup::DrawCurrent(sf::RenderTarget& target, sf::RenderStates states) const
+void Pickup::DrawCurrent(RenderQueue& queue, sf::RenderStates states) const
 {
-	target.draw(m_sprite, states);
+	queue.AddSprite(m_sprite, states);
 }
@@ -14,7 +14,7 @@ public:
 	virtual unsigned int GetCategory() const override;
 	virtual sf::FloatRect GetBoundingRect() const;
 	void Apply(Aircraft& player) const;
-	virtual void DrawCurrent(sf::RenderTarget&, sf::RenderStates states) const override;
+	virtual void DrawCurrent(RenderQueue& queue, sf::RenderStates states) const override;
 
 private:
 	PickupType m_type;
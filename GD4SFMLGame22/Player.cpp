@@ -1,9 +1,13 @@
 #include "Player.hpp"
 #include "Aircraft.hpp"
 #include "NetworkProtocol.hpp"
+#include "WireFormat.hpp"
 #include <SFML/Network/Packet.hpp>
 #include <algorithm>
 
+//Every action needs a bit in the per-tick input byte
+static_assert(static_cast<int>(PlayerAction::kActionCount) <= 8, "PlayerAction no longer fits the network input byte");
+
 struct AircraftMover
 {
 	AircraftMover(float vx, float vy, int identifier)
@@ -64,7 +68,11 @@ Player::Player(sf::TcpSocket* socket, sf::Int32 identifier, const KeyBinding* bi
 	, m_current_mission_status(MissionStatus::kMissionRunning)
 	, m_identifier(identifier)
 	, m_socket(socket)
+	, m_pending_events(0)
+	, m_input_tick(0)
 {
+	m_input_history.fill(0);
+
 	// Set initial action bindings
 	InitialiseActions();
 
@@ -81,41 +89,22 @@ void Player::HandleEvent(const sf::Event& event, CommandQueue& commands)
 	if (event.type == sf::Event::KeyPressed)
 	{
 		PlayerAction action;
-		if (m_key_binding && m_key_binding->CheckAction(event.key.code, action) && !IsRealtimeAction(action))
+		if (m_key_binding && m_key_binding->CheckAction(event.key.code, action))
 		{
-			// Network connected -> send event over network
+			// Network connected -> remember the press for the next input sample. Realtime actions are latched too,
+			// a key pressed and released between two samples still counts as held for one tick
 			if (m_socket)
 			{
-				sf::Packet packet;
-				packet << static_cast<sf::Int32>(Client::PacketType::PlayerEvent);
-				packet << m_identifier;
-				packet << static_cast<sf::Int32>(action);
-				m_socket->send(packet);
+				m_pending_events |= static_cast<sf::Uint8>(1 << static_cast<int>(action));
 			}
 
 			// Network disconnected -> local event
-			else
+			else if (!IsRealtimeAction(action))
 			{
 				commands.Push(m_action_binding[action]);
 			}
 		}
 	}
-
-	// Realtime change (network connected)
-	if ((event.type == sf::Event::KeyPressed || event.type == sf::Event::KeyReleased) && m_socket)
-	{
-		PlayerAction action;
-		if (m_key_binding && m_key_binding->CheckAction(event.key.code, action) && IsRealtimeAction(action))
-		{
-			// Send realtime change over network
-			sf::Packet packet;
-			packet << static_cast<sf::Int32>(Client::PacketType::PlayerRealtimeChange);
-			packet << m_identifier;
-			packet << static_cast<sf::Int32>(action);
-			packet << (event.type == sf::Event::KeyPressed);
-			m_socket->send(packet);
-		}
-	}
 }
 
 bool Player::IsLocal() const
@@ -126,14 +115,35 @@ bool Player::IsLocal() const
 
 void Player::DisableAllRealtimeActions()
 {
-	for(auto & action : m_action_proxies)
+	//Held actions are released by sampling without input, only presses that were not sent yet need dropping
+	m_pending_events = 0;
+}
+
+void Player::SampleInput(bool accept_input)
+{
+	sf::Uint8 input = 0;
+	if (accept_input && m_key_binding)
+	{
+		for (PlayerAction action : m_key_binding->GetRealtimeActions())
+		{
+			input |= static_cast<sf::Uint8>(1 << static_cast<int>(action));
+		}
+		input |= m_pending_events;
+	}
+	m_pending_events = 0;
+
+	m_input_history[m_input_tick % INPUT_HISTORY_SIZE] = input;
+	m_input_tick++;
+}
+
+void Player::WriteInput(sf::Packet& packet) const
+{
+	//Newest tick first. Repeating the older ticks means a lost update does not lose a key press
+	sf::Uint32 count = std::min<sf::Uint32>(m_input_tick, INPUT_HISTORY_SIZE);
+	packet << Wire::VarInt(m_input_tick - 1) << Wire::VarInt(count);
+	for (sf::Uint32 i = 1; i <= count; ++i)
 	{
-		sf::Packet packet;
-		packet << static_cast<sf::Int32>(Client::PacketType::PlayerRealtimeChange);
-		packet << m_identifier;
-		packet << static_cast<sf::Int32>(action.first);
-		packet << false;
-		m_socket->send(packet);
+		packet << m_input_history[(m_input_tick - i) % INPUT_HISTORY_SIZE];
 	}
 }
 
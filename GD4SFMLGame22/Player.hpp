@@ -1,12 +1,15 @@
 #pragma once
 #include "Command.hpp"
 #include "KeyBinding.hpp"
+#include <SFML/Network/Packet.hpp>
 #include <SFML/Network/TcpSocket.hpp>
 #include <SFML/Window/Event.hpp>
+#include <array>
 #include <map>
 #include "CommandQueue.hpp"
 #include "MissionStatus.hpp"
 #include "PlayerAction.hpp"
+#include "NetworkProtocol.hpp"
 
 class Player
 {
@@ -27,6 +30,12 @@ public:
 	void DisableAllRealtimeActions();
 	bool IsLocal() const;
 
+	//A networked local player records its input once per tick as a bitmask of PlayerActions - held
+	//realtime actions plus every action pressed since the last sample, so a tap shorter than a tick is not
+	//lost. The last few ticks are written into every position update
+	void SampleInput(bool accept_input);
+	void WriteInput(sf::Packet& packet) const;
+
 private:
 	void InitialiseActions();
 
@@ -37,5 +46,9 @@ private:
 	MissionStatus m_current_mission_status;
 	int m_identifier;
 	sf::TcpSocket* m_socket;
+
+	sf::Uint8 m_pending_events;
+	sf::Uint32 m_input_tick;
+	std::array<sf::Uint8, INPUT_HISTORY_SIZE> m_input_history;
 };
 
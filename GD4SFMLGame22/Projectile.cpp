@@ -1,10 +1,10 @@
 #include "Projectile.hpp"
 
 #include <valarray>
-#include <SFML/Graphics/RenderTarget.hpp>
 
 #include "DataTables.hpp"
 #include "EmitterNode.hpp"
+#include "RenderQueue.hpp"
 #include "ResourceHolder.hpp"
 #include "Utility.hpp"
 
@@ -13,7 +13,7 @@ namespace
 	const std::vector<ProjectileData> Table = InitializeProjectileData();
 }
 
-Projectile::Projectile(ProjectileType type, const TextureHolder& textures)
+Projectile::Projectile(ProjectileType type, const TextureHolder& textures, const ParticleRegistry& particles)
 : Entity(1)
 , m_type(type)
 , m_sprite(textures.Get(Table[static_cast<int>(type)].m_texture), Table[static_cast<int>(type)].m_texture_rect)
@@ -23,11 +23,11 @@ Projectile::Projectile(ProjectileType type, const TextureHolder& textures)
 	// Add particle system for missiles
 	if (IsGuided())
 	{
-		std::unique_ptr<EmitterNode> smoke(new EmitterNode(ParticleType::kSmoke));
+		std::unique_ptr<EmitterNode> smoke(new EmitterNode(ParticleType::kSmoke, particles));
 		smoke->setPosition(0.f, GetBoundingRect().height / 2.f);
 		AttachChild(std::move(smoke));
 
-		std::unique_ptr<EmitterNode> propellant(new EmitterNode(ParticleType::kPropellant));
+		std::unique_ptr<EmitterNode> propellant(new EmitterNode(ParticleType::kPropellant, particles));
 		propellant->setPosition(0.f, GetBoundingRect().height / 2.f);
 		AttachChild(std::move(propellant));
 
@@ -84,7 +84,7 @@ void Projectile::UpdateCurrent(sf::Time dt, CommandQueue& commands)
 	Entity::UpdateCurrent(dt, commands);
 }
 
-void Projectile::DrawCurrent(sf::RenderTarget& target, sf::RenderStates states) const
+void Projectile::DrawCurrent(RenderQueue& queue, sf::RenderStates states) const
 {
-	target.draw(m_sprite, states);
+	queue.AddSprite(m_sprite, states);
 }
@@ -5,11 +5,14 @@
 #include "ProjectileType.hpp"
 #include "ResourceIdentifiers.hpp"
 
+class ParticleRegistry;
+
 
 class Projectile : public Entity
 {
 public:
-	Projectile(ProjectileType type, const TextureHolder& textures);
+	//Missiles leave trails in the particle nodes registered in particles
+	Projectile(ProjectileType type, const TextureHolder& textures, const ParticleRegistry& particles);
 	void GuideTowards(sf::Vector2f position);
 	bool IsGuided() const;
 
@@ -20,7 +23,7 @@ public:
 
 private:
 	virtual void UpdateCurrent(sf::Time dt, CommandQueue& commands) override;
-	virtual void DrawCurrent(sf::RenderTarget&, sf::RenderStates states) const override;
+	virtual void DrawCurrent(RenderQueue& queue, sf::RenderStates states) const override;
 
 private:
 	ProjectileType m_type;
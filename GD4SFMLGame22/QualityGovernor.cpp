@@ -0,0 +1,120 @@
+#include "QualityGovernor.hpp"
+
+#include <iostream>
+
+namespace
+{
+	struct Tier
+	{
+		const char* m_name;
+		QualitySettings m_settings;
+	};
+
+	const Tier Tiers[] =
+	{
+		{ "high", { 1, 2, 1.f, 1.f } },
+		{ "medium", { 1, 1, 0.75f, 1.f } },
+		{ "low", { 2, 1, 0.5f, 0.75f } },
+		{ "lowest", { 0, 1, 0.25f, 0.5f } }
+	};
+	const std::size_t TierCount = sizeof(Tiers) / sizeof(Tiers[0]);
+
+	//Frame times are averaged over a window this long before anything is decided
+	const sf::Time WindowLength = sf::seconds(1.f);
+	//Slower than the target for this many windows in a row drops a tier
+	const std::size_t SlowWindowsToDrop = 2;
+	//Faster than this share of the target for this many windows in a row raises one
+	const float RaiseHeadroom = 0.6f;
+	const std::size_t FastWindowsToRaise = 5;
+}
+
+QualityGovernor::QualityGovernor(sf::Time target_frame_time, bool cpu_bloom)
+	: m_target_frame_time(target_frame_time)
+	, m_tier(0)
+	, m_window_frames(0)
+	, m_slow_windows(0)
+	, m_fast_windows(0)
+	, m_cpu_bloom(cpu_bloom)
+{
+	if(m_target_frame_time != sf::Time::Zero)
+	{
+		std::cout << "Quality targets " << m_target_frame_time.asMicroseconds() << "us per frame, starting at tier " << Tiers[m_tier].m_name << std::endl;
+	}
+}
+
+void QualityGovernor::AddFrameTime(sf::Time frame_time)
+{
+	if(m_target_frame_time == sf::Time::Zero)
+	{
+		return;
+	}
+
+	m_window_time += frame_time;
+	m_window_frames++;
+	if(m_window_time >= WindowLength)
+	{
+		Evaluate(m_window_time / static_cast<float>(m_window_frames));
+		m_window_time = sf::Time::Zero;
+		m_window_frames = 0;
+	}
+}
+
+const QualitySettings& QualityGovernor::GetSettings() const
+{
+	return Tiers[m_tier].m_settings;
+}
+
+std::size_t QualityGovernor::GetTier() const
+{
+	return m_tier;
+}
+
+bool QualityGovernor::UsesCpuBloom() const
+{
+	return m_cpu_bloom;
+}
+
+void QualityGovernor::Evaluate(sf::Time average_frame_time)
+{
+	if(average_frame_time > m_target_frame_time)
+	{
+		m_fast_windows = 0;
+		if(++m_slow_windows >= SlowWindowsToDrop && m_tier + 1 < TierCount)
+		{
+			SetTier(m_tier + 1);
+		}
+	}
+	else if(average_frame_time < m_target_frame_time * RaiseHeadroom)
+	{
+		m_slow_windows = 0;
+		if(++m_fast_windows >= FastWindowsToRaise && m_tier > 0)
+		{
+			SetTier(m_tier - 1);
+		}
+	}
+	else
+	{
+		m_slow_windows = 0;
+		m_fast_windows = 0;
+	}
+}
+
+void QualityGovernor::SetTier(std::size_t tier)
+{
+	m_tier = tier;
+	m_slow_windows = 0;
+	m_fast_windows = 0;
+
+	const QualitySettings& settings = Tiers[m_tier].m_settings;
+	std::cout << "Quality tier " << Tiers[m_tier].m_name << ": ";
+	if(settings.m_bloom_downsamples > 0)
+	{
+		std::cout << "bloom at 1/" << (1u << settings.m_bloom_downsamples) << ", blur " << settings.m_blur_iterations << "x, ";
+	}
+	else
+	{
+		std::cout << "no bloom, ";
+	}
+	std::cout << settings.m_particle_density * 100.f << "% particles, "
+		<< settings.m_render_scale * 100.f << "% render scale" << std::endl;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <SFML/System/Time.hpp>
+
+#include <cstddef>
+
+//What a quality tier draws with
+struct QualitySettings
+{
+	//How many times the scene is halved before the first blur octave, the second octave is half of that again.
+	//0 turns bloom off
+	std::size_t m_bloom_downsamples;
+	//Vertical and horizontal blur passes per octave
+	std::size_t m_blur_iterations;
+	//Share of the particles that are emitted, 0 to 1
+	float m_particle_density;
+	//Size of the scene texture relative to the window, it is stretched to fill the window
+	float m_render_scale;
+};
+
+//Owned by Application and shared through State::Context. Watches the frame times and steps the quality down
+//when frames take longer than the target and back up once there is room to spare again. Dropping a tier
+//takes a couple of slow seconds and raising one several fast ones, so the quality does not flip back and
+//forth around the target
+class QualityGovernor
+{
+public:
+	//A target of zero keeps the highest tier whatever the frame times. Without shaders bloom is left out unless
+	//cpu_bloom asks for it to be done on the CPU, which costs tens of milliseconds a frame
+	QualityGovernor(sf::Time target_frame_time, bool cpu_bloom);
+	void AddFrameTime(sf::Time frame_time);
+
+	const QualitySettings& GetSettings() const;
+	//0 is the highest quality
+	std::size_t GetTier() const;
+	bool UsesCpuBloom() const;
+
+private:
+	void Evaluate(sf::Time average_frame_time);
+	void SetTier(std::size_t tier);
+
+private:
+	sf::Time m_target_frame_time;
+	std::size_t m_tier;
+	sf::Time m_window_time;
+	std::size_t m_window_frames;
+	std::size_t m_slow_windows;
+	std::size_t m_fast_windows;
+	bool m_cpu_bloom;
+};
+
@@ -0,0 +1,139 @@
+#include "RecordingRenderBackend.hpp"
+
+#include <algorithm>
+
+namespace
+{
+	const char* PrimitiveNames[] = { "points", "lines", "line_strip", "triangles", "triangle_strip", "triangle_fan", "quads" };
+
+	const char* BlendModeName(const sf::BlendMode& mode)
+	{
+		if(mode == sf::BlendAlpha)
+		{
+			return "alpha";
+		}
+		if(mode == sf::BlendAdd)
+		{
+			return "add";
+		}
+		if(mode == sf::BlendMultiply)
+		{
+			return "multiply";
+		}
+		if(mode == sf::BlendNone)
+		{
+			return "none";
+		}
+		return "custom";
+	}
+}
+
+RecordingRenderBackend::FrameStats::FrameStats() : m_draw_calls(0), m_vertices(0), m_texture_binds(0), m_state_changes(0)
+{
+}
+
+void RecordingRenderBackend::FrameStats::Add(const FrameStats& other)
+{
+	m_draw_calls += other.m_draw_calls;
+	m_vertices += other.m_vertices;
+	m_texture_binds += other.m_texture_binds;
+	m_state_changes += other.m_state_changes;
+}
+
+RecordingRenderBackend::RecordingRenderBackend(RenderBackend* output) : m_output(output)
+{
+}
+
+void RecordingRenderBackend::SetOutput(RenderBackend* output)
+{
+	m_output = output;
+}
+
+void RecordingRenderBackend::DrawVertices(const sf::Vertex* vertices, std::size_t count, sf::PrimitiveType type, const sf::RenderStates& states)
+{
+	Record(false, count, type, states);
+	if(m_output)
+	{
+		m_output->DrawVertices(vertices, count, type, states);
+	}
+}
+
+void RecordingRenderBackend::DrawDrawable(const sf::Drawable& drawable, const sf::RenderStates& states)
+{
+	Record(true, 0, sf::Triangles, states);
+	if(m_output)
+	{
+		m_output->DrawDrawable(drawable, states);
+	}
+}
+
+void RecordingRenderBackend::BeginFrame()
+{
+	m_commands.clear();
+	m_stats = FrameStats();
+}
+
+const std::vector<RecordingRenderBackend::Command>& RecordingRenderBackend::GetCommands() const
+{
+	return m_commands;
+}
+
+const RecordingRenderBackend::FrameStats& RecordingRenderBackend::GetFrameStats() const
+{
+	return m_stats;
+}
+
+void RecordingRenderBackend::WriteFrame(std::ostream& out)
+{
+	for(const Command& command : m_commands)
+	{
+		if(command.m_drawable)
+		{
+			out << "drawable";
+		}
+		else
+		{
+			out << PrimitiveNames[command.m_primitive] << " " << command.m_vertex_count;
+		}
+		out << " texture " << GetIdentifier(m_seen_textures, command.m_texture)
+			<< " shader " << GetIdentifier(m_seen_shaders, command.m_shader)
+			<< " blend " << BlendModeName(command.m_blend_mode) << "\n";
+	}
+	out << "calls " << m_stats.m_draw_calls << " vertices " << m_stats.m_vertices << " texture_binds " << m_stats.m_texture_binds
+		<< " state_changes " << m_stats.m_state_changes << std::endl;
+}
+
+void RecordingRenderBackend::Record(bool drawable, std::size_t count, sf::PrimitiveType type, const sf::RenderStates& states)
+{
+	//The first call of a frame always binds and sets up its states
+	if(m_commands.empty() || m_commands.back().m_texture != states.texture)
+	{
+		m_stats.m_texture_binds++;
+	}
+	if(m_commands.empty() || m_commands.back().m_shader != states.shader || m_commands.back().m_blend_mode != states.blendMode)
+	{
+		m_stats.m_state_changes++;
+	}
+
+	Command command = { drawable, type, count, states.texture, states.shader, states.blendMode };
+	m_commands.push_back(command);
+	m_stats.m_draw_calls++;
+	m_stats.m_vertices += count;
+}
+
+std::size_t RecordingRenderBackend::GetIdentifier(std::vector<const void*>& seen, const void* pointer)
+{
+	//0 is nothing bound
+	if(!pointer)
+	{
+		return 0;
+	}
+
+	auto found = std::find(seen.begin(), seen.end(), pointer);
+	if(found == seen.end())
+	{
+		seen.push_back(pointer);
+		return seen.size();
+	}
+	return found - seen.begin() + 1;
+}
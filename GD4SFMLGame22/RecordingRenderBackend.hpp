@@ -0,0 +1,69 @@
+#pragma once
+#include "RenderBackend.hpp"
+
+#include <SFML/Graphics/BlendMode.hpp>
+
+#include <ostream>
+#include <vector>
+
+namespace sf
+{
+	class Shader;
+	class Texture;
+}
+
+//Keeps a list of the draw calls of a frame and what they would cost, passing them on to another backend if
+//there is one. Without one nothing touches OpenGL
+class RecordingRenderBackend : public RenderBackend
+{
+public:
+	struct Command
+	{
+		//Drawables are drawn by SFML, their vertices are not known here
+		bool m_drawable;
+		sf::PrimitiveType m_primitive;
+		std::size_t m_vertex_count;
+		const sf::Texture* m_texture;
+		const sf::Shader* m_shader;
+		sf::BlendMode m_blend_mode;
+	};
+
+	//A texture bind is a draw call on a different texture than the one before it, a state change is one with
+	//a different shader or blend mode
+	struct FrameStats
+	{
+		FrameStats();
+		void Add(const FrameStats& other);
+		std::size_t m_draw_calls;
+		std::size_t m_vertices;
+		std::size_t m_texture_binds;
+		std::size_t m_state_changes;
+	};
+
+public:
+	explicit RecordingRenderBackend(RenderBackend* output = nullptr);
+	void SetOutput(RenderBackend* output);
+	void DrawVertices(const sf::Vertex* vertices, std::size_t count, sf::PrimitiveType type, const sf::RenderStates& states) override;
+	void DrawDrawable(const sf::Drawable& drawable, const sf::RenderStates& states) override;
+
+	//Forgets the commands and stats of the last frame
+	void BeginFrame();
+	const std::vector<Command>& GetCommands() const;
+	const FrameStats& GetFrameStats() const;
+
+	//One line per command. Textures and shaders are numbered in the order this recorder first saw them and
+	//vertex positions are left out, so the same scene gives the same text on every run and machine
+	void WriteFrame(std::ostream& out);
+
+private:
+	void Record(bool drawable, std::size_t count, sf::PrimitiveType type, const sf::RenderStates& states);
+	std::size_t GetIdentifier(std::vector<const void*>& seen, const void* pointer);
+
+private:
+	RenderBackend* m_output;
+	std::vector<Command> m_commands;
+	FrameStats m_stats;
+	std::vector<const void*> m_seen_textures;
+	std::vector<const void*> m_seen_shaders;
+};
+
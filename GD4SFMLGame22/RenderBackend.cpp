@@ -0,0 +1,3 @@
+#include "RenderBackend.hpp"
+
+RenderBackend::~RenderBackend() = default;
@@ -0,0 +1,23 @@
+#pragma once
+#include <SFML/Graphics/PrimitiveType.hpp>
+#include <SFML/Graphics/RenderStates.hpp>
+
+#include <cstddef>
+
+namespace sf
+{
+	class Drawable;
+	class Vertex;
+}
+
+//Where a RenderQueue sends its draw calls. The queue only talks to this, so what the scene draws can be
+//recorded and measured without a window or a GPU
+class RenderBackend
+{
+public:
+	virtual ~RenderBackend();
+	virtual void DrawVertices(const sf::Vertex* vertices, std::size_t count, sf::PrimitiveType type, const sf::RenderStates& states) = 0;
+	//For what the queue cannot see the vertices of, like sf::Text
+	virtual void DrawDrawable(const sf::Drawable& drawable, const sf::RenderStates& states) = 0;
+};
+
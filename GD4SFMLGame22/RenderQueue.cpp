@@ -0,0 +1,113 @@
+#include "RenderQueue.hpp"
+
+#include <SFML/Graphics/Sprite.hpp>
+#include <SFML/Graphics/Texture.hpp>
+
+#include "RenderBackend.hpp"
+
+namespace
+{
+	//Two triangles per sprite, sf::Quads is not available everywhere
+	const std::size_t VerticesPerSprite = 6;
+
+	bool SameStates(const sf::RenderStates& lhs, const sf::RenderStates& rhs)
+	{
+		return lhs.texture == rhs.texture && lhs.shader == rhs.shader && lhs.blendMode == rhs.blendMode;
+	}
+}
+
+RenderQueue::Counters::Counters() : m_items(0), m_sprites(0)
+{
+}
+
+void RenderQueue::AddSprite(const sf::Sprite& sprite, const sf::RenderStates& states)
+{
+	if(!sprite.getTexture())
+	{
+		return;
+	}
+
+	sf::RenderStates sprite_states = states;
+	sprite_states.texture = sprite.getTexture();
+	sprite_states.transform = sf::Transform::Identity;
+	Item item = { sprite_states, nullptr, nullptr, m_vertices.size(), VerticesPerSprite };
+	m_items.push_back(item);
+
+	//The same corners and texture coordinates sf::Sprite draws, taken to where the sprite is on screen here
+	sf::Transform transform = states.transform * sprite.getTransform();
+	sf::FloatRect bounds = sprite.getLocalBounds();
+	sf::FloatRect texture_rect(sprite.getTextureRect());
+	float right = texture_rect.left + texture_rect.width;
+	float bottom = texture_rect.top + texture_rect.height;
+
+	sf::Vertex top_left(transform.transformPoint(0.f, 0.f), sprite.getColor(), sf::Vector2f(texture_rect.left, texture_rect.top));
+	sf::Vertex bottom_left(transform.transformPoint(0.f, bounds.height), sprite.getColor(), sf::Vector2f(texture_rect.left, bottom));
+	sf::Vertex top_right(transform.transformPoint(bounds.width, 0.f), sprite.getColor(), sf::Vector2f(right, texture_rect.top));
+	sf::Vertex bottom_right(transform.transformPoint(bounds.width, bounds.height), sprite.getColor(), sf::Vector2f(right, bottom));
+
+	m_vertices.push_back(top_left);
+	m_vertices.push_back(bottom_left);
+	m_vertices.push_back(top_right);
+	m_vertices.push_back(top_right);
+	m_vertices.push_back(bottom_left);
+	m_vertices.push_back(bottom_right);
+}
+
+void RenderQueue::AddDrawable(const sf::Drawable& drawable, const sf::RenderStates& states)
+{
+	Item item = { states, &drawable, nullptr, 0, 0 };
+	m_items.push_back(item);
+}
+
+void RenderQueue::AddTriangles(const sf::Vertex* vertices, std::size_t count, const sf::RenderStates& states)
+{
+	if(count == 0)
+	{
+		return;
+	}
+
+	Item item = { states, nullptr, vertices, 0, count };
+	m_items.push_back(item);
+}
+
+void RenderQueue::Flush(RenderBackend& backend, Counters& counters)
+{
+	for(const Item& item : m_items)
+	{
+		bool batched = !item.m_drawable && !item.m_triangles;
+		if(!m_batch.empty() && (!batched || !SameStates(item.m_states, m_batch_states)))
+		{
+			DrawBatch(backend);
+		}
+
+		if(item.m_drawable)
+		{
+			backend.DrawDrawable(*item.m_drawable, item.m_states);
+		}
+		else if(item.m_triangles)
+		{
+			backend.DrawVertices(item.m_triangles + item.m_first_vertex, item.m_vertex_count, sf::Triangles, item.m_states);
+		}
+		else
+		{
+			m_batch.insert(m_batch.end(), m_vertices.begin() + item.m_first_vertex, m_vertices.begin() + item.m_first_vertex + item.m_vertex_count);
+			m_batch_states = item.m_states;
+			counters.m_sprites++;
+		}
+		counters.m_items++;
+	}
+
+	if(!m_batch.empty())
+	{
+		DrawBatch(backend);
+	}
+
+	m_items.clear();
+	m_vertices.clear();
+}
+
+void RenderQueue::DrawBatch(RenderBackend& backend)
+{
+	backend.DrawVertices(m_batch.data(), m_batch.size(), sf::Triangles, m_batch_states);
+	m_batch.clear();
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <SFML/System/NonCopyable.hpp>
+#include <SFML/Graphics/RenderStates.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+
+#include <vector>
+
+class RenderBackend;
+
+namespace sf
+{
+	class Drawable;
+	class Sprite;
+}
+
+//Collects what the scene draws in a frame and submits it in the order it was added, so anything added later is
+//drawn over anything added earlier whatever its texture. Sprites added one after the other on the same texture,
+//shader and blend mode go to the target in one call instead of one call each. Anything else in between, or a
+//sprite on other states, ends the run
+class RenderQueue : private sf::NonCopyable
+{
+public:
+	//What the last Flush did: things drawn and how many of them were sprites batched with others.
+	//The draw calls it took are for the backend to count
+	struct Counters
+	{
+		Counters();
+		std::size_t m_items;
+		std::size_t m_sprites;
+	};
+
+public:
+	//The sprite is copied into the queue and drawn in one call with the sprites next to it on the same states
+	void AddSprite(const sf::Sprite& sprite, const sf::RenderStates& states);
+	//Anything else is drawn on its own. It must live until Flush
+	void AddDrawable(const sf::Drawable& drawable, const sf::RenderStates& states);
+	//Vertices the caller already has as a list of triangles, drawn in one call of their own without being copied.
+	//They must live until Flush
+	void AddTriangles(const sf::Vertex* vertices, std::size_t count, const sf::RenderStates& states);
+	//Draws everything added since the last Flush and empties the queue
+	void Flush(RenderBackend& backend, Counters& counters);
+
+private:
+	struct Item
+	{
+		//Sprites are already transformed into vertices and keep an identity transform here
+		sf::RenderStates m_states;
+		const sf::Drawable* m_drawable;
+		const sf::Vertex* m_triangles;
+		//Into m_vertices for a sprite, into m_triangles otherwise
+		std::size_t m_first_vertex;
+		std::size_t m_vertex_count;
+	};
+
+private:
+	void DrawBatch(RenderBackend& backend);
+
+private:
+	std::vector<Item> m_items;
+	std::vector<sf::Vertex> m_vertices;
+	std::vector<sf::Vertex> m_batch;
+	sf::RenderStates m_batch_states;
+};
@@ -16,8 +16,7 @@ public:
 	void Load(Identifier id, const std::string& filename, const Parameter& secondParam);
 	Resource& Get(Identifier id);
 	const Resource& Get(Identifier id) const;
-
-private:
+	//For resources loaded some other way, see AssetLoader
 	void InsertResource(Identifier id, std::unique_ptr<Resource> resource);
 
 private:
@@ -6,9 +6,45 @@
 #include <SFML/Graphics/RectangleShape.hpp>
 #include <SFML/Graphics/RenderTarget.hpp>
 
+#include "JobSystem.hpp"
 #include "Utility.hpp"
 
-SceneNode::SceneNode(Category::Type category):m_children(), m_parent(nullptr), m_default_category(category)
+namespace
+{
+	//Fewer children than this are not worth handing to other threads
+	const std::size_t MinParallelChildren = 16;
+	//More batches than threads, so a thread that finishes early has something to take
+	const std::size_t UpdateBatchesPerThread = 4;
+
+	bool IsEmpty(const sf::FloatRect& rect)
+	{
+		return rect.width <= 0.f || rect.height <= 0.f;
+	}
+
+	sf::FloatRect Union(const sf::FloatRect& lhs, const sf::FloatRect& rhs)
+	{
+		if(IsEmpty(lhs))
+		{
+			return rhs;
+		}
+		if(IsEmpty(rhs))
+		{
+			return lhs;
+		}
+
+		float left = std::min(lhs.left, rhs.left);
+		float top = std::min(lhs.top, rhs.top);
+		float right = std::max(lhs.left + lhs.width, rhs.left + rhs.width);
+		float bottom = std::max(lhs.top + lhs.height, rhs.top + rhs.height);
+		return sf::FloatRect(left, top, right - left, bottom - top);
+	}
+}
+
+SceneNode::DrawCounters::DrawCounters() : m_visited(0), m_culled(0), m_drawn(0)
+{
+}
+
+SceneNode::SceneNode(Category::Type category):m_children(), m_parent(nullptr), m_default_category(category), m_update_jobs(nullptr), m_has_previous_position(false), m_draws_something(false)
 {
 }
 
@@ -36,6 +72,11 @@ void SceneNode::Update(sf::Time dt, CommandQueue& commands)
 	UpdateChildren(dt, commands);
 }
 
+void SceneNode::SetUpdateJobs(JobSystem* jobs)
+{
+	m_update_jobs = jobs;
+}
+
 sf::Vector2f SceneNode::GetWorldPosition() const
 {
 	return GetWorldTransform() * sf::Vector2f();
@@ -58,34 +99,116 @@ void SceneNode::UpdateCurrent(sf::Time dt, CommandQueue& commands)
 
 void SceneNode::UpdateChildren(sf::Time dt, CommandQueue& commands)
 {
+	if(m_update_jobs && m_update_jobs->GetThreadCount() > 1 && m_children.size() >= MinParallelChildren)
+	{
+		UpdateChildrenInParallel(dt, commands);
+		return;
+	}
+
 	for(Ptr& child : m_children)
 	{
 		child->Update(dt, commands);
 	}
 }
 
-void SceneNode::draw(sf::RenderTarget& target, sf::RenderStates states) const
+void SceneNode::UpdateChildrenInParallel(sf::Time dt, CommandQueue& commands)
+{
+	//Children read the transforms above them through GetWorldPosition. sf::Transformable works those out
+	//lazily, so do it here and leave the workers nothing to write
+	GetWorldTransform();
+
+	std::size_t batch_count = std::min(m_children.size(), m_update_jobs->GetThreadCount() * UpdateBatchesPerThread);
+	std::size_t batch_size = (m_children.size() + batch_count - 1) / batch_count;
+	std::vector<CommandQueue> batch_commands(batch_count);
+
+	m_update_jobs->ParallelFor(batch_count, 1, [&](std::size_t batch)
+	{
+		std::size_t end = std::min(m_children.size(), (batch + 1) * batch_size);
+		for(std::size_t i = batch * batch_size; i < end; ++i)
+		{
+			m_children[i]->Update(dt, batch_commands[batch]);
+		}
+	});
+
+	for(CommandQueue& queue : batch_commands)
+	{
+		commands.Append(queue);
+	}
+}
+
+void SceneNode::UpdateDrawBounds()
 {
-	//Apply transform of the current node
+	sf::FloatRect bounds = GetDrawBounds();
+	m_draws_something = !IsEmpty(bounds);
+
+	for(Ptr& child : m_children)
+	{
+		child->UpdateDrawBounds();
+		bounds = Union(bounds, child->m_subtree_bounds);
+	}
+
+	m_subtree_bounds = Union(bounds, m_previous_subtree_bounds);
+	m_previous_subtree_bounds = bounds;
+}
+
+void SceneNode::DrawVisible(RenderQueue& queue, sf::RenderStates states, const sf::FloatRect& view, DrawCounters& counters) const
+{
+	//Nothing below a node can show up outside its subtree bounds
+	counters.m_visited++;
+	if(!view.intersects(m_subtree_bounds))
+	{
+		counters.m_culled++;
+		return;
+	}
+
+	//Apply transform of the current node, moved to where it is drawn this frame
+	states.transform.translate(m_draw_offset);
 	states.transform *= getTransform();
 
 	//Draw the node and children with changed transform
-	DrawCurrent(target, states);
-	DrawChildren(target, states);
-	sf::FloatRect rect = GetBoundingRect();
+	if(m_draws_something)
+	{
+		DrawCurrent(queue, states);
+		counters.m_drawn++;
+	}
+
+	for(const Ptr& child : m_children)
+	{
+		child->DrawVisible(queue, states, view, counters);
+	}
+	//sf::FloatRect rect = GetBoundingRect();
 	//DrawBoundingRect(target, states, rect);
 }
 
-void SceneNode::DrawCurrent(sf::RenderTarget&, sf::RenderStates states) const
+void SceneNode::DrawCurrent(RenderQueue&, sf::RenderStates states) const
 {
 	//Do nothing by default
 }
 
-void SceneNode::DrawChildren(sf::RenderTarget& target, sf::RenderStates states) const
+
+void SceneNode::StorePreviousPosition()
+{
+	m_previous_position = getPosition();
+	m_has_previous_position = true;
+
+	for(Ptr& child : m_children)
+	{
+		child->StorePreviousPosition();
+	}
+}
+
+void SceneNode::Interpolate(float interpolation)
 {
-	for (const Ptr& child : m_children)
+	//The offset is relative to the parent like the position, so each node only blends its own movement
+	m_draw_offset = sf::Vector2f();
+	if(m_has_previous_position)
+	{
+		m_draw_offset = (m_previous_position - getPosition()) * (1.f - interpolation);
+	}
+
+	for(Ptr& child : m_children)
 	{
-		child->draw(target, states);
+		child->Interpolate(interpolation);
 	}
 }
 
@@ -119,6 +242,11 @@ sf::FloatRect SceneNode::GetBoundingRect() const
 	return sf::FloatRect();
 }
 
+sf::FloatRect SceneNode::GetDrawBounds() const
+{
+	return GetBoundingRect();
+}
+
 void SceneNode::DrawBoundingRect(sf::RenderTarget& target, sf::RenderStates states, sf::FloatRect& rect) const
 {
 	sf::RectangleShape shape;
@@ -135,27 +263,36 @@ bool Collision(const SceneNode& lhs, const SceneNode& rhs)
 	return lhs.GetBoundingRect().intersects(rhs.GetBoundingRect());
 }
 
-void SceneNode::CheckNodeCollision(SceneNode& node, std::set<Pair>& collision_pairs)
+void SceneNode::GatherColliders(std::vector<Collider>& colliders)
 {
-	if(this != &node && Collision(*this, node) && !IsDestroyed() && !node.IsDestroyed())
+	//Nodes without an area can never intersect anything
+	sf::FloatRect bounds = GetBoundingRect();
+	if(bounds.width > 0.f && bounds.height > 0.f && !IsDestroyed())
 	{
-		collision_pairs.insert(std::minmax(this, &node));
+		colliders.push_back(Collider{ this, bounds });
 	}
+
 	for(Ptr& child : m_children)
 	{
-		child->CheckNodeCollision(node, collision_pairs);
+		child->GatherColliders(colliders);
 	}
 }
 
-void SceneNode::CheckSceneCollision(SceneNode& scene_graph, std::set<Pair>& collision_pairs)
+void SceneNode::AddEmittedParticles()
 {
-	CheckNodeCollision(scene_graph, collision_pairs);
-	for(Ptr& child : scene_graph.m_children)
+	AddEmittedParticlesCurrent();
+
+	for(Ptr& child : m_children)
 	{
-		CheckSceneCollision(*child, collision_pairs);
+		child->AddEmittedParticles();
 	}
 }
 
+void SceneNode::AddEmittedParticlesCurrent()
+{
+	//Only emitters have anything to add
+}
+
 bool SceneNode::IsDestroyed() const
 {
 	//What should the default for a Scenenode be
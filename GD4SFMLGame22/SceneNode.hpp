@@ -2,7 +2,7 @@
 #include <SFML/System/NonCopyable.hpp>
 #include <SFML/System/Time.hpp>
 #include <SFML/Graphics/Transformable.hpp>
-#include <SFML/Graphics/Drawable.hpp>
+#include <SFML/Graphics/RenderStates.hpp>
 
 #include <vector>
 #include <memory>
@@ -11,18 +11,43 @@
 #include "Command.hpp"
 #include "CommandQueue.hpp"
 
-class SceneNode : public sf::Transformable, public sf::Drawable, private sf::NonCopyable
+class JobSystem;
+class RenderQueue;
+
+//Scene nodes are not sf::Drawables. Drawing goes through DrawVisible, which culls with the bounds UpdateDrawBounds
+//works out and queues into a RenderQueue that lives across frames, see World::Draw
+class SceneNode : public sf::Transformable, private sf::NonCopyable
 {
 public:
 	typedef  std::unique_ptr<SceneNode> Ptr;
 	typedef std::pair<SceneNode*, SceneNode*> Pair;
 
+	struct Collider
+	{
+		SceneNode* m_node;
+		sf::FloatRect m_bounds;
+	};
+
+	//What the last DrawVisible did: nodes looked at, subtrees skipped because they were outside the view and
+	//nodes that drew something
+	struct DrawCounters
+	{
+		DrawCounters();
+		std::size_t m_visited;
+		std::size_t m_culled;
+		std::size_t m_drawn;
+	};
+
 public:
 	explicit SceneNode(Category::Type category = Category::kNone);
 	void AttachChild(Ptr child);
 	Ptr DetachChild(const SceneNode& node);
 
 	void Update(sf::Time dt, CommandQueue& commands);
+	//The children of this node are then updated side by side on jobs, each batch with its own command queue.
+	//The queues are appended in child order afterwards, so the result is the same as updating them one after
+	//the other. Children may only reach each other and the rest of the scene through commands
+	void SetUpdateJobs(JobSystem* jobs);
 
 	sf::Vector2f GetWorldPosition() const;
 	sf::Transform GetWorldTransform() const;
@@ -30,32 +55,55 @@ public:
 	void OnCommand(const Command& command, sf::Time dt);
 	virtual unsigned int GetCategory() const;
 	virtual sf::FloatRect GetBoundingRect() const;
+	//What DrawCurrent covers in world coordinates, the bounding rect unless a node draws more or less than it collides with
+	virtual sf::FloatRect GetDrawBounds() const;
 
-	void CheckSceneCollision(SceneNode& scene_graph, std::set<Pair>& collision_pairs);
+	//Works out the world bounds of every subtree, covering where it is now and where it was at the last call
+	//so that interpolated drawing stays inside. Called once per simulation step before drawing
+	void UpdateDrawBounds();
+	//Queues only the subtrees that overlap view, which is in world coordinates. Nothing is drawn until the queue is flushed
+	void DrawVisible(RenderQueue& queue, sf::RenderStates states, const sf::FloatRect& view, DrawCounters& counters) const;
+
+	//Remember where every node is before a simulation step, then place them part of the way between that
+	//and where they are now for drawing. Only the drawing moves, the nodes keep their simulated position
+	void StorePreviousPosition();
+	void Interpolate(float interpolation);
+
+	//Every node that can still collide, with its bounds in world coordinates. The bounds are worked out
+	//once here so the colliders can be tested against each other without touching the nodes
+	void GatherColliders(std::vector<Collider>& colliders);
+	//Hands the particles emitters buffered during Update to their particle nodes, in scene graph order so the
+	//result does not depend on how the update was shared out over threads
+	void AddEmittedParticles();
 	void RemoveWrecks();
 
 
 private:
 	virtual void UpdateCurrent(sf::Time dt, CommandQueue& commands);
+	virtual void AddEmittedParticlesCurrent();
 	void UpdateChildren(sf::Time dt, CommandQueue& commands);
+	void UpdateChildrenInParallel(sf::Time dt, CommandQueue& commands);
 
-	//Note draw is from sf::Drawable hence the name, lower case d
-	virtual void draw(sf::RenderTarget& target, sf::RenderStates states) const;
-	virtual void DrawCurrent(sf::RenderTarget&, sf::RenderStates states) const;
-	void DrawChildren(sf::RenderTarget& target, sf::RenderStates states) const;
+	virtual void DrawCurrent(RenderQueue& queue, sf::RenderStates states) const;
 
 	void DrawBoundingRect(sf::RenderTarget& target, sf::RenderStates states, sf::FloatRect& bounding_rect) const;
 
 	virtual bool IsDestroyed() const;
 	virtual bool IsMarkedForRemoval() const;
-	
-	void CheckNodeCollision(SceneNode& node, std::set<Pair>& collisionPairs);
-	
+
 
 private:
 	std::vector<Ptr> m_children;
 	SceneNode* m_parent;
 	Category::Type m_default_category;
+	JobSystem* m_update_jobs;
+	//Nodes attached since the last step have no previous position and are drawn where they are
+	bool m_has_previous_position;
+	sf::Vector2f m_previous_position;
+	sf::Vector2f m_draw_offset;
+	sf::FloatRect m_subtree_bounds;
+	sf::FloatRect m_previous_subtree_bounds;
+	bool m_draws_something;
 };
 bool Collision(const SceneNode& lhs, const SceneNode& rhs);
 float Distance(const SceneNode& lhs, const SceneNode& rhs);
@@ -0,0 +1,208 @@
+#ifdef PERFORMANCE_CHECKS
+
+#include <SFML/Network/IpAddress.hpp>
+#include <SFML/Network/TcpSocket.hpp>
+#include <SFML/System/Clock.hpp>
+#include <SFML/System/Sleep.hpp>
+
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "DebugSettings.hpp"
+#include "GameServer.hpp"
+#include "JobSystem.hpp"
+#include "NetworkProtocol.hpp"
+#include "PacketTransport.hpp"
+#include "PerformanceChecks.hpp"
+#include "ShardConfig.hpp"
+#include "WireFormat.hpp"
+
+namespace
+{
+	//Enough clients for UpdatePeers to share them out over the server's job system
+	const std::size_t AllocationCheckClients = 8;
+	//As many as a server lets in
+	const std::size_t ScalingClients = 15;
+	const sf::Time ClientTickRate = sf::seconds(1.f / 20.f);
+	const sf::Time ConnectTimeout = sf::seconds(1.f);
+	const std::size_t ConnectAttempts = 20;
+	//Long enough for the first enemy wave, so the buffers it needs are already there when measuring starts
+	const sf::Time WarmUpTime = sf::seconds(6.f);
+	const sf::Time MeasuredTime = sf::seconds(10.f);
+	//The server prints its tick time every 10 seconds with statistics on, wait for the first report
+	const sf::Time ScalingRunTime = sf::seconds(10.5f);
+
+	//How far the aircraft of the test clients swing left and right of where they spawned
+	const float SwingDistance = 300.f;
+	const float ScrollSpeed = 50.f;
+
+	//Just enough of a client to keep the server busy: it says hello, flies the aircraft it is given from side
+	//to side, sends its position every tick and reads and drops everything else the server sends
+	struct TestClient
+	{
+		TestClient() : m_aircraft_identifier(0)
+		{
+		}
+
+		sf::TcpSocket m_socket;
+		PacketTransport m_transport;
+		sf::Int32 m_aircraft_identifier;
+		sf::Vector2f m_spawn_position;
+	};
+
+	typedef std::unique_ptr<TestClient> ClientPtr;
+
+	bool ConnectClients(std::vector<ClientPtr>& clients, std::size_t count, unsigned short port)
+	{
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			ClientPtr client(new TestClient());
+
+			//The server thread may not be listening yet
+			sf::Socket::Status status = sf::Socket::Error;
+			for (std::size_t attempt = 0; attempt < ConnectAttempts && status != sf::Socket::Done; ++attempt)
+			{
+				status = client->m_socket.connect(sf::IpAddress::LocalHost, port, ConnectTimeout);
+				if (status != sf::Socket::Done)
+				{
+					sf::sleep(sf::milliseconds(50));
+				}
+			}
+			if (status != sf::Socket::Done)
+			{
+				return false;
+			}
+			client->m_socket.setBlocking(false);
+
+			Wire::Writer hello = client->m_transport.BeginFrame();
+			hello << Wire::Tag(Client::PacketType::Hello) << Wire::VarInt(PROTOCOL_VERSION) << Wire::VarInt(0);
+			client->m_transport.EndFrame();
+			clients.emplace_back(std::move(client));
+		}
+		return true;
+	}
+
+	bool StepClients(std::vector<ClientPtr>& clients, sf::Time time, TransportStats& stats)
+	{
+		for (std::size_t i = 0; i < clients.size(); ++i)
+		{
+			TestClient& client = *clients[i];
+			if (client.m_transport.Receive(client.m_socket, stats) == sf::Socket::Disconnected)
+			{
+				return false;
+			}
+
+			Wire::Reader frame;
+			while (client.m_transport.PollFrame(frame))
+			{
+				Server::PacketType type;
+				if (frame >> Wire::Tag(type) && type == Server::PacketType::SpawnSelf)
+				{
+					frame >> Wire::VarInt(client.m_aircraft_identifier) >> Wire::Position(client.m_spawn_position);
+				}
+			}
+
+			//Each aircraft swings at its own phase so they spread over the battlefield
+			Wire::Writer update = client.m_transport.BeginFrame();
+			update << Wire::Tag(Client::PacketType::PositionUpdate);
+			if (client.m_aircraft_identifier != 0)
+			{
+				float phase = time.asSeconds() + static_cast<float>(i);
+				sf::Vector2f position(client.m_spawn_position.x + SwingDistance * std::sin(phase), client.m_spawn_position.y - ScrollSpeed * time.asSeconds());
+				update << Wire::VarInt(1) << Wire::VarInt(client.m_aircraft_identifier) << Wire::Position(position) << Wire::VarInt(100) << Wire::VarInt(2)
+					<< Wire::VarInt(0) << Wire::VarInt(0);
+			}
+			else
+			{
+				update << Wire::VarInt(0);
+			}
+			client.m_transport.EndFrame();
+			client.m_transport.Flush(client.m_socket, stats);
+		}
+		return true;
+	}
+
+	bool RunClients(std::vector<ClientPtr>& clients, const sf::Clock& game_clock, sf::Time duration, TransportStats& stats)
+	{
+		sf::Clock clock;
+		while (clock.getElapsedTime() < duration)
+		{
+			if (!StepClients(clients, game_clock.getElapsedTime(), stats))
+			{
+				return false;
+			}
+			sf::sleep(ClientTickRate);
+		}
+		return true;
+	}
+}
+
+//Runs a real server on its own thread with a crowd of clients on loopback and counts the allocations of
+//every thread once it has warmed up. The clients themselves only use buffers that keep their capacity, so
+//anything counted comes from the server's ticks, timers, sockets and job system
+
+bool CheckServerTickAllocations()
+{
+	ShardConfig shard_config;
+	GameServer server(sf::Vector2f(1024.f, 768.f), shard_config, std::string(), DebugSettings());
+	sf::Clock game_clock;
+
+	std::vector<ClientPtr> clients;
+	if (!ConnectClients(clients, AllocationCheckClients, shard_config.GetClientPort(shard_config.GetIndex())))
+	{
+		std::cout << "Server ticks: could not connect to the server on loopback" << std::endl;
+		return false;
+	}
+
+	TransportStats stats;
+	if (!RunClients(clients, game_clock, WarmUpTime, stats))
+	{
+		std::cout << "Server ticks: a client was dropped during the warm up" << std::endl;
+		return false;
+	}
+
+	std::size_t allocations_before = GetAllocationCount();
+	bool connected = RunClients(clients, game_clock, MeasuredTime, stats);
+	std::size_t allocations = GetAllocationCount() - allocations_before;
+
+	std::cout << "Server ticks: " << allocations << " allocations in " << MeasuredTime.asSeconds() << "s with " << AllocationCheckClients << " clients on "
+		<< JobSystem::GetSpareThreadCount() + 1 << " cores" << (connected ? "" : ", a client was dropped") << std::endl;
+	return connected && allocations == 0;
+}
+
+//Runs a full server with 1, 2, 4, ... threads up to the core count. Each server prints its transport
+//statistics after 10 seconds, including the CPU time of a tick and the threads it ran on
+
+void MeasureServerTickScaling()
+{
+	std::size_t cores = JobSystem::GetSpareThreadCount() + 1;
+	std::vector<std::size_t> thread_counts;
+	for (std::size_t threads = 1; threads < cores; threads *= 2)
+	{
+		thread_counts.emplace_back(threads);
+	}
+	thread_counts.emplace_back(cores);
+
+	for (std::size_t threads : thread_counts)
+	{
+		DebugSettings debug_settings;
+		debug_settings.m_report_statistics = true;
+		debug_settings.m_server_threads = threads;
+
+		ShardConfig shard_config;
+		GameServer server(sf::Vector2f(1024.f, 768.f), shard_config, std::string(), debug_settings);
+		sf::Clock game_clock;
+
+		std::vector<ClientPtr> clients;
+		TransportStats stats;
+		if (!ConnectClients(clients, ScalingClients, shard_config.GetClientPort(shard_config.GetIndex())) || !RunClients(clients, game_clock, ScalingRunTime, stats))
+		{
+			std::cout << "Server tick scaling: the clients lost the server with " << threads << " threads" << std::endl;
+			return;
+		}
+	}
+}
+
+#endif
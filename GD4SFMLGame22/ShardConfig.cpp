@@ -0,0 +1,65 @@
+#include "ShardConfig.hpp"
+#include "NetworkProtocol.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+ShardConfig::ShardConfig()
+	: m_index(0)
+	, m_count(1)
+{
+}
+
+ShardConfig::ShardConfig(std::size_t index, std::size_t count)
+	: m_index(index)
+	, m_count(std::max<std::size_t>(1, count))
+{
+	m_index = std::min(m_index, m_count - 1);
+}
+
+std::size_t ShardConfig::GetIndex() const
+{
+	return m_index;
+}
+
+std::size_t ShardConfig::GetCount() const
+{
+	return m_count;
+}
+
+bool ShardConfig::IsSharded() const
+{
+	return m_count > 1;
+}
+
+std::size_t ShardConfig::GetShardAt(float y, float world_height) const
+{
+	//y grows downwards, so the bands are counted from the bottom of the world
+	float band_height = world_height / m_count;
+	float band = std::floor((world_height - y) / band_height);
+	if (band < 0.f)
+	{
+		return 0;
+	}
+	return std::min(static_cast<std::size_t>(band), m_count - 1);
+}
+
+float ShardConfig::GetBandTop(std::size_t shard, float world_height) const
+{
+	return world_height - (shard + 1) * (world_height / m_count);
+}
+
+float ShardConfig::GetBandBottom(std::size_t shard, float world_height) const
+{
+	return world_height - shard * (world_height / m_count);
+}
+
+unsigned short ShardConfig::GetClientPort(std::size_t shard) const
+{
+	return static_cast<unsigned short>(SERVER_PORT + shard);
+}
+
+unsigned short ShardConfig::GetLinkPort(std::size_t shard) const
+{
+	return static_cast<unsigned short>(SHARD_LINK_PORT + shard);
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+
+//Which part of the world a server process is responsible for. The world is cut into bands of equal
+//height, shard 0 at the bottom where the mission starts and the highest shard at the finish line.
+//Each shard only talks to the shards directly above and below it. The default is a single shard that
+//owns the whole world, which is how the server runs inside a hosting client
+
+class ShardConfig
+{
+public:
+	ShardConfig();
+	ShardConfig(std::size_t index, std::size_t count);
+
+	std::size_t GetIndex() const;
+	std::size_t GetCount() const;
+	bool IsSharded() const;
+
+	//Positions above or below the world belong to the top or bottom shard
+	std::size_t GetShardAt(float y, float world_height) const;
+	float GetBandTop(std::size_t shard, float world_height) const;
+	float GetBandBottom(std::size_t shard, float world_height) const;
+
+	//Clients connect to SERVER_PORT + index, neighbouring shards to SHARD_LINK_PORT + index
+	unsigned short GetClientPort(std::size_t shard) const;
+	unsigned short GetLinkPort(std::size_t shard) const;
+
+private:
+	std::size_t m_index;
+	std::size_t m_count;
+};
@@ -1,8 +1,10 @@
 #include "SoundPlayer.hpp"
+#include "AssetLoader.hpp"
 #include "SoundEffect.hpp"
 
 #include <SFML/Audio/Listener.hpp>
 
+#include <algorithm>
 #include <cmath>
 
 
@@ -14,22 +16,78 @@ namespace
 	const float Attenuation = 8.f;
 	const float MinDistance2D = 200.f;
 	const float MinDistance3D = std::sqrt(MinDistance2D * MinDistance2D + ListenerZ * ListenerZ);
+
+	// OpenAL implementations allow from 32 to 256 sources, the music needs one of them
+	const std::size_t VoiceCount = 32;
+	// Effects that would start quieter than this are not played
+	const float MinGain = 0.05f;
+
+	// The same effect started within this long and this close to a playing one is merged into it
+	const sf::Time CoalesceWindow = sf::milliseconds(80);
+	const float CoalesceRadius = 96.f;
+	// A lone effect plays at full volume, which is as loud as OpenAL goes. Merging n effects multiplies the distance
+	// it stays at full volume over by sqrt(n) instead, so a burst of guns carries further than one gun without
+	// taking a voice each
+	float GetMinDistance(std::size_t merged)
+	{
+		return MinDistance3D * std::sqrt(static_cast<float>(std::max<std::size_t>(1, merged)));
+	}
+
+	// Higher is more important, indexed by SoundEffect
+	const int Priorities[] =
+	{
+		1,	// kAlliedGunfire
+		0,	// kEnemyGunfire
+		2,	// kExplosion1
+		2,	// kExplosion2
+		2,	// kLaunchMissile
+		3,	// kCollectPickup
+		4	// kButton
+	};
+}
+
+SoundPlayer::Counters::Counters()
+	: m_played(0)
+	, m_stolen(0)
+	, m_culled(0)
+	, m_rejected(0)
+	, m_coalesced(0)
+{
+}
+
+SoundPlayer::Voice::Voice()
+	: m_effect(SoundEffect::kButton)
+	, m_merged(0)
+	, m_priority(0)
+	, m_started(0)
+{
 }
 
 SoundPlayer::SoundPlayer()
+	: m_voices(VoiceCount)
+	, m_play_count(0)
 {
-	m_sound_buffers.Load(SoundEffect::kAlliedGunfire, "Media/Sound/AlliedGunfire.wav");
-	m_sound_buffers.Load(SoundEffect::kEnemyGunfire, "Media/Sound/EnemyGunfire.wav");
-	m_sound_buffers.Load(SoundEffect::kExplosion1, "Media/Sound/Explosion1.wav");
-	m_sound_buffers.Load(SoundEffect::kExplosion2, "Media/Sound/Explosion2.wav");
-	m_sound_buffers.Load(SoundEffect::kLaunchMissile, "Media/Sound/LaunchMissile.wav");
-	m_sound_buffers.Load(SoundEffect::kCollectPickup, "Media/Sound/CollectPickup.wav");
-	m_sound_buffers.Load(SoundEffect::kButton, "Media/Sound/Button.wav");
+	for (Voice& voice : m_voices)
+	{
+		voice.m_sound.setAttenuation(Attenuation);
+		voice.m_sound.setMinDistance(MinDistance3D);
+	}
 
 	// Listener points towards the screen (default in SFML)
 	sf::Listener::setDirection(0.f, 0.f, -1.f);
 }
 
+void SoundPlayer::LoadBuffers(AssetLoader& loader)
+{
+	loader.LoadSoundBuffer(m_sound_buffers, SoundEffect::kAlliedGunfire, "Media/Sound/AlliedGunfire.wav");
+	loader.LoadSoundBuffer(m_sound_buffers, SoundEffect::kEnemyGunfire, "Media/Sound/EnemyGunfire.wav");
+	loader.LoadSoundBuffer(m_sound_buffers, SoundEffect::kExplosion1, "Media/Sound/Explosion1.wav");
+	loader.LoadSoundBuffer(m_sound_buffers, SoundEffect::kExplosion2, "Media/Sound/Explosion2.wav");
+	loader.LoadSoundBuffer(m_sound_buffers, SoundEffect::kLaunchMissile, "Media/Sound/LaunchMissile.wav");
+	loader.LoadSoundBuffer(m_sound_buffers, SoundEffect::kCollectPickup, "Media/Sound/CollectPickup.wav");
+	loader.LoadSoundBuffer(m_sound_buffers, SoundEffect::kButton, "Media/Sound/Button.wav");
+}
+
 void SoundPlayer::Play(SoundEffect effect)
 {
 	Play(effect, GetListenerPosition());
@@ -37,23 +95,44 @@ void SoundPlayer::Play(SoundEffect effect)
 
 void SoundPlayer::Play(SoundEffect effect, sf::Vector2f position)
 {
-	m_sounds.emplace_back(sf::Sound());
-	sf::Sound& sound = m_sounds.back();
+	if (GetGain(position, 1) < MinGain)
+	{
+		m_counters.m_culled++;
+		return;
+	}
 
-	sound.setBuffer(m_sound_buffers.Get(effect));
-	sound.setPosition(position.x, -position.y, 0.f);
-	sound.setAttenuation(Attenuation);
-	sound.setMinDistance(MinDistance3D);
+	if (Coalesce(effect, position))
+	{
+		m_counters.m_coalesced++;
+		return;
+	}
 
-	sound.play();
-}
+	int priority = Priorities[static_cast<int>(effect)];
+	Voice* voice = FindVoice(priority);
+	if (voice == nullptr)
+	{
+		m_counters.m_rejected++;
+		return;
+	}
 
-void SoundPlayer::RemoveStoppedSounds()
-{
-	m_sounds.remove_if([](const sf::Sound& s)
+	if (voice->m_sound.getStatus() != sf::Sound::Stopped)
 	{
-		return s.getStatus() == sf::Sound::Stopped;
-	});
+		m_counters.m_stolen++;
+		voice->m_sound.stop();
+	}
+
+	voice->m_position = position;
+	voice->m_effect = effect;
+	voice->m_merged = 1;
+	voice->m_priority = priority;
+	voice->m_started = m_play_count++;
+
+	sf::Sound& sound = voice->m_sound;
+	sound.setBuffer(m_sound_buffers.Get(effect));
+	sound.setPosition(position.x, -position.y, 0.f);
+	sound.setMinDistance(GetMinDistance(1));
+	sound.play();
+	m_counters.m_played++;
 }
 
 void SoundPlayer::SetListenerPosition(sf::Vector2f position)
@@ -66,3 +145,87 @@ sf::Vector2f SoundPlayer::GetListenerPosition() const
 	sf::Vector3f position = sf::Listener::getPosition();
 	return sf::Vector2f(position.x, -position.y);
 }
+
+std::size_t SoundPlayer::GetActiveVoiceCount() const
+{
+	std::size_t count = 0;
+	for (const Voice& voice : m_voices)
+	{
+		if (voice.m_sound.getStatus() != sf::Sound::Stopped)
+			++count;
+	}
+	return count;
+}
+
+std::size_t SoundPlayer::GetVoiceCount() const
+{
+	return m_voices.size();
+}
+
+const SoundPlayer::Counters& SoundPlayer::GetCounters() const
+{
+	return m_counters;
+}
+
+void SoundPlayer::ResetCounters()
+{
+	m_counters = Counters();
+}
+
+float SoundPlayer::GetGain(sf::Vector2f position, std::size_t merged) const
+{
+	// OpenAL's default inverse distance clamped model, which is what SFML uses
+	sf::Vector2f offset = position - GetListenerPosition();
+	float distance = std::sqrt(offset.x * offset.x + offset.y * offset.y + ListenerZ * ListenerZ);
+	float min_distance = GetMinDistance(merged);
+	if (distance <= min_distance)
+		return 1.f;
+	return min_distance / (min_distance + Attenuation * (distance - min_distance));
+}
+
+SoundPlayer::Voice* SoundPlayer::FindVoice(int priority)
+{
+	Voice* best = nullptr;
+	float best_gain = 0.f;
+	for (Voice& voice : m_voices)
+	{
+		if (voice.m_sound.getStatus() == sf::Sound::Stopped)
+			return &voice;
+
+		if (voice.m_priority > priority)
+			continue;
+
+		// Least important first, then the quietest, then the oldest
+		float gain = GetGain(voice.m_position, voice.m_merged);
+		if (best == nullptr
+			|| voice.m_priority < best->m_priority
+			|| (voice.m_priority == best->m_priority && (gain < best_gain || (gain == best_gain && voice.m_started < best->m_started))))
+		{
+			best = &voice;
+			best_gain = gain;
+		}
+	}
+	return best;
+}
+
+bool SoundPlayer::Coalesce(SoundEffect effect, sf::Vector2f position)
+{
+	for (Voice& voice : m_voices)
+	{
+		if (voice.m_effect != effect || voice.m_sound.getStatus() != sf::Sound::Playing)
+			continue;
+
+		sf::Vector2f offset = position - voice.m_position;
+		if (offset.x * offset.x + offset.y * offset.y > CoalesceRadius * CoalesceRadius
+			|| voice.m_sound.getPlayingOffset() > CoalesceWindow)
+			continue;
+
+		// The voice moves to the middle of everything merged into it
+		voice.m_merged++;
+		voice.m_position += offset / static_cast<float>(voice.m_merged);
+		voice.m_sound.setPosition(voice.m_position.x, -voice.m_position.y, 0.f);
+		voice.m_sound.setMinDistance(GetMinDistance(voice.m_merged));
+		return true;
+	}
+	return false;
+}
@@ -7,24 +7,73 @@
 #include <SFML/Audio/SoundBuffer.hpp>
 #include <SFML/Audio/Sound.hpp>
 
-#include <list>
+#include <vector>
 
+class AssetLoader;
 
+//Plays effects on a fixed number of voices that are made up front, so the number of OpenAL sources never
+//grows. Effects too far from the listener to be heard are not played. When every voice is busy the new
+//effect takes the voice of the least important effect, the quietest and then the oldest of those, as long
+//as that one is not more important than the new effect. An effect that starts right after the same effect
+//close by is merged into it instead, which makes that voice louder and sits it between the two
 class SoundPlayer : private sf::NonCopyable
 {
+public:
+	//Since the last ResetCounters
+	struct Counters
+	{
+		Counters();
+
+		std::size_t m_played;
+		//Played on a voice that was still playing something else
+		std::size_t m_stolen;
+		//Not played because they would not be heard
+		std::size_t m_culled;
+		//Not played because every voice had something more important on it
+		std::size_t m_rejected;
+		//Merged into a voice that had just started the same effect nearby
+		std::size_t m_coalesced;
+	};
+
 public:
 	SoundPlayer();
+	//Effects can only be played once loader has finished loading them
+	void LoadBuffers(AssetLoader& loader);
 
 	void Play(SoundEffect effect);
 	void Play(SoundEffect effect, sf::Vector2f position);
 
-	void RemoveStoppedSounds();
 	void SetListenerPosition(sf::Vector2f position);
 	sf::Vector2f GetListenerPosition() const;
 
+	std::size_t GetActiveVoiceCount() const;
+	std::size_t GetVoiceCount() const;
+	const Counters& GetCounters() const;
+	void ResetCounters();
+
+
+private:
+	struct Voice
+	{
+		Voice();
+
+		sf::Sound m_sound;
+		sf::Vector2f m_position;
+		SoundEffect m_effect;
+		std::size_t m_merged;
+		int m_priority;
+		sf::Uint64 m_started;
+	};
+
+	//How loud an effect at position is for the listener, from 0 to 1, merged being how many effects its voice carries
+	float GetGain(sf::Vector2f position, std::size_t merged) const;
+	Voice* FindVoice(int priority);
+	bool Coalesce(SoundEffect effect, sf::Vector2f position);
+
 
 private:
 	SoundBufferHolder m_sound_buffers;
-	std::list<sf::Sound> m_sounds;
+	std::vector<Voice> m_voices;
+	sf::Uint64 m_play_count;
+	Counters m_counters;
 };
-
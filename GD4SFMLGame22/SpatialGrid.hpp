@@ -0,0 +1,46 @@
+#pragma once
+#include <SFML/Config.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/System/Vector2.hpp>
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+//Uniform grid over 2D positions. It is meant to be cleared and refilled every frame/tick - cell vectors are
+//kept between fills so that steady state refills do not allocate
+
+template <typename Identifier>
+class SpatialGrid
+{
+public:
+	explicit SpatialGrid(float cell_size);
+
+	void Clear();
+	void Insert(Identifier id, sf::Vector2f position);
+
+	//Appends every identifier whose position lies inside area
+	void Query(const sf::FloatRect& area, std::vector<Identifier>& out) const;
+	//The identifier closest to position, false when the grid is empty. Searches outwards ring by ring and stops
+	//as soon as no cell further out can hold anything closer
+	bool FindNearest(sf::Vector2f position, Identifier& out) const;
+	std::size_t GetSize() const;
+
+private:
+	struct Entry
+	{
+		Identifier m_id;
+		sf::Vector2f m_position;
+	};
+
+private:
+	sf::Vector2i GetCell(sf::Vector2f position) const;
+	static sf::Int64 GetKey(int x, int y);
+
+private:
+	float m_cell_size;
+	std::size_t m_size;
+	std::unordered_map<sf::Int64, std::vector<Entry>> m_cells;
+	std::vector<sf::Int64> m_occupied_cells;
+};
+#include "SpatialGrid.inl"
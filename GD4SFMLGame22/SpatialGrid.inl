@@ -0,0 +1,154 @@
+#include <cmath>
+
+template <typename Identifier>
+SpatialGrid<Identifier>::SpatialGrid(float cell_size)
+	: m_cell_size(cell_size)
+	, m_size(0)
+{
+}
+
+template <typename Identifier>
+void SpatialGrid<Identifier>::Clear()
+{
+	//Only empty the cells that were used, their storage is reused by the next fill
+	for (sf::Int64 key : m_occupied_cells)
+	{
+		m_cells[key].clear();
+	}
+	m_occupied_cells.clear();
+	m_size = 0;
+}
+
+template <typename Identifier>
+void SpatialGrid<Identifier>::Insert(Identifier id, sf::Vector2f position)
+{
+	sf::Vector2i cell = GetCell(position);
+	sf::Int64 key = GetKey(cell.x, cell.y);
+
+	std::vector<Entry>& entries = m_cells[key];
+	if (entries.empty())
+	{
+		m_occupied_cells.emplace_back(key);
+	}
+	entries.push_back(Entry{ id, position });
+	++m_size;
+}
+
+template <typename Identifier>
+void SpatialGrid<Identifier>::Query(const sf::FloatRect& area, std::vector<Identifier>& out) const
+{
+	sf::Vector2i first = GetCell(sf::Vector2f(area.left, area.top));
+	sf::Vector2i last = GetCell(sf::Vector2f(area.left + area.width, area.top + area.height));
+	std::size_t covered_cells = static_cast<std::size_t>(last.x - first.x + 1) * static_cast<std::size_t>(last.y - first.y + 1);
+
+	auto collect = [&](const std::vector<Entry>& entries)
+	{
+		for (const Entry& entry : entries)
+		{
+			if (area.contains(entry.m_position))
+			{
+				out.push_back(entry.m_id);
+			}
+		}
+	};
+
+	//A large area is cheaper to answer from the occupied cells than by walking every cell it covers
+	if (covered_cells > m_occupied_cells.size())
+	{
+		for (sf::Int64 key : m_occupied_cells)
+		{
+			collect(m_cells.find(key)->second);
+		}
+		return;
+	}
+
+	for (int y = first.y; y <= last.y; ++y)
+	{
+		for (int x = first.x; x <= last.x; ++x)
+		{
+			auto found = m_cells.find(GetKey(x, y));
+			if (found != m_cells.end())
+			{
+				collect(found->second);
+			}
+		}
+	}
+}
+
+template <typename Identifier>
+bool SpatialGrid<Identifier>::FindNearest(sf::Vector2f position, Identifier& out) const
+{
+	if (m_size == 0)
+	{
+		return false;
+	}
+
+	float best_distance = -1.f;
+	auto check = [&](const std::vector<Entry>& entries)
+	{
+		for (const Entry& entry : entries)
+		{
+			sf::Vector2f offset = entry.m_position - position;
+			float distance = offset.x * offset.x + offset.y * offset.y;
+			if (best_distance < 0.f || distance < best_distance)
+			{
+				best_distance = distance;
+				out = entry.m_id;
+			}
+		}
+	};
+
+	sf::Vector2i centre = GetCell(position);
+	for (int ring = 0; ; ++ring)
+	{
+		//Once the rings cover more cells than are occupied, looking at the occupied cells is cheaper
+		std::size_t side = static_cast<std::size_t>(2 * ring + 1);
+		if (side * side > m_occupied_cells.size())
+		{
+			for (sf::Int64 key : m_occupied_cells)
+			{
+				check(m_cells.find(key)->second);
+			}
+			return true;
+		}
+
+		for (int y = centre.y - ring; y <= centre.y + ring; ++y)
+		{
+			//Only the border of the ring, the inside was searched already
+			int step = (y == centre.y - ring || y == centre.y + ring) ? 1 : 2 * ring;
+			for (int x = centre.x - ring; x <= centre.x + ring; x += step)
+			{
+				auto found = m_cells.find(GetKey(x, y));
+				if (found != m_cells.end())
+				{
+					check(found->second);
+				}
+			}
+		}
+
+		//Everything beyond this ring is at least ring cells away from position
+		float reach = ring * m_cell_size;
+		if (best_distance >= 0.f && best_distance <= reach * reach)
+		{
+			return true;
+		}
+	}
+}
+
+template <typename Identifier>
+std::size_t SpatialGrid<Identifier>::GetSize() const
+{
+	return m_size;
+}
+
+template <typename Identifier>
+sf::Vector2i SpatialGrid<Identifier>::GetCell(sf::Vector2f position) const
+{
+	return sf::Vector2i(static_cast<int>(std::floor(position.x / m_cell_size)), static_cast<int>(std::floor(position.y / m_cell_size)));
+}
+
+template <typename Identifier>
+sf::Int64 SpatialGrid<Identifier>::GetKey(int x, int y)
+{
+	return static_cast<sf::Int64>((static_cast<sf::Uint64>(static_cast<sf::Uint32>(x)) << 32) | static_cast<sf::Uint32>(y));
+}
@@ -1,6 +1,6 @@
 #include "SpriteNode.hpp"
 
-#include <SFML/Graphics/RenderTarget.hpp>
+#include "RenderQueue.hpp"
 
 SpriteNode::SpriteNode(const sf::Texture& texture):m_sprite(texture)
 {
@@ -10,7 +10,12 @@ SpriteNode::SpriteNode(const sf::Texture& texture, const sf::IntRect& textureRec
 {
 }
 
-void SpriteNode::DrawCurrent(sf::RenderTarget& target, sf::RenderStates states) const
+sf::FloatRect SpriteNode::GetDrawBounds() const
 {
-	target.draw(m_sprite, states);
+	return GetWorldTransform().transformRect(m_sprite.getGlobalBounds());
+}
+
+void SpriteNode::DrawCurrent(RenderQueue& queue, sf::RenderStates states) const
+{
+	queue.AddSprite(m_sprite, states);
 }
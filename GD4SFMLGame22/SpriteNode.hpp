@@ -7,9 +7,10 @@ class SpriteNode : public SceneNode
 public:
 	explicit SpriteNode(const sf::Texture& texture);
 	SpriteNode(const sf::Texture& texture, const sf::IntRect& textureRect);
+	virtual sf::FloatRect GetDrawBounds() const override;
 
 private:
-	virtual void DrawCurrent(sf::RenderTarget& target, sf::RenderStates states) const;
+	virtual void DrawCurrent(RenderQueue& queue, sf::RenderStates states) const;
 
 private:
 	sf::Sprite m_sprite;
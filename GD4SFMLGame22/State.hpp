@@ -18,6 +18,12 @@ namespace sf
 class StateStack;
 class Player;
 class KeyBinding;
+struct DemoSettings;
+struct DebugSettings;
+struct FrameTiming;
+class JobSystem;
+class QualityGovernor;
+class AssetLoader;
 
 class State
 {
@@ -26,7 +32,7 @@ public:
 
 	struct Context
 	{
-		Context(sf::RenderWindow& window, TextureHolder& textures, FontHolder& fonts, MusicPlayer& music, SoundPlayer& sounds, KeyBinding& keys1, KeyBinding& keys2);
+		Context(sf::RenderWindow& window, TextureHolder& textures, FontHolder& fonts, MusicPlayer& music, SoundPlayer& sounds, KeyBinding& keys1, KeyBinding& keys2, const DemoSettings& demo, const DebugSettings& debug, const FrameTiming& timing, JobSystem& jobs, const QualityGovernor& quality, const AssetLoader& assets);
 		sf::RenderWindow* window;
 		TextureHolder* textures;
 		FontHolder* fonts;
@@ -34,6 +40,12 @@ public:
 		SoundPlayer* sounds;
 		KeyBinding* keys1;
 		KeyBinding* keys2;
+		const DemoSettings* demo;
+		const DebugSettings* debug;
+		const FrameTiming* timing;
+		JobSystem* jobs;
+		const QualityGovernor* quality;
+		const AssetLoader* assets;
 	};
 
 public:
@@ -0,0 +1,17 @@
+#include "TargetRenderBackend.hpp"
+
+#include <SFML/Graphics/RenderTarget.hpp>
+
+TargetRenderBackend::TargetRenderBackend(sf::RenderTarget& target) : m_target(target)
+{
+}
+
+void TargetRenderBackend::DrawVertices(const sf::Vertex* vertices, std::size_t count, sf::PrimitiveType type, const sf::RenderStates& states)
+{
+	m_target.draw(vertices, count, type, states);
+}
+
+void TargetRenderBackend::DrawDrawable(const sf::Drawable& drawable, const sf::RenderStates& states)
+{
+	m_target.draw(drawable, states);
+}
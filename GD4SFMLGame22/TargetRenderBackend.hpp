@@ -0,0 +1,20 @@
+#pragma once
+#include "RenderBackend.hpp"
+
+namespace sf
+{
+	class RenderTarget;
+}
+
+//Draws straight to an SFML render target, the window or a render texture
+class TargetRenderBackend : public RenderBackend
+{
+public:
+	explicit TargetRenderBackend(sf::RenderTarget& target);
+	void DrawVertices(const sf::Vertex* vertices, std::size_t count, sf::PrimitiveType type, const sf::RenderStates& states) override;
+	void DrawDrawable(const sf::Drawable& drawable, const sf::RenderStates& states) override;
+
+private:
+	sf::RenderTarget& m_target;
+};
+
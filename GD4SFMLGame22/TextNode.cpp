@@ -1,22 +1,43 @@
 #include "TextNode.hpp"
 
-#include <SFML/Graphics/RenderTarget.hpp>
-
+#include "RenderQueue.hpp"
 #include "ResourceHolder.hpp"
 #include "Utility.hpp"
 
 TextNode::TextNode(const FontHolder& fonts, const std::string& text)
-	: m_text(text, fonts.Get(Fonts::Main), 20)
+	: m_string(text)
+	, m_text(text, fonts.Get(Fonts::Main), 20)
+	, m_needs_layout(false)
 {
 }
 
 void TextNode::SetString(const std::string& text)
 {
-	m_text.setString(text);
-	Utility::CentreOrigin(m_text);
+	if(text != m_string)
+	{
+		m_string = text;
+		m_needs_layout = true;
+	}
+}
+
+sf::FloatRect TextNode::GetDrawBounds() const
+{
+	ApplyLayout();
+	return GetWorldTransform().transformRect(m_text.getGlobalBounds());
+}
+
+void TextNode::DrawCurrent(RenderQueue& queue, sf::RenderStates states) const
+{
+	ApplyLayout();
+	queue.AddDrawable(m_text, states);
 }
 
-void TextNode::DrawCurrent(sf::RenderTarget& target, sf::RenderStates states) const
+void TextNode::ApplyLayout() const
 {
-	target.draw(m_text, states);
+	if(m_needs_layout)
+	{
+		m_text.setString(m_string);
+		Utility::CentreOrigin(m_text);
+		m_needs_layout = false;
+	}
 }
@@ -10,11 +10,17 @@ class TextNode : public SceneNode
 public:
 	explicit TextNode(const FontHolder& fonts, const std::string& text);
 	void SetString(const std::string& text);
+	virtual sf::FloatRect GetDrawBounds() const override;
 
 private:
-	virtual void DrawCurrent(sf::RenderTarget&, sf::RenderStates states) const override;
+	virtual void DrawCurrent(RenderQueue& queue, sf::RenderStates states) const override;
+	void ApplyLayout() const;
 
 private:
-	sf::Text m_text;
+	//Laying out text loads glyphs into the font's texture, which is only safe on the main thread. Updates may
+	//run elsewhere, so the new string is only applied when the node is drawn or its bounds are needed for that
+	std::string m_string;
+	mutable sf::Text m_text;
+	mutable bool m_needs_layout;
 };
 
@@ -0,0 +1,259 @@
+#include "TimerWheel.hpp"
+
+#include <algorithm>
+#include <utility>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace
+{
+	const sf::Uint32 NoNode = 0xFFFFFFFF;
+
+	std::size_t LowestBit(sf::Uint64 value)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward64(&index, value);
+		return index;
+#else
+		return static_cast<std::size_t>(__builtin_ctzll(value));
+#endif
+	}
+
+	std::size_t HighestBit(sf::Uint64 value)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanReverse64(&index, value);
+		return index;
+#else
+		return 63 - static_cast<std::size_t>(__builtin_clzll(value));
+#endif
+	}
+}
+
+//A node at level l, slot s has a tick that agrees with the current tick above level l and whose level l
+//digit is s, which is always greater than the current tick's level l digit. It comes due when the current
+//tick reaches that digit with all the lower digits zero
+
+TimerWheel::TimerWheel(sf::Time resolution)
+	: m_resolution(std::max<sf::Int64>(1, resolution.asMicroseconds()))
+	, m_current_tick(0)
+	, m_size(0)
+{
+	for (auto& level : m_slots)
+	{
+		level.fill(NoNode);
+	}
+	m_occupied_slots.fill(0);
+}
+
+TimerWheel::TimerId TimerWheel::Schedule(sf::Time deadline, Callback callback)
+{
+	sf::Uint32 index;
+	if (m_free_nodes.empty())
+	{
+		index = static_cast<sf::Uint32>(m_nodes.size());
+		m_nodes.emplace_back();
+		m_nodes.back().m_generation = 1;
+	}
+	else
+	{
+		index = m_free_nodes.back();
+		m_free_nodes.pop_back();
+	}
+
+	//Round up so a timer never fires early, and anything already due fires on the next step
+	sf::Int64 microseconds = std::max<sf::Int64>(0, deadline.asMicroseconds());
+	sf::Uint64 tick = static_cast<sf::Uint64>((microseconds + m_resolution - 1) / m_resolution);
+
+	Node& node = m_nodes[index];
+	node.m_callback = std::move(callback);
+	node.m_tick = std::max(tick, m_current_tick + 1);
+	node.m_active = true;
+	Place(index);
+	m_size++;
+
+	return (static_cast<TimerId>(node.m_generation) << 32) | index;
+}
+
+void TimerWheel::Cancel(TimerId timer)
+{
+	sf::Uint32 index = static_cast<sf::Uint32>(timer & 0xFFFFFFFF);
+	sf::Uint32 generation = static_cast<sf::Uint32>(timer >> 32);
+	if (index < m_nodes.size() && m_nodes[index].m_active && m_nodes[index].m_generation == generation)
+	{
+		Unlink(index);
+		Release(index);
+	}
+}
+
+void TimerWheel::Advance(sf::Time now)
+{
+	sf::Uint64 target = static_cast<sf::Uint64>(std::max<sf::Int64>(0, now.asMicroseconds()) / m_resolution);
+
+	//Jump straight from one occupied slot to the next instead of stepping through empty ones
+	sf::Uint64 next_tick;
+	while (GetNextEventTick(next_tick) && next_tick <= target)
+	{
+		m_current_tick = next_tick;
+
+		//Coarse slots starting at this tick are split up first, their timers may be due right now
+		for (std::size_t level = LevelCount - 1; level > 0; --level)
+		{
+			sf::Uint64 lower_digits = (static_cast<sf::Uint64>(1) << (level * SlotBits)) - 1;
+			std::size_t slot = static_cast<std::size_t>((m_current_tick >> (level * SlotBits)) & (SlotCount - 1));
+			if ((m_current_tick & lower_digits) == 0 && (m_occupied_slots[level] & (static_cast<sf::Uint64>(1) << slot)) != 0)
+			{
+				Cascade(level, slot);
+			}
+		}
+
+		Fire(static_cast<std::size_t>(m_current_tick & (SlotCount - 1)));
+	}
+
+	m_current_tick = std::max(m_current_tick, target);
+}
+
+bool TimerWheel::GetNextDeadline(sf::Time& deadline) const
+{
+	sf::Uint64 tick;
+	if (!GetNextEventTick(tick))
+	{
+		return false;
+	}
+
+	deadline = sf::microseconds(static_cast<sf::Int64>(tick) * m_resolution);
+	return true;
+}
+
+std::size_t TimerWheel::GetSize() const
+{
+	return m_size;
+}
+
+void TimerWheel::Place(sf::Uint32 index)
+{
+	Node& node = m_nodes[index];
+
+	//The highest digit in which the deadline differs from now picks the level
+	sf::Uint64 difference = node.m_tick ^ m_current_tick;
+	std::size_t level = difference == 0 ? 0 : HighestBit(difference) / SlotBits;
+	std::size_t slot = static_cast<std::size_t>((node.m_tick >> (level * SlotBits)) & (SlotCount - 1));
+
+	sf::Uint32& head = m_slots[level][slot];
+	node.m_level = static_cast<sf::Uint8>(level);
+	node.m_slot = static_cast<sf::Uint8>(slot);
+	node.m_previous = NoNode;
+	node.m_next = head;
+	if (head != NoNode)
+	{
+		m_nodes[head].m_previous = index;
+	}
+	head = index;
+	m_occupied_slots[level] |= static_cast<sf::Uint64>(1) << slot;
+}
+
+void TimerWheel::Unlink(sf::Uint32 index)
+{
+	Node& node = m_nodes[index];
+	sf::Uint32& head = m_slots[node.m_level][node.m_slot];
+
+	if (node.m_previous != NoNode)
+	{
+		m_nodes[node.m_previous].m_next = node.m_next;
+	}
+	else
+	{
+		head = node.m_next;
+	}
+
+	if (node.m_next != NoNode)
+	{
+		m_nodes[node.m_next].m_previous = node.m_previous;
+	}
+
+	if (head == NoNode)
+	{
+		m_occupied_slots[node.m_level] &= ~(static_cast<sf::Uint64>(1) << node.m_slot);
+	}
+}
+
+void TimerWheel::Release(sf::Uint32 index)
+{
+	Node& node = m_nodes[index];
+	node.m_callback = nullptr;
+	node.m_active = false;
+
+	//A new generation makes old identifiers for this node stale
+	node.m_generation++;
+	if (node.m_generation == 0)
+	{
+		node.m_generation = 1;
+	}
+
+	m_free_nodes.emplace_back(index);
+	m_size--;
+}
+
+void TimerWheel::Cascade(std::size_t level, std::size_t slot)
+{
+	sf::Uint32 index = m_slots[level][slot];
+	m_slots[level][slot] = NoNode;
+	m_occupied_slots[level] &= ~(static_cast<sf::Uint64>(1) << slot);
+
+	while (index != NoNode)
+	{
+		sf::Uint32 next = m_nodes[index].m_next;
+		Place(index);
+		index = next;
+	}
+}
+
+void TimerWheel::Fire(std::size_t slot)
+{
+	//Everything in the finest slot of the current tick is due. Callbacks can schedule new timers, but
+	//those always land in a later slot
+	while (m_slots[0][slot] != NoNode)
+	{
+		sf::Uint32 index = m_slots[0][slot];
+		Unlink(index);
+
+		//Take the callback out first, scheduling from inside it may reuse the node or grow m_nodes
+		Callback callback = std::move(m_nodes[index].m_callback);
+		Release(index);
+		callback();
+	}
+}
+
+bool TimerWheel::GetNextEventTick(sf::Uint64& tick) const
+{
+	if (m_size == 0)
+	{
+		return false;
+	}
+
+	bool found = false;
+	for (std::size_t level = 0; level < LevelCount; ++level)
+	{
+		if (m_occupied_slots[level] == 0)
+		{
+			continue;
+		}
+
+		//The earliest occupied slot comes due when the current tick reaches its digit with the lower digits zero
+		std::size_t shift = level * SlotBits;
+		std::size_t upper_shift = shift + SlotBits;
+		sf::Uint64 upper_digits = upper_shift >= 64 ? 0 : (m_current_tick >> upper_shift) << upper_shift;
+		sf::Uint64 level_tick = upper_digits | (static_cast<sf::Uint64>(LowestBit(m_occupied_slots[level])) << shift);
+
+		if (!found || level_tick < tick)
+		{
+			tick = level_tick;
+			found = true;
+		}
+	}
+	return found;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <SFML/Config.hpp>
+#include <SFML/System/NonCopyable.hpp>
+#include <SFML/System/Time.hpp>
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+//Hierarchical timer wheel. Level 0 has one slot per resolution step, every level above is 64 times
+//coarser, and a timer only moves down when the slot it sits in comes due. Scheduling, cancelling and
+//firing are O(1) and a timer is moved at most once per level. Timers are pooled nodes linked by index
+//so a warmed up wheel does not allocate
+
+class TimerWheel : private sf::NonCopyable
+{
+public:
+	typedef std::function<void()> Callback;
+	typedef sf::Uint64 TimerId;
+	static const TimerId InvalidTimer = 0;
+
+public:
+	explicit TimerWheel(sf::Time resolution);
+
+	TimerId Schedule(sf::Time deadline, Callback callback);
+	//Cancelling a timer that already fired or was cancelled does nothing
+	void Cancel(TimerId timer);
+
+	//Runs every timer that is due by now, in deadline order. Callbacks may schedule and cancel timers
+	void Advance(sf::Time now);
+
+	//The next time Advance has work to do: the earliest deadline, or earlier when a coarse slot has to be
+	//split up first. False when there are no timers
+	bool GetNextDeadline(sf::Time& deadline) const;
+	std::size_t GetSize() const;
+
+private:
+	enum
+	{
+		SlotBits = 6,
+		SlotCount = 1 << SlotBits,
+		//Enough levels to cover every 64 bit tick, so no deadline is ever too far away
+		LevelCount = (64 + SlotBits - 1) / SlotBits
+	};
+
+	struct Node
+	{
+		Callback m_callback;
+		sf::Uint64 m_tick;
+		sf::Uint32 m_generation;
+		sf::Uint32 m_previous;
+		sf::Uint32 m_next;
+		sf::Uint8 m_level;
+		sf::Uint8 m_slot;
+		bool m_active;
+	};
+
+private:
+	void Place(sf::Uint32 index);
+	void Unlink(sf::Uint32 index);
+	void Release(sf::Uint32 index);
+	void Cascade(std::size_t level, std::size_t slot);
+	void Fire(std::size_t slot);
+	bool GetNextEventTick(sf::Uint64& tick) const;
+
+private:
+	sf::Int64 m_resolution;
+	sf::Uint64 m_current_tick;
+	std::vector<Node> m_nodes;
+	std::vector<sf::Uint32> m_free_nodes;
+	std::array<std::array<sf::Uint32, SlotCount>, LevelCount> m_slots;
+	std::array<sf::Uint64, LevelCount> m_occupied_slots;
+	std::size_t m_size;
+};
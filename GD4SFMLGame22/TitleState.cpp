@@ -4,18 +4,21 @@
 #include <SFML/Graphics/RenderWindow.hpp>
 #include <SFML/System/Sleep.hpp>
 
+#include "AssetLoader.hpp"
 #include "ResourceHolder.hpp"
 
+#include <string>
+
 TitleState::TitleState(StateStack& stack, Context context)
 : State(stack, context)
+, m_loaded(false)
 , m_show_text(true)
 , m_text_effect_time(sf::Time::Zero)
 {
 	m_background_sprite.setTexture(context.textures->Get(Textures::kTitleScreen));
 	m_text.setFont(context.fonts->Get(Fonts::Main));
-	m_text.setString("Press any key to continue");
-	Utility::CentreOrigin(m_text);
 	m_text.setPosition(context.window->getView().getSize() / 2.f);
+	Update(sf::Time::Zero);
 }
 
 void TitleState::Draw()
@@ -31,6 +34,16 @@ void TitleState::Draw()
 
 bool TitleState::Update(sf::Time dt)
 {
+	if(!m_loaded)
+	{
+		const AssetLoader& assets = *GetContext().assets;
+		m_loaded = assets.IsDone();
+		SetText(m_loaded ? "Press any key to continue" : "Loading " + std::to_string(static_cast<int>(assets.GetProgress() * 100.f)) + "%");
+		m_show_text = true;
+		m_text_effect_time = sf::Time::Zero;
+		return true;
+	}
+
 	m_text_effect_time += dt;
 
 	if(m_text_effect_time >= sf::seconds(0.5))
@@ -43,10 +56,19 @@ bool TitleState::Update(sf::Time dt)
 
 bool TitleState::HandleEvent(const sf::Event& event)
 {
-	if(event.type == sf::Event::KeyReleased)
+	if(event.type == sf::Event::KeyReleased && m_loaded)
 	{
 		RequestStackPop();
 		RequestStackPush(StateID::kMenu);
 	}
 	return true;
 }
+
+void TitleState::SetText(const std::string& text)
+{
+	if(m_text.getString().toAnsiString() != text)
+	{
+		m_text.setString(text);
+		Utility::CentreOrigin(m_text);
+	}
+}
@@ -12,10 +12,15 @@ public:
 	virtual bool Update(sf::Time dt);
 	virtual bool HandleEvent(const sf::Event& event);
 
+private:
+	void SetText(const std::string& text);
+
 private:
 	sf::Sprite m_background_sprite;
 	sf::Text m_text;
 
+	//The game can only be entered once the assets are loaded, until then the progress is shown
+	bool m_loaded;
 	bool m_show_text;
 	sf::Time m_text_effect_time;
 };
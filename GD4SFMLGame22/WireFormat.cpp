@@ -0,0 +1,124 @@
+#include "WireFormat.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	const sf::Uint32 QuantizedRange = 0xFFFF;
+}
+
+namespace Wire
+{
+	sf::Uint16 Quantize(float value, float min, float max)
+	{
+		float clamped = std::max(min, std::min(max, value));
+		return static_cast<sf::Uint16>(std::lround((clamped - min) / (max - min) * QuantizedRange));
+	}
+
+	float Dequantize(sf::Uint16 value, float min, float max)
+	{
+		return min + static_cast<float>(value) / QuantizedRange * (max - min);
+	}
+
+	Writer::Writer(std::vector<char>& buffer)
+		: m_buffer(&buffer)
+		, m_start(buffer.size())
+	{
+	}
+
+	void Writer::append(const void* data, std::size_t size)
+	{
+		m_buffer->insert(m_buffer->end(), static_cast<const char*>(data), static_cast<const char*>(data) + size);
+	}
+
+	Writer& Writer::operator<<(sf::Uint8 value)
+	{
+		m_buffer->push_back(static_cast<char>(value));
+		return *this;
+	}
+
+	//Big endian, as sf::Packet writes it
+	Writer& Writer::operator<<(sf::Uint16 value)
+	{
+		m_buffer->push_back(static_cast<char>(value >> 8));
+		m_buffer->push_back(static_cast<char>(value & 0xFF));
+		return *this;
+	}
+
+	const char* Writer::GetData() const
+	{
+		return m_buffer->data() + m_start;
+	}
+
+	std::size_t Writer::GetSize() const
+	{
+		return m_buffer->size() - m_start;
+	}
+
+	Reader::Reader()
+		: m_data(nullptr)
+		, m_size(0)
+		, m_read(0)
+		, m_valid(false)
+	{
+	}
+
+	Reader::Reader(const char* data, std::size_t size)
+		: m_data(data)
+		, m_size(size)
+		, m_read(0)
+		, m_valid(true)
+	{
+	}
+
+	Reader& Reader::operator>>(sf::Int8& value)
+	{
+		if (CheckSize(1))
+		{
+			value = static_cast<sf::Int8>(m_data[m_read++]);
+		}
+		return *this;
+	}
+
+	Reader& Reader::operator>>(sf::Uint8& value)
+	{
+		if (CheckSize(1))
+		{
+			value = static_cast<sf::Uint8>(m_data[m_read++]);
+		}
+		return *this;
+	}
+
+	Reader& Reader::operator>>(sf::Uint16& value)
+	{
+		if (CheckSize(2))
+		{
+			const unsigned char* bytes = reinterpret_cast<const unsigned char*>(m_data + m_read);
+			value = static_cast<sf::Uint16>((bytes[0] << 8) | bytes[1]);
+			m_read += 2;
+		}
+		return *this;
+	}
+
+	Reader::operator bool() const
+	{
+		return m_valid;
+	}
+
+	const char* Reader::GetRemainingData() const
+	{
+		return m_data + m_read;
+	}
+
+	std::size_t Reader::GetRemainingSize() const
+	{
+		return m_valid ? m_size - m_read : 0;
+	}
+
+	bool Reader::CheckSize(std::size_t size)
+	{
+		m_valid = m_valid && m_read + size <= m_size;
+		return m_valid;
+	}
+}
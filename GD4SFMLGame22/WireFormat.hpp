@@ -0,0 +1,176 @@
+#pragma once
+#include <SFML/Config.hpp>
+#include <SFML/Network/Packet.hpp>
+#include <SFML/System/Vector2.hpp>
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+//Compact encodings for the fields of the messages in NetworkProtocol.hpp. Each helper wraps a
+//variable so the same expression is used to write (packet << ...) and to read (packet >> ...) it:
+//	Tag			- the message type in a single byte
+//	VarInt		- 1 to 5 bytes, identifiers, hitpoints, ammo and counts take one or two
+//	CoordinateX/Y, Position - 16 bit fixed point inside the protocol's world bounds
+//	Flags		- up to 8 booleans packed into one byte
+//	Text		- a string with a varint length
+//The fields can be written to an sf::Packet or to a Writer, which appends to a buffer that is reused
+//between messages, and read from an sf::Packet or a Reader, which reads a received frame in place
+
+namespace Wire
+{
+	//Every coordinate that goes over the network lies in here - the whole level plus the band above it where
+	//enemies are spawned. Values outside are clamped. The resolution is about 0.05 units on x and 0.11 on y
+	const float MinX = -1024.f;
+	const float MaxX = 2048.f;
+	const float MinY = -1024.f;
+	const float MaxY = 6144.f;
+
+	template <typename T>
+	struct TagField
+	{
+		T& m_value;
+	};
+
+	template <typename T>
+	struct VarIntField
+	{
+		T& m_value;
+	};
+
+	template <typename T>
+	struct CoordinateField
+	{
+		T& m_value;
+		float m_min;
+		float m_max;
+	};
+
+	template <typename T>
+	struct PositionField
+	{
+		T& m_value;
+	};
+
+	template <typename T, std::size_t N>
+	struct FlagsField
+	{
+		std::array<T*, N> m_values;
+	};
+
+	template <typename T>
+	struct TextField
+	{
+		T& m_value;
+	};
+
+	//Temporaries may be written, they live until the end of the packet expression
+	template <typename T>
+	TagField<typename std::remove_reference<T>::type> Tag(T&& value);
+
+	template <typename T>
+	VarIntField<typename std::remove_reference<T>::type> VarInt(T&& value);
+
+	template <typename T>
+	CoordinateField<typename std::remove_reference<T>::type> CoordinateX(T&& value);
+
+	template <typename T>
+	CoordinateField<typename std::remove_reference<T>::type> CoordinateY(T&& value);
+
+	template <typename T>
+	PositionField<typename std::remove_reference<T>::type> Position(T&& value);
+
+	template <typename T, typename... Rest>
+	FlagsField<T, 1 + sizeof...(Rest)> Flags(T& first, Rest&... rest);
+
+	template <typename T>
+	TextField<typename std::remove_reference<T>::type> Text(T&& value);
+
+	//Same interface as sf::Packet as far as the fields are concerned. The buffer keeps its capacity
+	//between messages so once it has grown writing does not allocate
+	class Writer
+	{
+	public:
+		explicit Writer(std::vector<char>& buffer);
+
+		void append(const void* data, std::size_t size);
+		Writer& operator<<(sf::Uint8 value);
+		Writer& operator<<(sf::Uint16 value);
+
+		//Everything written since the writer was created
+		const char* GetData() const;
+		std::size_t GetSize() const;
+
+	private:
+		std::vector<char>* m_buffer;
+		std::size_t m_start;
+	};
+
+	//Reads from memory owned by someone else, e.g. a frame inside PacketTransport's receive buffer
+	class Reader
+	{
+	public:
+		Reader();
+		Reader(const char* data, std::size_t size);
+
+		Reader& operator>>(sf::Int8& value);
+		Reader& operator>>(sf::Uint8& value);
+		Reader& operator>>(sf::Uint16& value);
+		//False once a read went past the end, like sf::Packet
+		explicit operator bool() const;
+
+		//What has not been read yet, e.g. a message that is passed on as it is
+		const char* GetRemainingData() const;
+		std::size_t GetRemainingSize() const;
+
+	private:
+		bool CheckSize(std::size_t size);
+
+	private:
+		const char* m_data;
+		std::size_t m_size;
+		std::size_t m_read;
+		bool m_valid;
+	};
+
+	template <typename Stream>
+	void WriteVarUint(Stream& stream, sf::Uint32 value);
+	template <typename Stream>
+	bool ReadVarUint(Stream& stream, sf::Uint32& value);
+	sf::Uint16 Quantize(float value, float min, float max);
+	float Dequantize(sf::Uint16 value, float min, float max);
+
+	template <typename Stream, typename T>
+	Stream& operator<<(Stream& stream, const TagField<T>& field);
+	template <typename Stream, typename T>
+	Stream& operator>>(Stream& stream, const TagField<T>& field);
+
+	template <typename Stream, typename T>
+	Stream& operator<<(Stream& stream, const VarIntField<T>& field);
+	template <typename Stream, typename T>
+	Stream& operator>>(Stream& stream, const VarIntField<T>& field);
+
+	template <typename Stream, typename T>
+	Stream& operator<<(Stream& stream, const CoordinateField<T>& field);
+	template <typename Stream, typename T>
+	Stream& operator>>(Stream& stream, const CoordinateField<T>& field);
+
+	template <typename Stream, typename T>
+	Stream& operator<<(Stream& stream, const PositionField<T>& field);
+	template <typename Stream, typename T>
+	Stream& operator>>(Stream& stream, const PositionField<T>& field);
+
+	template <typename Stream, typename T, std::size_t N>
+	Stream& operator<<(Stream& stream, const FlagsField<T, N>& field);
+	template <typename Stream, typename T, std::size_t N>
+	Stream& operator>>(Stream& stream, const FlagsField<T, N>& field);
+
+	template <typename Stream, typename T>
+	Stream& operator<<(Stream& stream, const TextField<T>& field);
+	template <typename Stream, typename T>
+	Stream& operator>>(Stream& stream, const TextField<T>& field);
+}
+
+#include "WireFormat.inl"
@@ -0,0 +1,195 @@
+namespace Wire
+{
+	//7 bits per byte, lowest first, the top bit says another byte follows
+	template <typename Stream>
+	void WriteVarUint(Stream& stream, sf::Uint32 value)
+	{
+		while (value >= 0x80)
+		{
+			stream << static_cast<sf::Uint8>((value & 0x7F) | 0x80);
+			value >>= 7;
+		}
+		stream << static_cast<sf::Uint8>(value);
+	}
+
+	template <typename Stream>
+	bool ReadVarUint(Stream& stream, sf::Uint32& value)
+	{
+		//A 32 bit value never needs more than 5 bytes
+		value = 0;
+		sf::Uint8 byte;
+		for (std::size_t i = 0; i < 5 && stream >> byte; ++i)
+		{
+			value |= static_cast<sf::Uint32>(byte & 0x7F) << (7 * i);
+			if ((byte & 0x80) == 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	template <typename T>
+	TagField<typename std::remove_reference<T>::type> Tag(T&& value)
+	{
+		return { value };
+	}
+
+	template <typename T>
+	VarIntField<typename std::remove_reference<T>::type> VarInt(T&& value)
+	{
+		return { value };
+	}
+
+	template <typename T>
+	CoordinateField<typename std::remove_reference<T>::type> CoordinateX(T&& value)
+	{
+		return { value, MinX, MaxX };
+	}
+
+	template <typename T>
+	CoordinateField<typename std::remove_reference<T>::type> CoordinateY(T&& value)
+	{
+		return { value, MinY, MaxY };
+	}
+
+	template <typename T>
+	PositionField<typename std::remove_reference<T>::type> Position(T&& value)
+	{
+		return { value };
+	}
+
+	template <typename T, typename... Rest>
+	FlagsField<T, 1 + sizeof...(Rest)> Flags(T& first, Rest&... rest)
+	{
+		static_assert(1 + sizeof...(Rest) <= 8, "Flags packs at most 8 booleans into its byte");
+		return { { { &first, &rest... } } };
+	}
+
+	template <typename T>
+	TextField<typename std::remove_reference<T>::type> Text(T&& value)
+	{
+		return { value };
+	}
+
+	template <typename Stream, typename T>
+	Stream& operator<<(Stream& stream, const TagField<T>& field)
+	{
+		return stream << static_cast<sf::Uint8>(field.m_value);
+	}
+
+	template <typename Stream, typename T>
+	Stream& operator>>(Stream& stream, const TagField<T>& field)
+	{
+		sf::Uint8 tag;
+		if (stream >> tag)
+		{
+			field.m_value = static_cast<T>(tag);
+		}
+		return stream;
+	}
+
+	template <typename Stream, typename T>
+	Stream& operator<<(Stream& stream, const VarIntField<T>& field)
+	{
+		//Zigzag encode so that small negative values are small too. Every integer is treated as signed
+		//so that the two ends do not have to agree on the C++ type of a field
+		sf::Int32 value = static_cast<sf::Int32>(field.m_value);
+		sf::Uint32 sign = value < 0 ? 0xFFFFFFFFu : 0u;
+		WriteVarUint(stream, (static_cast<sf::Uint32>(value) << 1) ^ sign);
+		return stream;
+	}
+
+	template <typename Stream, typename T>
+	Stream& operator>>(Stream& stream, const VarIntField<T>& field)
+	{
+		sf::Uint32 encoded;
+		if (ReadVarUint(stream, encoded))
+		{
+			sf::Int32 magnitude = static_cast<sf::Int32>(encoded >> 1);
+			field.m_value = static_cast<T>((encoded & 1) ? -magnitude - 1 : magnitude);
+		}
+		return stream;
+	}
+
+	template <typename Stream, typename T>
+	Stream& operator<<(Stream& stream, const CoordinateField<T>& field)
+	{
+		return stream << Quantize(static_cast<float>(field.m_value), field.m_min, field.m_max);
+	}
+
+	template <typename Stream, typename T>
+	Stream& operator>>(Stream& stream, const CoordinateField<T>& field)
+	{
+		sf::Uint16 quantized;
+		if (stream >> quantized)
+		{
+			field.m_value = static_cast<T>(Dequantize(quantized, field.m_min, field.m_max));
+		}
+		return stream;
+	}
+
+	template <typename Stream, typename T>
+	Stream& operator<<(Stream& stream, const PositionField<T>& field)
+	{
+		return stream << CoordinateX(field.m_value.x) << CoordinateY(field.m_value.y);
+	}
+
+	template <typename Stream, typename T>
+	Stream& operator>>(Stream& stream, const PositionField<T>& field)
+	{
+		return stream >> CoordinateX(field.m_value.x) >> CoordinateY(field.m_value.y);
+	}
+
+	template <typename Stream, typename T, std::size_t N>
+	Stream& operator<<(Stream& stream, const FlagsField<T, N>& field)
+	{
+		sf::Uint8 bits = 0;
+		for (std::size_t i = 0; i < N; ++i)
+		{
+			if (*field.m_values[i])
+			{
+				bits |= static_cast<sf::Uint8>(1u << i);
+			}
+		}
+		return stream << bits;
+	}
+
+	template <typename Stream, typename T, std::size_t N>
+	Stream& operator>>(Stream& stream, const FlagsField<T, N>& field)
+	{
+		sf::Uint8 bits;
+		if (stream >> bits)
+		{
+			for (std::size_t i = 0; i < N; ++i)
+			{
+				*field.m_values[i] = (bits & (1u << i)) != 0;
+			}
+		}
+		return stream;
+	}
+
+	template <typename Stream, typename T>
+	Stream& operator<<(Stream& stream, const TextField<T>& field)
+	{
+		WriteVarUint(stream, static_cast<sf::Uint32>(field.m_value.size()));
+		stream.append(field.m_value.data(), field.m_value.size());
+		return stream;
+	}
+
+	template <typename Stream, typename T>
+	Stream& operator>>(Stream& stream, const TextField<T>& field)
+	{
+		sf::Uint32 length;
+		if (ReadVarUint(stream, length))
+		{
+			field.m_value.clear();
+			sf::Int8 character;
+			for (sf::Uint32 i = 0; i < length && stream >> character; ++i)
+			{
+				field.m_value.push_back(static_cast<char>(character));
+			}
+		}
+		return stream;
+	}
+}
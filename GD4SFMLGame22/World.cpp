@@ -2,20 +2,36 @@
 
 #include <SFML/Graphics/RenderWindow.hpp>
 #include <iostream>
-#include <limits>
+#include <string>
 
+#include "AssetLoader.hpp"
 #include "ParticleNode.hpp"
 #include "ParticleType.hpp"
 #include "Pickup.hpp"
 #include "PostEffect.hpp"
 #include "Projectile.hpp"
 #include "SoundNode.hpp"
+#include "TargetRenderBackend.hpp"
 #include "Utility.hpp"
 
-World::World(sf::RenderTarget& output_target, FontHolder& font, SoundPlayer& sounds, bool networked)
+namespace
+{
+	const sf::Time UpdateReportInterval = sf::seconds(10.f);
+	const float EnemyCellSize = 256.f;
+	//More collision jobs than threads, so a thread that finishes early has something to take
+	const std::size_t CollisionJobsPerThread = 4;
+	//Live particles of all particle nodes together, see ParticleBudget
+	const std::size_t MaxParticles = 5000;
+
+	const char* const UpdatePhaseNames[] = { "commands", "colliders", "narrow phase", "particles", "sounds", "parallel phase", "simulation" };
+}
+
+World::World(sf::RenderTarget& output_target, FontHolder& font, SoundPlayer& sounds, const FrameTiming& timing, JobSystem& jobs, const QualityGovernor& quality, TextureHolder& textures, bool networked)
 	: m_target(output_target)
 	, m_camera(output_target.getDefaultView())
-	, m_textures()
+	, m_timing(timing)
+	, m_updated_step(timing.m_step)
+	, m_textures(textures)
 	, m_fonts(font)
 	, m_sounds(sounds)
 	, m_scenegraph()
@@ -26,16 +42,27 @@ World::World(sf::RenderTarget& output_target, FontHolder& font, SoundPlayer& sou
 	, m_scrollspeed_compensation(1.f)
 	, m_player_aircraft()
 	, m_enemy_spawn_points()
-	, m_active_enemies()
+	, m_enemy_grid(EnemyCellSize)
+	, m_cpu_bloom_effect(jobs)
 	, m_networked_world(networked)
 	, m_network_node(nullptr)
 	, m_finish_sprite(nullptr)
+	, m_jobs(jobs)
+	, m_particle_budget(MaxParticles)
+	, m_updates_since_report(0)
+	, m_frames_since_report(0)
+	, m_report_statistics(false)
+	, m_draw_bounds_step(0)
+	, m_has_draw_bounds(false)
+	, m_quality(quality)
+	, m_quality_tier(quality.GetTier())
 {
-	m_scene_texture.create(m_target.getSize().x, m_target.getSize().y);
-
-	LoadTextures();
+	sf::Clock build_clock;
 	BuildScene();
+	ApplyQuality();
 	m_camera.setCenter(m_spawn_position);
+	m_previous_camera_center = m_spawn_position;
+	m_build_time = build_clock.getElapsedTime();
 }
 
 void World::SetWorldScrollCompensation(float compensation)
@@ -45,6 +72,11 @@ void World::SetWorldScrollCompensation(float compensation)
 
 void World::Update(sf::Time dt)
 {
+	m_updated_step = m_timing.m_step;
+	m_previous_camera_center = m_camera.getCenter();
+	m_scenegraph.StorePreviousPosition();
+	sf::Clock phase_clock;
+
 	//Scroll the world
 	m_camera.move(0, m_scrollspeed * dt.asSeconds()*m_scrollspeed_compensation);
 
@@ -62,6 +94,10 @@ void World::Update(sf::Time dt)
 		m_scenegraph.OnCommand(m_command_queue.Pop(), dt);
 	}
 	AdaptPlayerVelocity();
+	m_update_times[kCommandPhase] += phase_clock.restart();
+
+	RunParallelPhase(dt);
+	m_update_times[kParallelPhase] += phase_clock.restart();
 
 	HandleCollisions();
 	//Remove all destroyed entities
@@ -74,26 +110,278 @@ void World::Update(sf::Time dt)
 
 	//Apply movement
 	m_scenegraph.Update(dt, m_command_queue);
+	AddEmittedParticles();
 	AdaptPlayerPosition();
+	m_update_times[kSimulationPhase] += phase_clock.restart();
+
+	m_updates_since_report++;
+	if(m_report_clock.getElapsedTime() >= UpdateReportInterval)
+	{
+		ReportStatistics();
+	}
+}
+
+//Between the commands and the scene graph update nothing moves, so the collision tests, the particles and
+//the sounds can be worked on side by side. Each job only writes to its own part of the world
+
+void World::RunParallelPhase(sf::Time dt)
+{
+	//Worked out here because the collider job below is the only one allowed to touch the scene nodes
+	sf::Vector2f listener_position = GetListenerPosition();
+
+	std::size_t chunk_count = m_jobs.GetThreadCount() * CollisionJobsPerThread;
+	m_collision_chunks.resize(chunk_count);
+
+	JobSystem::JobId colliders = m_jobs.AddJob([this]
+	{
+		m_colliders.clear();
+		m_scenegraph.GatherColliders(m_colliders);
+	});
+
+	std::vector<JobSystem::JobId> narrow_phase;
+	for(std::size_t chunk = 0; chunk < chunk_count; ++chunk)
+	{
+		narrow_phase.emplace_back(m_jobs.AddJob([this, chunk, chunk_count] { FindCollisions(chunk, chunk_count); }, { colliders }));
+	}
+	JobSystem::JobId merge = m_jobs.AddJob([this] { MergeCollisions(); }, narrow_phase);
+
+	std::vector<JobSystem::JobId> particles;
+	for(ParticleNode* node : m_particle_registry.GetNodes())
+	{
+		particles.emplace_back(m_jobs.AddJob([node, dt] { node->UpdateParticles(dt); }));
+	}
+
+	JobSystem::JobId sounds = m_jobs.AddJob([this, listener_position]
+	{
+		m_sounds.SetListenerPosition(listener_position);
+	});
+
+	m_jobs.Run();
+
+	m_update_times[kColliderPhase] += m_jobs.GetJobTime(colliders);
+	for(JobSystem::JobId job : narrow_phase)
+	{
+		m_update_times[kNarrowPhase] += m_jobs.GetJobTime(job);
+	}
+	m_update_times[kNarrowPhase] += m_jobs.GetJobTime(merge);
+	for(JobSystem::JobId job : particles)
+	{
+		m_update_times[kParticlePhase] += m_jobs.GetJobTime(job);
+	}
+	m_update_times[kSoundPhase] += m_jobs.GetJobTime(sounds);
+	m_jobs.Clear();
+}
+
+//The emitters buffered their particles while the scene graph was updated, they are taken out of the budget here
+//in scene graph order, the same order a serial update would have emitted them in
+void World::AddEmittedParticles()
+{
+	std::size_t live_particles = 0;
+	for(ParticleNode* node : m_particle_registry.GetNodes())
+	{
+		live_particles += node->GetParticleCount();
+	}
+	m_particle_budget.BeginStep(live_particles, GetViewBounds());
+
+	m_scenegraph.AddEmittedParticles();
+}
+
+void World::FindCollisions(std::size_t chunk, std::size_t chunk_count)
+{
+	//Rows further down have fewer pairs left to test, so every chunk takes every chunk_count'th row
+	std::vector<SceneNode::Pair>& pairs = m_collision_chunks[chunk];
+	pairs.clear();
+	for(std::size_t i = chunk; i < m_colliders.size(); i += chunk_count)
+	{
+		for(std::size_t j = i + 1; j < m_colliders.size(); ++j)
+		{
+			if(m_colliders[i].m_bounds.intersects(m_colliders[j].m_bounds))
+			{
+				pairs.emplace_back(std::minmax(m_colliders[i].m_node, m_colliders[j].m_node));
+			}
+		}
+	}
+}
+
+void World::MergeCollisions()
+{
+	m_collision_pairs.clear();
+	for(const std::vector<SceneNode::Pair>& pairs : m_collision_chunks)
+	{
+		m_collision_pairs.insert(pairs.begin(), pairs.end());
+	}
+}
+
+void World::ReportStatistics()
+{
+	if(m_report_statistics)
+	{
+		std::cout << "World update on " << m_jobs.GetThreadCount() << " threads, per step:";
+		for(std::size_t phase = 0; phase < kUpdatePhaseCount; ++phase)
+		{
+			std::cout << (phase == 0 ? " " : ", ") << UpdatePhaseNames[phase] << " " << m_update_times[phase].asMicroseconds() / m_updates_since_report << "us";
+		}
+		std::cout << std::endl;
+
+		const ParticleBudget::Counters& particles = m_particle_budget.GetCounters();
+		std::cout << "World particles: " << m_particle_budget.GetLiveCount() << " of " << m_particle_budget.GetMaxCount() << " live, per step "
+			<< particles.m_emitted / m_updates_since_report << " emitted, " << particles.m_dropped / m_updates_since_report << " dropped" << std::endl;
 
-	UpdateSounds();
+		const SoundPlayer::Counters& sounds = m_sounds.GetCounters();
+		std::cout << "World sounds: " << m_sounds.GetActiveVoiceCount() << " of " << m_sounds.GetVoiceCount() << " voices active, since the last report "
+			<< sounds.m_played << " played, " << sounds.m_stolen << " stolen voices, " << sounds.m_culled << " culled, " << sounds.m_rejected << " rejected, " << sounds.m_coalesced << " merged into another" << std::endl;
+
+		if(m_frames_since_report > 0)
+		{
+			std::cout << "World drawing per frame: " << m_draw_counters.m_visited / m_frames_since_report << " nodes visited, "
+				<< m_draw_counters.m_culled / m_frames_since_report << " subtrees culled, "
+				<< m_draw_counters.m_drawn / m_frames_since_report << " nodes drawn, "
+				<< m_render_counters.m_sprites / m_frames_since_report << " of " << m_render_counters.m_items / m_frames_since_report << " items batched as sprites" << std::endl;
+			std::cout << "World render commands per frame: " << m_render_stats.m_draw_calls / m_frames_since_report << " draw calls, "
+				<< m_render_stats.m_vertices / m_frames_since_report << " vertices, "
+				<< m_render_stats.m_texture_binds / m_frames_since_report << " texture binds, "
+				<< m_render_stats.m_state_changes / m_frames_since_report << " state changes" << std::endl;
+			std::cout << "World bloom per frame: " << m_bloom_time.asMicroseconds() / m_frames_since_report << "us "
+				<< (!UsesBloom() ? "off" : PostEffect::IsSupported() ? "with shaders" : (BloomKernels::UsesSimd() ? "on the CPU with SSE" : "on the CPU")) << std::endl;
+		}
+	}
+
+	//The counters are reset either way so they always cover the last interval
+	m_update_times.fill(sf::Time::Zero);
+	m_particle_budget.ResetCounters();
+	m_sounds.ResetCounters();
+	m_updates_since_report = 0;
+	m_frames_since_report = 0;
+	m_draw_counters = SceneNode::DrawCounters();
+	m_render_counters = RenderQueue::Counters();
+	m_render_stats = RecordingRenderBackend::FrameStats();
+	m_bloom_time = sf::Time::Zero;
+	m_report_clock.restart();
 }
 
 void World::Draw()
 {
-	if(PostEffect::IsSupported())
+	if(m_quality_tier != m_quality.GetTier())
+	{
+		m_quality_tier = m_quality.GetTier();
+		ApplyQuality();
+	}
+
+	float interpolation = m_updated_step == m_timing.m_step ? m_timing.m_interpolation : 1.f;
+	m_scenegraph.Interpolate(interpolation);
+
+	//Nodes only move when the world steps, including the changes the network makes between updates
+	bool first_frame_of_step = !m_has_draw_bounds || m_draw_bounds_step != m_timing.m_step;
+	if(first_frame_of_step)
+	{
+		m_scenegraph.UpdateDrawBounds();
+		m_draw_bounds_step = m_timing.m_step;
+		m_has_draw_bounds = true;
+	}
+
+	sf::View camera = m_camera;
+	camera.setCenter(m_previous_camera_center + (m_camera.getCenter() - m_previous_camera_center) * interpolation);
+	sf::FloatRect view_bounds(camera.getCenter() - camera.getSize() / 2.f, camera.getSize());
+
+	//The queue draws in the order things are added, so the layers go in back to front
+	for(std::size_t layer = 0; layer < m_scene_layers.size(); ++layer)
+	{
+		m_scene_layers[layer]->DrawVisible(m_render_queue, sf::RenderStates::Default, view_bounds, m_draw_counters);
+	}
+
+	//Every draw call goes through the recorder on its way to the target, which is what the stats are taken from
+	m_render_recorder.BeginFrame();
+	bool bloom = UsesBloom();
+	if(!bloom && m_scene_texture.getSize() == m_target.getSize())
+	{
+		//Nothing to do to the frame afterwards, so it goes straight to the target
+		m_target.setView(camera);
+		TargetRenderBackend output(m_target);
+		m_render_recorder.SetOutput(&output);
+		m_render_queue.Flush(m_render_recorder, m_render_counters);
+		m_render_recorder.SetOutput(nullptr);
+	}
+	else
 	{
 		m_scene_texture.clear();
-		m_scene_texture.setView(m_camera);
-		m_scene_texture.draw(m_scenegraph);
+		m_scene_texture.setView(camera);
+		TargetRenderBackend output(m_scene_texture);
+		m_render_recorder.SetOutput(&output);
+		m_render_queue.Flush(m_render_recorder, m_render_counters);
+		m_render_recorder.SetOutput(nullptr);
 		m_scene_texture.display();
-		m_bloom_effect.Apply(m_scene_texture, m_target);
+
+		sf::Clock bloom_clock;
+		if(!bloom)
+		{
+			//Drawn at a lower resolution, see QualitySettings::m_render_scale
+			sf::Sprite sprite(m_scene_texture.getTexture());
+			sprite.setScale(static_cast<float>(m_target.getSize().x) / m_scene_texture.getSize().x, static_cast<float>(m_target.getSize().y) / m_scene_texture.getSize().y);
+			m_target.setView(m_target.getDefaultView());
+			m_target.draw(sprite, sf::BlendNone);
+		}
+		else if(PostEffect::IsSupported())
+		{
+			m_bloom_effect.Apply(m_scene_texture, m_target);
+		}
+		else
+		{
+			m_cpu_bloom_effect.Apply(m_scene_texture, m_target);
+		}
+		m_bloom_time += bloom_clock.getElapsedTime();
 	}
-	else
+	m_render_stats.Add(m_render_recorder.GetFrameStats());
+
+	//Frames in between steps only differ in where things are, so one per step is enough to compare runs
+	if(m_render_log.is_open() && first_frame_of_step)
 	{
-		m_target.setView(m_camera);
-		m_target.draw(m_scenegraph);
+		m_render_log << "step " << m_timing.m_step << "\n";
+		m_render_recorder.WriteFrame(m_render_log);
 	}
+	m_frames_since_report++;
+}
+
+void World::ApplyQuality()
+{
+	const QualitySettings& settings = m_quality.GetSettings();
+	m_bloom_effect.SetQuality(settings.m_bloom_downsamples, settings.m_blur_iterations);
+	m_cpu_bloom_effect.SetQuality(settings.m_bloom_downsamples, settings.m_blur_iterations);
+
+	for(ParticleNode* node : m_particle_registry.GetNodes())
+	{
+		node->SetDensity(settings.m_particle_density);
+	}
+
+	//The scene keeps the same view and is stretched over the target by the bloom's last pass
+	sf::Vector2u scene_size(static_cast<unsigned int>(m_target.getSize().x * settings.m_render_scale), static_cast<unsigned int>(m_target.getSize().y * settings.m_render_scale));
+	if(m_scene_texture.getSize() != scene_size)
+	{
+		m_scene_texture.create(scene_size.x, scene_size.y);
+		m_scene_texture.setSmooth(settings.m_render_scale < 1.f);
+	}
+}
+
+bool World::UsesBloom() const
+{
+	//CPU bloom is too slow to be on unless asked for, and the lowest quality tier goes without bloom at all
+	return m_quality.GetSettings().m_bloom_downsamples > 0 && (PostEffect::IsSupported() || m_quality.UsesCpuBloom());
+}
+
+void World::EnableStatistics()
+{
+	m_report_statistics = true;
+	std::cout << "World built in " << m_build_time.asMilliseconds() << "ms" << std::endl;
+}
+
+bool World::LogRendering(const std::string& path)
+{
+	m_render_log.open(path.c_str(), std::ios::out | std::ios::trunc);
+	if(!m_render_log)
+	{
+		std::cout << "Could not open " << path << " to log rendering" << std::endl;
+		return false;
+	}
+	return true;
 }
 
 Aircraft* World::GetAircraft(int identifier) const
@@ -120,7 +408,7 @@ void World::RemoveAircraft(int identifier)
 
 Aircraft* World::AddAircraft(int identifier)
 {
-	std::unique_ptr<Aircraft> player(new Aircraft(AircraftType::kEagle, m_textures, m_fonts));
+	std::unique_ptr<Aircraft> player(new Aircraft(AircraftType::kEagle, m_textures, m_fonts, m_particle_registry));
 	player->setPosition(m_camera.getCenter());
 	player->SetIdentifier(identifier);
 
@@ -167,13 +455,13 @@ bool World::HasPlayerReachedEnd() const
 	return false;
 }
 
-void World::LoadTextures()
+void World::LoadTextures(AssetLoader& loader, TextureHolder& textures)
 {
-	m_textures.Load(Textures::kEntities, "Media/Textures/Entities.png");
-	m_textures.Load(Textures::kJungle, "Media/Textures/Jungle.png");
-	m_textures.Load(Textures::kExplosion, "Media/Textures/Explosion.png");
-	m_textures.Load(Textures::kParticle, "Media/Textures/Particle.png");
-	m_textures.Load(Textures::kFinishLine, "Media/Textures/FinishLine.png");
+	loader.LoadTexture(textures, Textures::kEntities, "Media/Textures/Entities.png");
+	loader.LoadTexture(textures, Textures::kJungle, "Media/Textures/Jungle.png");
+	loader.LoadTexture(textures, Textures::kExplosion, "Media/Textures/Explosion.png");
+	loader.LoadTexture(textures, Textures::kParticle, "Media/Textures/Particle.png");
+	loader.LoadTexture(textures, Textures::kFinishLine, "Media/Textures/FinishLine.png");
 }
 
 void World::BuildScene()
@@ -184,6 +472,11 @@ void World::BuildScene()
 		Category::Type category = (i == static_cast<int>(Layers::kLowerAir)) ? Category::Type::kScene : Category::Type::kNone;
 		SceneNode::Ptr layer(new SceneNode(category));
 		m_scene_layers[i] = layer.get();
+		//Aircraft, projectiles and pickups only reach each other through commands
+		if(i == static_cast<int>(Layers::kUpperAir))
+		{
+			layer->SetUpdateJobs(&m_jobs);
+		}
 		m_scenegraph.AttachChild(std::move(layer));
 	}
 
@@ -210,11 +503,13 @@ void World::BuildScene()
 	m_scene_layers[static_cast<int>(Layers::kBackground)]->AttachChild(std::move(finish_sprite));
 
 	// Add particle node to the scene
-	std::unique_ptr<ParticleNode> smokeNode(new ParticleNode(ParticleType::kSmoke, m_textures));
+	std::unique_ptr<ParticleNode> smokeNode(new ParticleNode(ParticleType::kSmoke, m_textures, m_particle_budget));
+	m_particle_registry.Register(*smokeNode);
 	m_scene_layers[static_cast<int>(Layers::kLowerAir)]->AttachChild(std::move(smokeNode));
 
 	// Add propellant particle node to the scene
-	std::unique_ptr<ParticleNode> propellantNode(new ParticleNode(ParticleType::kPropellant, m_textures));
+	std::unique_ptr<ParticleNode> propellantNode(new ParticleNode(ParticleType::kPropellant, m_textures, m_particle_budget));
+	m_particle_registry.Register(*propellantNode);
 	m_scene_layers[static_cast<int>(Layers::kLowerAir)]->AttachChild(std::move(propellantNode));
 
 	// Add sound effect node
@@ -289,7 +584,7 @@ void World::SpawnEnemies()
 	{
 		SpawnPoint spawn = m_enemy_spawn_points.back();
 		std::cout << static_cast<int>(spawn.m_type) << std::endl;
-		std::unique_ptr<Aircraft> enemy(new Aircraft(spawn.m_type, m_textures, m_fonts));
+		std::unique_ptr<Aircraft> enemy(new Aircraft(spawn.m_type, m_textures, m_fonts, m_particle_registry));
 		enemy->setPosition(spawn.m_x, spawn.m_y);
 		enemy->setRotation(180.f);
 		//If the game is networked the server is responsible for spawning pickups
@@ -359,13 +654,14 @@ void World::SortEnemies()
 
 void World::GuideMissiles()
 {
-	// Setup command that stores all enemies in mActiveEnemies
+	// Setup command that stores all enemies in the enemy grid, so each missile only looks at the enemies around it
+	m_enemy_grid.Clear();
 	Command enemyCollector;
 	enemyCollector.category = Category::kEnemyAircraft;
 	enemyCollector.action = DerivedAction<Aircraft>([this](Aircraft& enemy, sf::Time)
 	{
 		if (!enemy.IsDestroyed())
-			m_active_enemies.emplace_back(&enemy);
+			m_enemy_grid.Insert(&enemy, enemy.GetWorldPosition());
 	});
 
 	// Setup command that guides all missiles to the enemy which is currently closest to the player
@@ -377,29 +673,14 @@ void World::GuideMissiles()
 		if (!missile.IsGuided())
 			return;
 
-		float minDistance = std::numeric_limits<float>::max();
-		Aircraft* closestEnemy = nullptr;
-
-		// Find closest enemy
-		for(Aircraft * enemy :  m_active_enemies)
-		{
-			float enemyDistance = Distance(missile, *enemy);
-
-			if (enemyDistance < minDistance)
-			{
-				closestEnemy = enemy;
-				minDistance = enemyDistance;
-			}
-		}
-
-		if (closestEnemy)
+		Aircraft* closestEnemy;
+		if (m_enemy_grid.FindNearest(missile.GetWorldPosition(), closestEnemy))
 			missile.GuideTowards(closestEnemy->GetWorldPosition());
 	});
 
-	// Push commands, reset active enemies
+	// Push commands
 	m_command_queue.Push(enemyCollector);
 	m_command_queue.Push(missileGuider);
-	m_active_enemies.clear();
 }
 
 bool MatchesCategories(SceneNode::Pair& colliders, Category::Type type1, Category::Type type2)
@@ -423,9 +704,8 @@ bool MatchesCategories(SceneNode::Pair& colliders, Category::Type type1, Categor
 
 void World::HandleCollisions()
 {
-	std::set<SceneNode::Pair> collision_pairs;
-	m_scenegraph.CheckSceneCollision(m_scenegraph, collision_pairs);
-	for(SceneNode::Pair pair : collision_pairs)
+	//The pairs were found in RunParallelPhase
+	for(SceneNode::Pair pair : m_collision_pairs)
 	{
 		if(MatchesCategories(pair, Category::Type::kPlayerAircraft, Category::Type::kEnemyAircraft))
 		{
@@ -474,7 +754,7 @@ void World::DestroyEntitiesOutsideView()
 	m_command_queue.Push(command);
 }
 
-void World::UpdateSounds()
+sf::Vector2f World::GetListenerPosition() const
 {
 	sf::Vector2f listener_position;
 
@@ -495,9 +775,5 @@ void World::UpdateSounds()
 		listener_position /= static_cast<float>(m_player_aircraft.size());
 	}
 
-	// Set listener's position
-	m_sounds.SetListenerPosition(listener_position);
-
-	// Remove unused sounds
-	m_sounds.RemoveStoppedSounds();
+	return listener_position;
 }
@@ -8,6 +8,7 @@
 #include "AircraftType.hpp"
 #include "NetworkNode.hpp"
 
+#include <SFML/System/Clock.hpp>
 #include <SFML/System/NonCopyable.hpp>
 #include <SFML/Graphics/View.hpp>
 #include <SFML/Graphics/Texture.hpp>
@@ -15,11 +16,24 @@
 #include <SFML/Graphics/RenderTarget.hpp>
 
 #include <array>
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
 #include <SFML/Graphics/RenderWindow.hpp>
 
 #include "BloomEffect.hpp"
 #include "CommandQueue.hpp"
+#include "CpuBloomEffect.hpp"
+#include "FrameTiming.hpp"
+#include "JobSystem.hpp"
+#include "ParticleBudget.hpp"
+#include "ParticleRegistry.hpp"
+#include "QualityGovernor.hpp"
+#include "RecordingRenderBackend.hpp"
+#include "RenderQueue.hpp"
 #include "SoundPlayer.hpp"
+#include "SpatialGrid.hpp"
 
 #include "NetworkProtocol.hpp"
 #include "PickupType.hpp"
@@ -30,14 +44,26 @@ namespace sf
 	class RenderTarget;
 }
 
+class AssetLoader;
+class ParticleNode;
+
 
 
 class World : private sf::NonCopyable
 {
 public:
-	explicit World(sf::RenderTarget& output_target, FontHolder& font, SoundPlayer& sounds, bool networked=false);
+	//Drawing blends between the last two Updates as timing says, see FrameTiming, and is as detailed as quality says.
+	//Every World draws with the same textures, which LoadTextures has to have filled
+	World(sf::RenderTarget& output_target, FontHolder& font, SoundPlayer& sounds, const FrameTiming& timing, JobSystem& jobs, const QualityGovernor& quality, TextureHolder& textures, bool networked=false);
+	//Queues every texture a World uses on loader, they are uploaded once and shared by all worlds
+	static void LoadTextures(AssetLoader& loader, TextureHolder& textures);
 	void Update(sf::Time dt);
 	void Draw();
+	//Writes the draw calls of the first frame after every step to path, see RecordingRenderBackend::WriteFrame
+	bool LogRendering(const std::string& path);
+	//Prints how long the world took to build, then the update, particle, sound and drawing statistics every few
+	//seconds. Nothing is printed otherwise
+	void EnableStatistics();
 
 	sf::FloatRect GetViewBounds() const;
 	CommandQueue& GetCommandQueue();
@@ -61,7 +87,6 @@ public:
 
 
 private:
-	void LoadTextures();
 	void BuildScene();
 	void AdaptPlayerPosition();
 	void AdaptPlayerVelocity();
@@ -70,9 +95,16 @@ private:
 	void SpawnEnemies();
 	void AddEnemies();
 	void GuideMissiles();
+	void RunParallelPhase(sf::Time dt);
+	void AddEmittedParticles();
+	void FindCollisions(std::size_t chunk, std::size_t chunk_count);
+	void MergeCollisions();
 	void HandleCollisions();
 	void DestroyEntitiesOutsideView();
-	void UpdateSounds();
+	sf::Vector2f GetListenerPosition() const;
+	void ReportStatistics();
+	void ApplyQuality();
+	bool UsesBloom() const;
 
 private:
 	struct SpawnPoint
@@ -85,13 +117,31 @@ private:
 		float m_x;
 		float m_y;
 	};
+
+	//Parts of Update that are timed separately. The jobs of the parallel phase are summed over all threads,
+	//the phase itself is the time the main thread waits for them
+	enum UpdatePhase
+	{
+		kCommandPhase,
+		kColliderPhase,
+		kNarrowPhase,
+		kParticlePhase,
+		kSoundPhase,
+		kParallelPhase,
+		kSimulationPhase,
+		kUpdatePhaseCount
+	};
 	
 
 private:
 	sf::RenderTarget& m_target;
 	sf::RenderTexture m_scene_texture;
 	sf::View m_camera;
-	TextureHolder m_textures;
+	const FrameTiming& m_timing;
+	//A world that was not updated in the last step, e.g. under the pause menu, is drawn as it is
+	sf::Uint64 m_updated_step;
+	sf::Vector2f m_previous_camera_center;
+	TextureHolder& m_textures;
 	FontHolder& m_fonts;
 	SoundPlayer& m_sounds;
 	SceneNode m_scenegraph;
@@ -104,11 +154,42 @@ private:
 	float m_scrollspeed_compensation;
 	std::vector<Aircraft*> m_player_aircraft;
 	std::vector<SpawnPoint> m_enemy_spawn_points;
-	std::vector<Aircraft*>	m_active_enemies;
+	//Live enemies by world position, refilled by the commands GuideMissiles pushes. Only valid until the wrecks
+	//are removed later in the same update
+	SpatialGrid<Aircraft*> m_enemy_grid;
 
 	BloomEffect m_bloom_effect;
+	//Without shaders the bloom is done on the CPU instead
+	CpuBloomEffect m_cpu_bloom_effect;
+	sf::Time m_bloom_time;
 	bool m_networked_world;
 	NetworkNode* m_network_node;
 	SpriteNode* m_finish_sprite;
+
+	JobSystem& m_jobs;
+	ParticleRegistry m_particle_registry;
+	ParticleBudget m_particle_budget;
+	std::vector<SceneNode::Collider> m_colliders;
+	std::vector<std::vector<SceneNode::Pair>> m_collision_chunks;
+	std::set<SceneNode::Pair> m_collision_pairs;
+	std::array<sf::Time, kUpdatePhaseCount> m_update_times;
+	std::size_t m_updates_since_report;
+	SceneNode::DrawCounters m_draw_counters;
+	RenderQueue::Counters m_render_counters;
+	std::size_t m_frames_since_report;
+	sf::Clock m_report_clock;
+	bool m_report_statistics;
+	//How long the constructor took, printed once statistics are enabled
+	sf::Time m_build_time;
+
+	sf::Uint64 m_draw_bounds_step;
+	bool m_has_draw_bounds;
+	RenderQueue m_render_queue;
+	RecordingRenderBackend m_render_recorder;
+	RecordingRenderBackend::FrameStats m_render_stats;
+	std::ofstream m_render_log;
+
+	const QualityGovernor& m_quality;
+	std::size_t m_quality_tier;
 };
 